@@ -0,0 +1,381 @@
+#include "AsyncIO.h"
+#include "Utils.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+// Deeper queues stop paying off long before the kernel limit
+static const unsigned MAX_QUEUE_DEPTH = 4096;
+static std::string ioError(const char* what, int error) {
+    return std::string(what) + ": " + std::strerror(error);
+}
+static unsigned loadAcquire(const unsigned* value) {
+    return __atomic_load_n(value, __ATOMIC_ACQUIRE);
+}
+static void storeRelease(unsigned* value, unsigned newValue) {
+    __atomic_store_n(value, newValue, __ATOMIC_RELEASE);
+}
+// Blocking transfer, for rings without io_uring
+static void transfer(int fd, char* buffer, size_t length, uint64_t offset, bool write) {
+    size_t done = 0;
+    while (done < length) {
+        ssize_t result = write
+            ? ::pwrite(fd, buffer + done, length - done, static_cast<off_t>(offset + done))
+            : ::pread(fd, buffer + done, length - done, static_cast<off_t>(offset + done));
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw DatabaseException(ioError(write ? "Write failed" : "Read failed", errno));
+        }
+        if (result == 0) {
+            throw DatabaseException(write ? "Write made no progress" : "Unexpected end of file");
+        }
+        done += static_cast<size_t>(result);
+    }
+}
+// IoRing
+// ------
+IoRing::IoRing(unsigned queueDepth) : depth(std::min(queueDepth, MAX_QUEUE_DEPTH)) {
+    if (depth == 0) {
+        return;
+    }
+    struct io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    int fd = static_cast<int>(::syscall(__NR_io_uring_setup, depth, &params));
+    if (fd < 0) {
+        return;   // blocking fallback
+    }
+    ringFd = fd;
+
+    sqRingBytes = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqRingBytes = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (singleMap) {
+        sqRingBytes = cqRingBytes = std::max(sqRingBytes, cqRingBytes);
+    }
+    sqRing = ::mmap(nullptr, sqRingBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                    ringFd, IORING_OFF_SQ_RING);
+    if (sqRing == MAP_FAILED) {
+        sqRing = nullptr;
+        unmap();
+        return;
+    }
+    if (singleMap) {
+        cqRing = sqRing;
+    } else {
+        cqRing = ::mmap(nullptr, cqRingBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                        ringFd, IORING_OFF_CQ_RING);
+        if (cqRing == MAP_FAILED) {
+            cqRing = nullptr;
+            unmap();
+            return;
+        }
+    }
+    sqesBytes = params.sq_entries * sizeof(struct io_uring_sqe);
+    sqes = ::mmap(nullptr, sqesBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                  ringFd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        sqes = nullptr;
+        unmap();
+        return;
+    }
+
+    char* sq = static_cast<char*>(sqRing);
+    char* cq = static_cast<char*>(cqRing);
+    sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sqMask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cqMask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes = cq + params.cq_off.cqes;
+    // The kernel rounds the ring up; never queue more than it holds
+    depth = std::min(depth, params.sq_entries);
+}
+IoRing::~IoRing() {
+    if (isAsync()) {
+        try {
+            drain();
+        } catch (const std::exception&) {
+            // The owner has already reported, or is unwinding from, the failure
+        }
+    }
+    unmap();
+}
+void IoRing::unmap() {
+    if (sqes) {
+        ::munmap(sqes, sqesBytes);
+    }
+    if (cqRing && cqRing != sqRing) {
+        ::munmap(cqRing, cqRingBytes);
+    }
+    if (sqRing) {
+        ::munmap(sqRing, sqRingBytes);
+    }
+    sqes = sqRing = cqRing = nullptr;
+    if (ringFd >= 0) {
+        ::close(ringFd);
+        ringFd = -1;
+    }
+}
+void IoRing::submit(Operation& op) {
+    op.completed = false;
+    op.error = 0;
+    op.done = 0;
+    if (!isAsync()) {
+        transfer(op.fd, op.buffer, op.length, op.offset, op.write);
+        op.done = op.length;
+        op.completed = true;
+        return;
+    }
+    if (op.length == 0) {
+        op.completed = true;
+        return;
+    }
+    while (inFlight >= depth) {
+        reap(1);
+    }
+    push(op);
+    inFlight++;
+    enter(1, 0);
+}
+void IoRing::push(Operation& op) {
+    op.vector.iov_base = op.buffer + op.done;
+    op.vector.iov_len = op.length - op.done;
+
+    unsigned tail = *sqTail;
+    unsigned index = tail & *sqMask;
+    auto* sqe = static_cast<struct io_uring_sqe*>(sqes) + index;
+    std::memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = op.write ? IORING_OP_WRITEV : IORING_OP_READV;
+    sqe->fd = op.fd;
+    sqe->addr = reinterpret_cast<uint64_t>(&op.vector);
+    sqe->len = 1;
+    sqe->off = op.offset + op.done;
+    sqe->user_data = reinterpret_cast<uint64_t>(&op);
+    sqArray[index] = index;
+    storeRelease(sqTail, tail + 1);
+}
+void IoRing::enter(unsigned toSubmit, unsigned minComplete) {
+    // The completion ring holds twice the queue depth, so it never overflows
+    unsigned flags = minComplete > 0 ? IORING_ENTER_GETEVENTS : 0;
+    while (true) {
+        long result = ::syscall(__NR_io_uring_enter, ringFd, toSubmit, minComplete, flags, nullptr, 0);
+        if (result >= 0) {
+            toSubmit -= std::min<unsigned>(toSubmit, static_cast<unsigned>(result));
+            if (toSubmit == 0) {
+                return;
+            }
+            continue;
+        }
+        if (errno == EINTR || errno == EAGAIN) {
+            continue;
+        }
+        throw DatabaseException(ioError("io_uring_enter failed", errno));
+    }
+}
+void IoRing::reap(unsigned minComplete) {
+    unsigned reaped = 0;
+    while (true) {
+        unsigned resubmitted = 0;
+        unsigned head = *cqHead;
+        unsigned tail = loadAcquire(cqTail);
+        while (head != tail) {
+            const auto* cqe = static_cast<const struct io_uring_cqe*>(cqes) + (head & *cqMask);
+            auto* op = reinterpret_cast<Operation*>(cqe->user_data);
+            int result = cqe->res;
+            head++;
+
+            if (result == -EAGAIN || result == -EINTR) {
+                push(*op);
+                resubmitted++;
+                continue;
+            }
+            if (result < 0 || (result == 0 && op->length > op->done)) {
+                op->error = result < 0 ? -result : EIO;
+                if (firstError.empty()) {
+                    firstError = result < 0
+                        ? ioError(op->write ? "Write failed" : "Read failed", -result)
+                        : (op->write ? "Write made no progress" : "Unexpected end of file");
+                }
+            } else {
+                op->done += static_cast<size_t>(result);
+                if (op->done < op->length) {
+                    push(*op);   // short transfer
+                    resubmitted++;
+                    continue;
+                }
+            }
+            op->completed = true;
+            inFlight--;
+            reaped++;
+        }
+        storeRelease(cqHead, head);
+        if (resubmitted > 0) {
+            enter(resubmitted, 0);
+        }
+        if (reaped >= minComplete || inFlight == 0) {
+            return;
+        }
+        enter(0, 1);
+    }
+}
+void IoRing::wait(Operation& op) {
+    while (!op.completed && isAsync()) {
+        reap(1);
+    }
+    if (!firstError.empty()) {
+        std::string error;
+        error.swap(firstError);
+        throw DatabaseException(error);
+    }
+}
+void IoRing::drain() {
+    while (inFlight > 0) {
+        reap(1);
+    }
+    if (!firstError.empty()) {
+        std::string error;
+        error.swap(firstError);
+        throw DatabaseException(error);
+    }
+}
+// AsyncFileWriter
+// ---------------
+AsyncFileWriter::AsyncFileWriter(const std::string& path, unsigned queueDepth)
+    : path(path), ring(queueDepth) {
+    fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        throw DatabaseException("Failed to open file for writing: " + path);
+    }
+    pending.reserve(CHUNK_BYTES);
+}
+AsyncFileWriter::~AsyncFileWriter() {
+    if (fd >= 0) {
+        try {
+            ring.drain();
+        } catch (const std::exception&) {
+            // Abandoned file; the error has been reported elsewhere
+        }
+        ::close(fd);
+    }
+}
+void AsyncFileWriter::submitChunk(std::vector<char>&& data, uint64_t offset) {
+    // Recycle chunks that have finished, oldest first
+    while (!chunks.empty() && chunks.front().op.completed) {
+        chunks.pop_front();
+    }
+    chunks.emplace_back();
+    Chunk& chunk = chunks.back();
+    chunk.data = std::move(data);
+    chunk.op.fd = fd;
+    chunk.op.buffer = chunk.data.data();
+    chunk.op.length = chunk.data.size();
+    chunk.op.offset = offset;
+    chunk.op.write = true;
+    ring.submit(chunk.op);
+}
+void AsyncFileWriter::flushPending() {
+    if (pending.empty()) {
+        return;
+    }
+    uint64_t offset = nextOffset;
+    nextOffset += pending.size();
+    submitChunk(std::move(pending), offset);
+    pending = std::vector<char>();
+    pending.reserve(CHUNK_BYTES);
+}
+void AsyncFileWriter::write(const char* data, size_t size) {
+    while (size > 0) {
+        size_t take = std::min(size, CHUNK_BYTES - pending.size());
+        pending.insert(pending.end(), data, data + take);
+        data += take;
+        size -= take;
+        if (pending.size() == CHUNK_BYTES) {
+            flushPending();
+        }
+    }
+}
+void AsyncFileWriter::writeAt(uint64_t offset, const char* data, size_t size) {
+    // Writes in flight together may land in any order, so let earlier ones
+    // that could overlap this range finish first
+    flushPending();
+    ring.drain();
+    submitChunk(std::vector<char>(data, data + size), offset);
+}
+void AsyncFileWriter::close() {
+    if (fd < 0) {
+        return;
+    }
+    try {
+        flushPending();
+        ring.drain();
+    } catch (const DatabaseException& e) {
+        ::close(fd);
+        fd = -1;
+        throw DatabaseException("Failed to write " + path + ": " + e.what());
+    }
+    chunks.clear();
+    int result = ::close(fd);
+    fd = -1;
+    if (result != 0) {
+        throw DatabaseException(ioError(("Failed to close " + path).c_str(), errno));
+    }
+}
+// AsyncFileReader
+// ---------------
+AsyncFileReader::AsyncFileReader(const std::string& path, uint64_t begin, uint64_t end,
+                                 size_t chunkBytes, unsigned queueDepth)
+    : path(path), nextOffset(begin), end(std::max(begin, end)),
+      chunkBytes(std::max<size_t>(chunkBytes, 1)), ring(queueDepth) {
+    fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw DatabaseException("Failed to open file for reading: " + path);
+    }
+    ::posix_fadvise(fd, static_cast<off_t>(begin), static_cast<off_t>(this->end - begin),
+                    POSIX_FADV_SEQUENTIAL);
+}
+AsyncFileReader::~AsyncFileReader() {
+    try {
+        ring.drain();
+    } catch (const std::exception&) {
+        // Reads abandoned after an earlier failure
+    }
+    ::close(fd);
+}
+void AsyncFileReader::readAhead() {
+    // Keep one read queued per slot, but always at least one
+    size_t wanted = std::max<size_t>(1, ring.getQueueDepth());
+    while (chunks.size() < wanted && nextOffset < end) {
+        size_t size = static_cast<size_t>(std::min<uint64_t>(chunkBytes, end - nextOffset));
+        chunks.emplace_back();
+        Chunk& chunk = chunks.back();
+        chunk.data.resize(size);
+        chunk.op.fd = fd;
+        chunk.op.buffer = chunk.data.data();
+        chunk.op.length = size;
+        chunk.op.offset = nextOffset;
+        nextOffset += size;
+        ring.submit(chunk.op);
+    }
+}
+bool AsyncFileReader::next(std::vector<char>& chunk) {
+    try {
+        readAhead();
+        if (chunks.empty()) {
+            return false;
+        }
+        ring.wait(chunks.front().op);
+    } catch (const DatabaseException& e) {
+        throw DatabaseException("Failed to read " + path + ": " + e.what());
+    }
+    chunk.swap(chunks.front().data);
+    chunks.pop_front();
+    readAhead();
+    return true;
+}
@@ -0,0 +1,137 @@
+#ifndef ASYNC_IO_H
+#define ASYNC_IO_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <cstdint>
+#include <sys/uio.h>
+
+// Batched file I/O on a Linux io_uring, driven through the raw system calls.
+// Up to queueDepth reads and writes are in flight at once. When the depth is 0
+// or the kernel refuses io_uring (too old, blocked by seccomp), every
+// operation runs as a blocking pread/pwrite instead.
+//
+// A ring is used by one thread at a time. Buffers of submitted operations
+// must stay alive until they complete; the destructor waits for all of them.
+class IoRing {
+public:
+    struct Operation {
+        int fd = -1;
+        char* buffer = nullptr;
+        size_t length = 0;
+        uint64_t offset = 0;
+        bool write = false;
+        bool completed = false;
+        int error = 0;   // errno of a failed transfer (EIO for end of file)
+
+    private:
+        friend class IoRing;
+        size_t done = 0;
+        struct iovec vector {};
+    };
+
+    explicit IoRing(unsigned queueDepth);
+    ~IoRing();
+
+    IoRing(const IoRing&) = delete;
+    IoRing& operator=(const IoRing&) = delete;
+
+    bool isAsync() const { return ringFd >= 0; }
+    unsigned getQueueDepth() const { return depth; }
+
+    // Starts op, first waiting for a free slot if queueDepth operations are
+    // in flight. Short transfers are resubmitted until complete.
+    void submit(Operation& op);
+    // Waits for op; throws DatabaseException if any reaped operation failed
+    void wait(Operation& op);
+    // Waits for every operation in flight, then reports the first failure
+    void drain();
+
+private:
+    int ringFd = -1;
+    unsigned depth = 0;
+    unsigned inFlight = 0;
+    std::string firstError;   // first failure since the last drain()
+    // Shared ring memory
+    void* sqRing = nullptr;
+    void* cqRing = nullptr;
+    size_t sqRingBytes = 0;
+    size_t cqRingBytes = 0;
+    void* sqes = nullptr;
+    size_t sqesBytes = 0;
+    unsigned* sqTail = nullptr;
+    unsigned* sqMask = nullptr;
+    unsigned* sqArray = nullptr;
+    unsigned* cqHead = nullptr;
+    unsigned* cqTail = nullptr;
+    unsigned* cqMask = nullptr;
+    void* cqes = nullptr;
+
+    void push(Operation& op);
+    void enter(unsigned toSubmit, unsigned minComplete);
+    void reap(unsigned minComplete);
+    void unmap();
+};
+
+// Sequential writer that hands full chunks to an IoRing and keeps filling
+// the next chunk while earlier ones are written
+class AsyncFileWriter {
+public:
+    static const size_t CHUNK_BYTES = 256 * 1024;
+
+    // Creates or truncates path; throws DatabaseException
+    AsyncFileWriter(const std::string& path, unsigned queueDepth);
+    ~AsyncFileWriter();
+
+    void write(const char* data, size_t size);
+    // Writes outside the sequential stream (e.g. a header filled in last),
+    // ordered after everything written before it
+    void writeAt(uint64_t offset, const char* data, size_t size);
+    // Writes everything still buffered and closes the file
+    void close();
+
+private:
+    struct Chunk {
+        std::vector<char> data;
+        IoRing::Operation op;
+    };
+    std::string path;
+    int fd = -1;
+    uint64_t nextOffset = 0;
+    std::vector<char> pending;
+    std::deque<Chunk> chunks;   // submitted, oldest first
+    IoRing ring;                // declared last: drains before chunks are freed
+
+    void submitChunk(std::vector<char>&& data, uint64_t offset);
+    void flushPending();
+};
+
+// Reads a byte range of a file in fixed-size chunks, keeping up to the
+// queue depth of chunks read ahead of the consumer
+class AsyncFileReader {
+public:
+    AsyncFileReader(const std::string& path, uint64_t begin, uint64_t end,
+                    size_t chunkBytes, unsigned queueDepth);
+    ~AsyncFileReader();
+
+    // Swaps the next chunk into chunk; false once the range is exhausted
+    bool next(std::vector<char>& chunk);
+
+private:
+    struct Chunk {
+        std::vector<char> data;
+        IoRing::Operation op;
+    };
+    std::string path;
+    int fd = -1;
+    uint64_t nextOffset;
+    uint64_t end;
+    size_t chunkBytes;
+    std::deque<Chunk> chunks;   // submitted, in file order
+    IoRing ring;                // declared last: drains before chunks are freed
+
+    void readAhead();
+};
+
+#endif // ASYNC_IO_H
@@ -0,0 +1,99 @@
+#include "BloomFilter.h"
+#include "ZoneMap.h"
+#include "Utils.h"
+#include <cmath>
+#include <cstring>
+// Probes per key; optimal for 10 bits per key
+static const uint8_t HASH_COUNT = 7;
+// Keeps number buckets apart from text keys with the same hash
+static const uint64_t NUMBER_SEED = 0x9E3779B97F4A7C15ull;
+// splitmix64 finalizer
+static uint64_t mix(uint64_t value) {
+    value ^= value >> 30;
+    value *= 0xBF58476D1CE4E5B9ull;
+    value ^= value >> 27;
+    value *= 0x94D049BB133111EBull;
+    value ^= value >> 31;
+    return value;
+}
+static uint64_t bucketKey(double bucket) {
+    if (bucket == 0) {
+        bucket = 0; // -0 and 0 share a bucket
+    }
+    uint64_t bitsOfBucket;
+    std::memcpy(&bitsOfBucket, &bucket, sizeof(bitsOfBucket));
+    return mix(bitsOfBucket ^ NUMBER_SEED);
+}
+BloomFilter::BloomFilter(const std::vector<uint64_t>& keyHashes) : hashCount(HASH_COUNT) {
+    size_t words = std::max<size_t>(1, (keyHashes.size() * BITS_PER_KEY + 63) / 64);
+    bits.assign(words, 0);
+    uint64_t bitCount = static_cast<uint64_t>(words) * 64;
+    for (uint64_t hash : keyHashes) {
+        // Double hashing: probe i is h1 + i * h2
+        uint64_t h1 = hash;
+        uint64_t h2 = (hash >> 32) | (hash << 32) | 1;
+        for (uint8_t i = 0; i < hashCount; ++i) {
+            uint64_t bit = (h1 + i * h2) % bitCount;
+            bits[bit / 64] |= uint64_t(1) << (bit % 64);
+        }
+    }
+}
+bool BloomFilter::mayContain(uint64_t keyHash) const {
+    if (bits.empty()) {
+        return true;
+    }
+    uint64_t bitCount = static_cast<uint64_t>(bits.size()) * 64;
+    uint64_t h2 = (keyHash >> 32) | (keyHash << 32) | 1;
+    for (uint8_t i = 0; i < hashCount; ++i) {
+        uint64_t bit = (keyHash + i * h2) % bitCount;
+        if (!(bits[bit / 64] & (uint64_t(1) << (bit % 64)))) {
+            return false;
+        }
+    }
+    return true;
+}
+void BloomFilter::write(ByteWriter& writer) const {
+    writer.putU8(hashCount);
+    writer.putU32(static_cast<uint32_t>(bits.size()));
+    for (uint64_t word : bits) {
+        writer.putU64(word);
+    }
+}
+BloomFilter BloomFilter::read(ByteReader& reader) {
+    BloomFilter filter;
+    filter.hashCount = reader.getU8();
+    uint32_t words = reader.getU32();
+    if (words > reader.remaining() / 8) {
+        throw DatabaseException("Corrupt Bloom filter");
+    }
+    filter.bits.resize(words);
+    for (auto& word : filter.bits) {
+        word = reader.getU64();
+    }
+    return filter;
+}
+uint64_t BloomFilter::textKey(std::string_view text) {
+    // FNV-1a, then mixed so that every bit depends on every byte
+    uint64_t hash = 14695981039346656037ull;
+    for (char ch : text) {
+        hash ^= static_cast<unsigned char>(ch);
+        hash *= 1099511628211ull;
+    }
+    return mix(hash);
+}
+void BloomFilter::cellKeys(std::string_view cell, std::vector<uint64_t>& keys) {
+    keys.push_back(textKey(cell));
+    double number;
+    if (ZoneMaps::parseNumber(cell, number) && !std::isnan(number)) {
+        keys.push_back(bucketKey(std::floor(number)));
+    }
+}
+void BloomFilter::numberKeys(double value, std::vector<uint64_t>& keys) {
+    // Buckets are one wide, so the tolerance band spans at most two of them
+    double low = std::floor(value - 2e-9);
+    double high = std::floor(value + 2e-9);
+    keys.push_back(bucketKey(low));
+    if (high != low) {
+        keys.push_back(bucketKey(high));
+    }
+}
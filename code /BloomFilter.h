@@ -0,0 +1,41 @@
+#ifndef BLOOM_FILTER_H
+#define BLOOM_FILTER_H
+
+#include "PageFormat.h"
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+// Fixed-size Bloom filter over 64-bit key hashes. Hashes are stable across
+// builds, so filters can be stored in table files.
+class BloomFilter {
+public:
+    BloomFilter() = default;
+    // Sized for the given keys at BITS_PER_KEY bits each
+    explicit BloomFilter(const std::vector<uint64_t>& keyHashes);
+
+    bool empty() const { return bits.empty(); }
+    bool mayContain(uint64_t keyHash) const;
+    // Bytes of the bit array
+    size_t memoryBytes() const { return bits.capacity() * sizeof(uint64_t); }
+
+    void write(ByteWriter& writer) const;
+    static BloomFilter read(ByteReader& reader);
+
+    // Keys a cell is filed under: its text, and for cells that parse as a
+    // number also the number's integer bucket, so that both the string
+    // equality of IN and the numeric equality of '=' can be probed
+    static void cellKeys(std::string_view cell, std::vector<uint64_t>& keys);
+    static uint64_t textKey(std::string_view text);
+    // Buckets that may hold a number equal to value within the 1e-9
+    // tolerance of numeric comparisons
+    static void numberKeys(double value, std::vector<uint64_t>& keys);
+
+    static const size_t BITS_PER_KEY = 10;
+
+private:
+    std::vector<uint64_t> bits;
+    uint8_t hashCount = 0;
+};
+
+#endif // BLOOM_FILTER_H
@@ -0,0 +1,337 @@
+#include "BufferPool.h"
+#include "AsyncIO.h"
+#include "Utils.h"
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+BufferPool::BufferPool(size_t capacityBytes) : capacity(capacityBytes) {}
+BufferPool::~BufferPool() {
+    try {
+        flush();
+    } catch (...) {
+        // Destructors must not throw; unwritten pages are lost like on a crash
+    }
+    for (Frame* frame : frames) {
+        delete frame;
+    }
+}
+uint64_t BufferPool::addFile(int fd, const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex);
+    uint64_t fileId = nextFileId++;
+    files[fileId] = FileEntry{fd, path};
+    return fileId;
+}
+void BufferPool::removeFile(uint64_t fileId) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto offsets = lookup.find(fileId);
+    if (offsets != lookup.end()) {
+        for (const auto& entry : offsets->second) {
+            Frame* frame = frames[entry.second];
+            if (frame->pins > 0) {
+                throw DatabaseException("Cannot drop pinned pages of " + files[fileId].path);
+            }
+            if (frame->dirty) {
+                writeBack(frame);
+            }
+        }
+        for (const auto& entry : offsets->second) {
+            dropSlot(entry.second);
+        }
+        lookup.erase(offsets);
+    }
+    files.erase(fileId);
+}
+BufferPool::PageRef BufferPool::fetch(uint64_t fileId, uint64_t offset, size_t length) {
+    std::unique_lock<std::mutex> lock(mutex);
+    auto file = files.find(fileId);
+    if (file == files.end()) {
+        throw DatabaseException("Page requested from a file that is not in the buffer pool");
+    }
+    auto& offsets = lookup[fileId];
+    auto key = std::make_pair(offset, length);
+    
+    auto cached = offsets.find(key);
+    while (cached != offsets.end() && frames[cached->second]->loading) {
+        loaded.wait(lock);
+        cached = offsets.find(key);   // a failed read removes the frame
+    }
+    if (cached != offsets.end()) {
+        Frame* frame = frames[cached->second];
+        frame->pins++;
+        frame->referenced = true;
+        stats.hits++;
+        return PageRef(this, frame);
+    }
+    
+    // Miss: make room, claim a slot, then read without holding the lock
+    evictUntilWithinBudget(length);
+    stats.misses++;
+    Frame* frame = new Frame();
+    frame->fileId = fileId;
+    frame->offset = offset;
+    frame->pins = 1;
+    frame->referenced = true;
+    frame->loading = true;
+    size_t slot;
+    if (!freeSlots.empty()) {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+        frames[slot] = frame;
+    } else {
+        slot = frames.size();
+        frames.push_back(frame);
+    }
+    offsets[key] = slot;
+    stats.usedBytes += length;
+    int fd = file->second.fd;
+    std::string path = file->second.path;
+    lock.unlock();
+    
+    std::string error;
+    try {
+        frame->data.resize(length);
+        size_t done = 0;
+        while (done < length) {
+            ssize_t got = ::pread(fd, frame->data.data() + done, length - done,
+                                  static_cast<off_t>(offset + done));
+            if (got < 0 && errno == EINTR) {
+                continue;
+            }
+            if (got <= 0) {
+                error = got < 0 ? std::strerror(errno) : "unexpected end of file";
+                break;
+            }
+            done += static_cast<size_t>(got);
+        }
+    } catch (const std::bad_alloc&) {
+        error = "out of memory";
+    }
+    
+    lock.lock();
+    frame->loading = false;
+    if (!error.empty()) {
+        lookup[fileId].erase(key);
+        // The bytes were charged before the frame grew, which may have failed
+        stats.usedBytes -= length - frame->data.size();
+        dropSlot(slot);
+        loaded.notify_all();
+        throw DatabaseException("Failed to read page of " + path + ": " + error);
+    }
+    loaded.notify_all();
+    return PageRef(this, frame);
+}
+void BufferPool::prefetch(uint64_t fileId, const std::vector<std::pair<uint64_t, size_t>>& runs) {
+    unsigned depth = prefetchDepth;
+    if (depth == 0 || runs.empty()) {
+        return;
+    }
+    
+    // Claim frames for the missing runs; fetches of them wait until loaded
+    struct Claim {
+        size_t slot;
+        Frame* frame;
+        size_t length;
+        IoRing::Operation read;
+    };
+    std::vector<Claim> claimed;
+    int fd;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto file = files.find(fileId);
+        if (file == files.end()) {
+            return;
+        }
+        fd = file->second.fd;
+        auto& offsets = lookup[fileId];
+        for (const auto& run : runs) {
+            if (offsets.count(run)) {
+                continue;
+            }
+            evictUntilWithinBudget(run.second);
+            if (stats.usedBytes + run.second > capacity) {
+                break;   // read-ahead must not push out pages in use
+            }
+            Frame* frame = new Frame();
+            frame->fileId = fileId;
+            frame->offset = run.first;
+            frame->referenced = true;
+            frame->loading = true;
+            size_t slot;
+            if (!freeSlots.empty()) {
+                slot = freeSlots.back();
+                freeSlots.pop_back();
+                frames[slot] = frame;
+            } else {
+                slot = frames.size();
+                frames.push_back(frame);
+            }
+            offsets[run] = slot;
+            stats.usedBytes += run.second;
+            stats.prefetches++;
+            claimed.push_back(Claim{slot, frame, run.second, {}});
+        }
+    }
+    if (claimed.empty()) {
+        return;
+    }
+    
+    {
+        std::unique_lock<std::mutex> ringLock(ringMutex, std::try_to_lock);
+        std::unique_ptr<IoRing> ownRing;
+        IoRing* active;
+        if (!ringLock) {
+            ownRing = std::make_unique<IoRing>(depth);
+            active = ownRing.get();
+        } else {
+            if (!ring || ringDepth != depth) {
+                ring = std::make_unique<IoRing>(depth);
+                ringDepth = depth;
+            }
+            active = ring.get();
+        }
+        for (auto& claim : claimed) {
+            try {
+                claim.frame->data.resize(claim.length);
+                claim.read.fd = fd;
+                claim.read.buffer = claim.frame->data.data();
+                claim.read.length = claim.length;
+                claim.read.offset = claim.frame->offset;
+                active->submit(claim.read);
+            } catch (const std::exception&) {
+                claim.read.completed = false;
+            }
+        }
+        try {
+            active->drain();
+        } catch (const std::exception&) {
+            // Failed reads are dropped below
+        }
+    }
+    
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto& claim : claimed) {
+        claim.frame->loading = false;
+        if (!claim.read.completed || claim.read.error != 0) {
+            lookup[fileId].erase(std::make_pair(claim.frame->offset, claim.length));
+            stats.usedBytes -= claim.length - claim.frame->data.size();
+            dropSlot(claim.slot);
+        }
+    }
+    loaded.notify_all();
+}
+void BufferPool::flush(uint64_t fileId) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (Frame* frame : frames) {
+        if (frame && frame->dirty && !frame->loading && (fileId == 0 || frame->fileId == fileId)) {
+            writeBack(frame);
+        }
+    }
+}
+void BufferPool::setCapacity(size_t capacityBytes) {
+    std::lock_guard<std::mutex> lock(mutex);
+    capacity = capacityBytes;
+    evictUntilWithinBudget(0);
+}
+size_t BufferPool::getCapacity() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return capacity;
+}
+BufferPool::Stats BufferPool::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+}
+void BufferPool::unpin(Frame* frame) {
+    std::lock_guard<std::mutex> lock(mutex);
+    frame->pins--;
+}
+// Clock sweep making room for incoming bytes: a referenced frame gets a second
+// chance, pinned frames are skipped. When everything is pinned the pool runs
+// over budget until a later fetch finds released pages.
+void BufferPool::evictUntilWithinBudget(size_t incoming) {
+    size_t steps = 0;
+    while (stats.usedBytes + incoming > capacity && !frames.empty() && steps < 2 * frames.size()) {
+        size_t slot = clockHand;
+        clockHand = (clockHand + 1) % frames.size();
+        steps++;
+        
+        Frame* frame = frames[slot];
+        if (!frame || frame->pins > 0 || frame->loading) {
+            continue;
+        }
+        if (frame->referenced) {
+            frame->referenced = false;
+            continue;
+        }
+        if (frame->dirty) {
+            writeBack(frame);
+        }
+        lookup[frame->fileId].erase(std::make_pair(frame->offset, frame->data.size()));
+        dropSlot(slot);
+        stats.evictions++;
+        steps = 0;
+    }
+}
+void BufferPool::dropSlot(size_t slot) {
+    Frame* frame = frames[slot];
+    stats.usedBytes -= frame->data.size();
+    delete frame;
+    frames[slot] = nullptr;
+    freeSlots.push_back(slot);
+}
+// Called with the pool locked; dirty pages are rare enough to write inline
+void BufferPool::writeBack(Frame* frame) {
+    const FileEntry& file = files.at(frame->fileId);
+    size_t done = 0;
+    while (done < frame->data.size()) {
+        ssize_t written = ::pwrite(file.fd, frame->data.data() + done, frame->data.size() - done,
+                                   static_cast<off_t>(frame->offset + done));
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            throw DatabaseException("Failed to write back page of " + file.path + ": " + std::strerror(errno));
+        }
+        done += static_cast<size_t>(written);
+    }
+    frame->dirty = false;
+    stats.writebacks++;
+}
+// PageRef
+// -------
+BufferPool::PageRef::PageRef(PageRef&& other) noexcept : pool(other.pool), frame(other.frame) {
+    other.pool = nullptr;
+    other.frame = nullptr;
+}
+BufferPool::PageRef& BufferPool::PageRef::operator=(PageRef&& other) noexcept {
+    if (this != &other) {
+        release();
+        pool = other.pool;
+        frame = other.frame;
+        other.pool = nullptr;
+        other.frame = nullptr;
+    }
+    return *this;
+}
+BufferPool::PageRef::~PageRef() {
+    release();
+}
+void BufferPool::PageRef::release() {
+    if (frame) {
+        pool->unpin(frame);
+        frame = nullptr;
+        pool = nullptr;
+    }
+}
+const char* BufferPool::PageRef::data() const {
+    return frame->data.data();
+}
+char* BufferPool::PageRef::mutableData() {
+    return frame->data.data();
+}
+size_t BufferPool::PageRef::size() const {
+    return frame->data.size();
+}
+void BufferPool::PageRef::markDirty() {
+    std::lock_guard<std::mutex> lock(pool->mutex);
+    frame->dirty = true;
+}
@@ -0,0 +1,127 @@
+#ifndef BUFFER_POOL_H
+#define BUFFER_POOL_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <map>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <atomic>
+#include <cstdint>
+
+class IoRing;
+
+// Fixed-budget cache of file pages. Callers pin a page run while they use it;
+// unpinned runs are evicted with the clock algorithm when the budget is
+// exceeded, and dirty runs are written back to their file first.
+class BufferPool {
+private:
+    struct Frame;
+
+public:
+    static const size_t DEFAULT_CAPACITY = 256 * 1024 * 1024;
+    
+    explicit BufferPool(size_t capacityBytes = DEFAULT_CAPACITY);
+    ~BufferPool();
+    
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+    
+    // Pinned page run; unpinned when the reference is destroyed or reassigned
+    class PageRef {
+    public:
+        PageRef() = default;
+        PageRef(PageRef&& other) noexcept;
+        PageRef& operator=(PageRef&& other) noexcept;
+        ~PageRef();
+        
+        const char* data() const;
+        char* mutableData();    // caller must also call markDirty()
+        size_t size() const;
+        void markDirty();
+        explicit operator bool() const { return frame != nullptr; }
+        void release();
+        
+    private:
+        friend class BufferPool;
+        PageRef(BufferPool* pool, Frame* frame) : pool(pool), frame(frame) {}
+        BufferPool* pool = nullptr;
+        Frame* frame = nullptr;
+    };
+    
+    // Files are registered by descriptor; the caller keeps the descriptor
+    // open until removeFile() returns
+    uint64_t addFile(int fd, const std::string& path);
+    // Writes back and drops every cached run of the file
+    void removeFile(uint64_t fileId);
+    
+    // Returns the length bytes at offset, reading them on a miss. Runs of
+    // different lengths at the same offset are cached separately.
+    PageRef fetch(uint64_t fileId, uint64_t offset, size_t length);
+    
+    // Starts reading the (offset, length) runs that are not cached yet, up to
+    // the prefetch depth at a time, and returns once they are in the pool.
+    // Runs that do not fit the budget or fail to read are skipped; a later
+    // fetch reports the error.
+    void prefetch(uint64_t fileId, const std::vector<std::pair<uint64_t, size_t>>& runs);
+    // Reads issued together by prefetch (0 disables prefetching)
+    void setPrefetchDepth(unsigned depth) { prefetchDepth = depth; }
+    unsigned getPrefetchDepth() const { return prefetchDepth; }
+    
+    // Writes back all dirty runs of a file (all files when fileId is 0)
+    void flush(uint64_t fileId = 0);
+    
+    void setCapacity(size_t capacityBytes);
+    size_t getCapacity() const;
+    
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+        uint64_t writebacks = 0;
+        uint64_t prefetches = 0;   // runs read ahead of a fetch
+        size_t usedBytes = 0;
+    };
+    Stats getStats() const;
+
+private:
+    struct Frame {
+        uint64_t fileId = 0;
+        uint64_t offset = 0;
+        std::vector<char> data;
+        int pins = 0;
+        bool referenced = false;
+        bool dirty = false;
+        bool loading = false;   // being read; waiters block on 'loaded'
+    };
+    struct FileEntry {
+        int fd;
+        std::string path;
+    };
+    
+    mutable std::mutex mutex;
+    std::condition_variable loaded;
+    size_t capacity;
+    std::vector<Frame*> frames;             // clock ring; null slots are free
+    std::vector<size_t> freeSlots;
+    // file -> (offset, length) -> slot
+    std::unordered_map<uint64_t, std::map<std::pair<uint64_t, size_t>, size_t>> lookup;
+    std::unordered_map<uint64_t, FileEntry> files;
+    uint64_t nextFileId = 1;
+    size_t clockHand = 0;
+    Stats stats;
+    std::atomic<unsigned> prefetchDepth{0};
+    // Ring shared by prefetches; a prefetch finding it busy uses its own
+    std::mutex ringMutex;
+    std::unique_ptr<IoRing> ring;
+    unsigned ringDepth = 0;
+    
+    void unpin(Frame* frame);
+    void evictUntilWithinBudget(size_t incoming);
+    void dropSlot(size_t slot);
+    void writeBack(Frame* frame);
+};
+
+#endif // BUFFER_POOL_H
@@ -0,0 +1,423 @@
+#include "ColumnEncoding.h"
+#include "Utils.h"
+#include "TypedValue.h"
+#include <algorithm>
+#include <charconv>
+// Dictionaries live in the file header, so they are kept small
+static const size_t MAX_DICTIONARY_ENTRIES = 4096;
+static const size_t MAX_DICTIONARY_BYTES = 256 * 1024;
+// Bit packing (least significant bit first)
+// -----------------------------------------
+static uint8_t bitsFor(uint64_t range) {
+    return range == 0 ? 0 : static_cast<uint8_t>(64 - __builtin_clzll(range));
+}
+static size_t packedBytes(size_t count, uint8_t bits) {
+    return (count * bits + 7) / 8;
+}
+static void packBits(ByteWriter& writer, const std::vector<uint64_t>& values, uint8_t bits) {
+    uint64_t buffer = 0;
+    int buffered = 0;
+    for (uint64_t value : values) {
+        int remaining = bits;
+        while (remaining > 0) {
+            int take = std::min(remaining, 64 - buffered);
+            uint64_t part = take == 64 ? value : (value & ((uint64_t(1) << take) - 1));
+            buffer |= part << buffered;
+            value = take == 64 ? 0 : value >> take;
+            buffered += take;
+            remaining -= take;
+            while (buffered >= 8) {
+                writer.putU8(static_cast<uint8_t>(buffer & 0xFF));
+                buffer >>= 8;
+                buffered -= 8;
+            }
+        }
+    }
+    if (buffered > 0) {
+        writer.putU8(static_cast<uint8_t>(buffer & 0xFF));
+    }
+}
+static uint64_t unpackBits(const char* data, size_t index, uint8_t bits) {
+    uint64_t value = 0;
+    size_t bitPos = index * bits;
+    int got = 0;
+    while (got < bits) {
+        int offset = static_cast<int>(bitPos & 7);
+        int take = std::min(8 - offset, bits - got);
+        uint64_t part = (static_cast<unsigned char>(data[bitPos >> 3]) >> offset) & ((1u << take) - 1);
+        value |= part << got;
+        got += take;
+        bitPos += take;
+    }
+    return value;
+}
+// ColumnCodec
+// -----------
+std::string ColumnCodec::encodingName(ColumnEncoding encoding) {
+    switch (encoding) {
+        case ColumnEncoding::PLAIN: return "PLAIN";
+        case ColumnEncoding::DICTIONARY: return "DICTIONARY";
+        case ColumnEncoding::RUN_LENGTH: return "RLE";
+        case ColumnEncoding::FRAME_OF_REFERENCE: return "FOR";
+    }
+    return "UNKNOWN";
+}
+void ColumnCodecs::write(ByteWriter& writer, const std::vector<ColumnCodec>& codecs) {
+    writer.putU32(static_cast<uint32_t>(codecs.size()));
+    for (const auto& codec : codecs) {
+        writer.putU8(static_cast<uint8_t>(codec.encoding));
+        writer.putU8(static_cast<uint8_t>(codec.form));
+        writer.putU8(codec.codeBits);
+        writer.putU32(static_cast<uint32_t>(codec.dictionary.size()));
+        for (const auto& value : codec.dictionary) {
+            writer.putString(value);
+        }
+    }
+}
+std::vector<ColumnCodec> ColumnCodecs::read(ByteReader& reader) {
+    std::vector<ColumnCodec> codecs(reader.getU32());
+    for (auto& codec : codecs) {
+        uint8_t encoding = reader.getU8();
+        uint8_t form = reader.getU8();
+        if (encoding > static_cast<uint8_t>(ColumnEncoding::FRAME_OF_REFERENCE) ||
+            form > static_cast<uint8_t>(NumericForm::DATE)) {
+            throw DatabaseException("Unknown column encoding in table file");
+        }
+        codec.encoding = static_cast<ColumnEncoding>(encoding);
+        codec.form = static_cast<NumericForm>(form);
+        codec.codeBits = reader.getU8();
+        uint32_t entries = reader.getU32();
+        for (uint32_t i = 0; i < entries; ++i) {
+            codec.dictionary.push_back(reader.getString());
+        }
+        if (codec.codeBits > 32) {
+            throw DatabaseException("Corrupt column dictionary");
+        }
+    }
+    return codecs;
+}
+bool ColumnCodecs::toNumber(std::string_view value, NumericForm form, int64_t& number) {
+    if (form == NumericForm::INTEGER) {
+        const char* end = value.data() + value.size();
+        auto result = std::from_chars(value.data(), end, number);
+        if (result.ec != std::errc() || result.ptr != end) {
+            return false;
+        }
+        // Only canonical spellings survive the round trip ("007" does not)
+        return std::to_string(number) == value;
+    }
+    
+    int32_t days;
+    if (!TypedValues::parseDate(value, days)) {
+        return false;
+    }
+    number = days;
+    return true;
+}
+std::string ColumnCodecs::fromNumber(int64_t number, NumericForm form) {
+    if (form == NumericForm::INTEGER) {
+        return std::to_string(number);
+    }
+    return TypedValues::formatDate(static_cast<int32_t>(number));
+}
+// EncodingPlanner
+// ---------------
+EncodingPlanner::EncodingPlanner(const std::vector<std::string>& columnTypes) : stats(columnTypes.size()) {
+    for (size_t i = 0; i < columnTypes.size(); ++i) {
+        std::string type = toUpperCase(columnTypes[i]);
+        if (type == "DATE") {
+            stats[i].numericType = true;
+            stats[i].form = NumericForm::DATE;
+        } else if (type.rfind("INT", 0) == 0 || type == "BIGINT" || type == "SMALLINT") {
+            stats[i].numericType = true;
+        }
+    }
+}
+void EncodingPlanner::addRow(const RowView& row) {
+    if (row.size() != stats.size()) {
+        usable = false;
+    }
+    if (!usable) {
+        return;
+    }
+    
+    for (size_t c = 0; c < stats.size(); ++c) {
+        ColumnStats& column = stats[c];
+        std::string_view value = row[c];
+        column.plainBytes += 4 + value.size();
+        
+        if (rowCount == 0 || value != column.previous) {
+            column.runs++;
+            column.runValueBytes += value.size();
+            column.previous.assign(value);
+        }
+        
+        if (!column.tooManyDistinct) {
+            column.distinct.emplace(std::string(value), 0);
+            if (column.distinct.size() > MAX_DICTIONARY_ENTRIES) {
+                column.tooManyDistinct = true;
+                column.distinct.clear();
+            }
+        }
+        
+        int64_t number;
+        if (column.numericType && column.allNumeric) {
+            if (ColumnCodecs::toNumber(value, column.form, number)) {
+                column.minimum = rowCount == 0 ? number : std::min(column.minimum, number);
+                column.maximum = rowCount == 0 ? number : std::max(column.maximum, number);
+            } else {
+                column.allNumeric = false;
+            }
+        }
+    }
+    rowCount++;
+}
+std::vector<ColumnCodec> EncodingPlanner::choose() const {
+    std::vector<ColumnCodec> codecs(stats.size());
+    if (rowCount == 0) {
+        return codecs;
+    }
+    
+    for (size_t c = 0; c < stats.size(); ++c) {
+        const ColumnStats& column = stats[c];
+        ColumnCodec& codec = codecs[c];
+        uint64_t best = column.plainBytes;
+        
+        uint64_t runLength = column.runs * 8 + column.runValueBytes;
+        if (runLength < best) {
+            best = runLength;
+            codec.encoding = ColumnEncoding::RUN_LENGTH;
+        }
+        
+        if (!column.tooManyDistinct) {
+            uint64_t dictionaryBytes = 0;
+            for (const auto& entry : column.distinct) {
+                dictionaryBytes += 4 + entry.first.size();
+            }
+            uint8_t bits = bitsFor(column.distinct.size() - 1);
+            uint64_t size = dictionaryBytes + packedBytes(rowCount, bits);
+            if (dictionaryBytes <= MAX_DICTIONARY_BYTES && size < best) {
+                best = size;
+                codec.encoding = ColumnEncoding::DICTIONARY;
+                codec.codeBits = bits;
+            }
+        }
+        
+        if (column.numericType && column.allNumeric) {
+            uint64_t range = static_cast<uint64_t>(column.maximum) - static_cast<uint64_t>(column.minimum);
+            uint64_t size = packedBytes(rowCount, bitsFor(range));
+            if (size < best) {
+                best = size;
+                codec.encoding = ColumnEncoding::FRAME_OF_REFERENCE;
+                codec.form = column.form;
+            }
+        }
+        
+        if (codec.encoding == ColumnEncoding::DICTIONARY) {
+            for (const auto& entry : column.distinct) {
+                codec.dictionary.push_back(entry.first);
+            }
+            std::sort(codec.dictionary.begin(), codec.dictionary.end());
+            for (size_t i = 0; i < codec.dictionary.size(); ++i) {
+                codec.codes[codec.dictionary[i]] = static_cast<uint32_t>(i);
+            }
+        }
+    }
+    return codecs;
+}
+// PageEncoder
+// -----------
+PageEncoder::PageEncoder(const std::vector<ColumnCodec>& codecs) : codecs(codecs), columns(codecs.size()) {}
+size_t PageEncoder::chunkSize(size_t column, const ColumnState& state, uint32_t rowsInPage) const {
+    const ColumnCodec& codec = codecs[column];
+    switch (codec.encoding) {
+        case ColumnEncoding::PLAIN:
+            return state.plainBytes;
+        case ColumnEncoding::DICTIONARY:
+            return packedBytes(rowsInPage, codec.codeBits);
+        case ColumnEncoding::RUN_LENGTH:
+            return 4 + state.runBytes;
+        case ColumnEncoding::FRAME_OF_REFERENCE: {
+            uint64_t range = static_cast<uint64_t>(state.maximum) - static_cast<uint64_t>(state.minimum);
+            return 8 + 1 + packedBytes(rowsInPage, bitsFor(range));
+        }
+    }
+    return 0;
+}
+size_t PageEncoder::sizeWithRow(const RowView& row) const {
+    size_t size = 0;
+    for (size_t c = 0; c < columns.size(); ++c) {
+        ColumnState next;
+        const ColumnState& current = columns[c];
+        std::string_view value = row[c];
+        next.plainBytes = current.plainBytes + 4 + value.size();
+        next.runBytes = current.runBytes;
+        if (rows == 0 || value != current.values.back()) {
+            next.runBytes += 8 + value.size();
+        }
+        if (codecs[c].encoding == ColumnEncoding::FRAME_OF_REFERENCE) {
+            int64_t number;
+            if (!ColumnCodecs::toNumber(value, codecs[c].form, number)) {
+                throw DatabaseException("Value '" + std::string(value) + "' does not fit its column encoding");
+            }
+            next.minimum = rows == 0 ? number : std::min(current.minimum, number);
+            next.maximum = rows == 0 ? number : std::max(current.maximum, number);
+        }
+        size += 4 + chunkSize(c, next, rows + 1);
+    }
+    return size;
+}
+void PageEncoder::addRow(const RowView& row) {
+    for (size_t c = 0; c < columns.size(); ++c) {
+        ColumnState& column = columns[c];
+        std::string_view value = row[c];
+        column.plainBytes += 4 + value.size();
+        if (rows == 0 || value != column.values.back()) {
+            column.runBytes += 8 + value.size();
+        }
+        if (codecs[c].encoding == ColumnEncoding::FRAME_OF_REFERENCE) {
+            int64_t number = 0;
+            ColumnCodecs::toNumber(value, codecs[c].form, number);
+            column.minimum = rows == 0 ? number : std::min(column.minimum, number);
+            column.maximum = rows == 0 ? number : std::max(column.maximum, number);
+        }
+        column.values.emplace_back(value);
+    }
+    rows++;
+}
+void PageEncoder::finish(std::vector<char>& payload) {
+    payload.clear();
+    ByteWriter writer(payload);
+    std::vector<char> chunk;
+    std::vector<uint64_t> packed;
+    
+    for (size_t c = 0; c < columns.size(); ++c) {
+        const ColumnCodec& codec = codecs[c];
+        ColumnState& column = columns[c];
+        chunk.clear();
+        ByteWriter chunkWriter(chunk);
+        packed.clear();
+        
+        switch (codec.encoding) {
+            case ColumnEncoding::PLAIN:
+                for (const auto& value : column.values) {
+                    chunkWriter.putString(value);
+                }
+                break;
+            case ColumnEncoding::DICTIONARY:
+                for (const auto& value : column.values) {
+                    auto code = codec.codes.find(value);
+                    if (code == codec.codes.end()) {
+                        throw DatabaseException("Value '" + value + "' is missing from the column dictionary");
+                    }
+                    packed.push_back(code->second);
+                }
+                packBits(chunkWriter, packed, codec.codeBits);
+                break;
+            case ColumnEncoding::RUN_LENGTH: {
+                std::vector<std::pair<uint32_t, size_t>> runs;   // length, index of value
+                for (size_t i = 0; i < column.values.size(); ++i) {
+                    if (i == 0 || column.values[i] != column.values[i - 1]) {
+                        runs.emplace_back(0, i);
+                    }
+                    runs.back().first++;
+                }
+                chunkWriter.putU32(static_cast<uint32_t>(runs.size()));
+                for (const auto& run : runs) {
+                    chunkWriter.putU32(run.first);
+                    chunkWriter.putString(column.values[run.second]);
+                }
+                break;
+            }
+            case ColumnEncoding::FRAME_OF_REFERENCE: {
+                uint64_t base = static_cast<uint64_t>(column.minimum);
+                for (const auto& value : column.values) {
+                    int64_t number = 0;
+                    ColumnCodecs::toNumber(value, codec.form, number);
+                    packed.push_back(static_cast<uint64_t>(number) - base);
+                }
+                uint8_t bits = bitsFor(static_cast<uint64_t>(column.maximum) - base);
+                chunkWriter.putU64(base);
+                chunkWriter.putU8(bits);
+                packBits(chunkWriter, packed, bits);
+                break;
+            }
+        }
+        
+        writer.putU32(static_cast<uint32_t>(chunk.size()));
+        writer.putBytes(chunk.data(), chunk.size());
+        column = ColumnState();
+    }
+    rows = 0;
+}
+// PageDecoder
+// -----------
+void PageDecoder::decode(const char* payload, size_t bytes, uint32_t rowCount,
+                         const std::vector<ColumnCodec>& codecs) {
+    ByteReader reader(payload, bytes);
+    cells.resize(codecs.size());
+    formatted.resize(codecs.size());
+    
+    for (size_t c = 0; c < codecs.size(); ++c) {
+        const ColumnCodec& codec = codecs[c];
+        uint32_t chunkBytes = reader.getU32();
+        ByteReader chunk(reader.getBytes(chunkBytes), chunkBytes);
+        auto& values = cells[c];
+        values.clear();
+        values.reserve(rowCount);
+        
+        switch (codec.encoding) {
+            case ColumnEncoding::PLAIN:
+                for (uint32_t r = 0; r < rowCount; ++r) {
+                    values.push_back(chunk.getStringView());
+                }
+                break;
+            case ColumnEncoding::DICTIONARY: {
+                const char* codes = chunk.getBytes(packedBytes(rowCount, codec.codeBits));
+                for (uint32_t r = 0; r < rowCount; ++r) {
+                    uint64_t code = unpackBits(codes, r, codec.codeBits);
+                    if (code >= codec.dictionary.size()) {
+                        throw DatabaseException("Dictionary code out of range");
+                    }
+                    values.push_back(codec.dictionary[code]);
+                }
+                break;
+            }
+            case ColumnEncoding::RUN_LENGTH: {
+                uint32_t runs = chunk.getU32();
+                for (uint32_t i = 0; i < runs; ++i) {
+                    uint32_t length = chunk.getU32();
+                    std::string_view value = chunk.getStringView();
+                    if (length > rowCount - values.size()) {
+                        throw DatabaseException("Run exceeds page row count");
+                    }
+                    values.insert(values.end(), length, value);
+                }
+                break;
+            }
+            case ColumnEncoding::FRAME_OF_REFERENCE: {
+                uint64_t base = chunk.getU64();
+                uint8_t bits = chunk.getU8();
+                if (bits > 64) {
+                    throw DatabaseException("Corrupt frame-of-reference chunk");
+                }
+                const char* packed = chunk.getBytes(packedBytes(rowCount, bits));
+                auto& text = formatted[c];
+                text.resize(rowCount);
+                for (uint32_t r = 0; r < rowCount; ++r) {
+                    uint64_t number = base + unpackBits(packed, r, bits);
+                    text[r] = ColumnCodecs::fromNumber(static_cast<int64_t>(number), codec.form);
+                }
+                // Views are taken only once the strings stop moving
+                for (uint32_t r = 0; r < rowCount; ++r) {
+                    values.push_back(text[r]);
+                }
+                break;
+            }
+        }
+        
+        if (values.size() != rowCount) {
+            throw DatabaseException("Column chunk holds the wrong number of values");
+        }
+    }
+}
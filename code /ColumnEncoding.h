@@ -0,0 +1,114 @@
+#ifndef COLUMN_ENCODING_H
+#define COLUMN_ENCODING_H
+
+#include "PageFormat.h"
+#include "ConditionParser.h"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+// Column encodings of columnar table files (PageFormat version 2)
+enum class ColumnEncoding : uint8_t {
+    PLAIN = 0,               // length-prefixed values
+    DICTIONARY = 1,          // bit-packed codes into a per-file dictionary
+    RUN_LENGTH = 2,          // (run length, value) pairs
+    FRAME_OF_REFERENCE = 3   // bit-packed offsets from the page minimum
+};
+
+// How FRAME_OF_REFERENCE values map to and from integers
+enum class NumericForm : uint8_t {
+    INTEGER = 0,   // canonical decimal int64
+    DATE = 1       // YYYY-MM-DD as days since 1970-01-01
+};
+
+// Encoding of one column for a whole file; recorded in the file header
+struct ColumnCodec {
+    ColumnEncoding encoding = ColumnEncoding::PLAIN;
+    NumericForm form = NumericForm::INTEGER;
+    std::vector<std::string> dictionary;
+    uint8_t codeBits = 0;                              // DICTIONARY code width
+    std::unordered_map<std::string, uint32_t> codes;   // writer side only
+    
+    static std::string encodingName(ColumnEncoding encoding);
+};
+
+namespace ColumnCodecs {
+    // Header block holding the codec of every column
+    void write(ByteWriter& writer, const std::vector<ColumnCodec>& codecs);
+    std::vector<ColumnCodec> read(ByteReader& reader);
+    
+    // Exact round-trip conversions used by FRAME_OF_REFERENCE
+    bool toNumber(std::string_view value, NumericForm form, int64_t& number);
+    std::string fromNumber(int64_t number, NumericForm form);
+}
+
+// Gathers statistics over every row of a table and picks, per column, the
+// encoding with the smallest estimated size
+class EncodingPlanner {
+public:
+    explicit EncodingPlanner(const std::vector<std::string>& columnTypes);
+    void addRow(const RowView& row);
+    // False when rows of different widths rule out columnar pages
+    bool isUsable() const { return usable; }
+    std::vector<ColumnCodec> choose() const;
+
+private:
+    struct ColumnStats {
+        bool numericType = false;
+        NumericForm form = NumericForm::INTEGER;
+        bool allNumeric = true;
+        int64_t minimum = 0;
+        int64_t maximum = 0;
+        uint64_t plainBytes = 0;
+        uint64_t runs = 0;
+        uint64_t runValueBytes = 0;
+        std::string previous;
+        std::unordered_map<std::string, uint32_t> distinct;   // cleared once too many
+        bool tooManyDistinct = false;
+    };
+    std::vector<ColumnStats> stats;
+    uint64_t rowCount = 0;
+    bool usable = true;
+};
+
+// Builds the payload of one columnar data page
+class PageEncoder {
+public:
+    explicit PageEncoder(const std::vector<ColumnCodec>& codecs);
+    // Payload size if row were added to the page
+    size_t sizeWithRow(const RowView& row) const;
+    void addRow(const RowView& row);
+    uint32_t rowCount() const { return rows; }
+    // Writes the payload and starts a new page
+    void finish(std::vector<char>& payload);
+
+private:
+    struct ColumnState {
+        std::vector<std::string> values;
+        size_t plainBytes = 0;
+        size_t runBytes = 0;
+        int64_t minimum = 0;
+        int64_t maximum = 0;
+    };
+    const std::vector<ColumnCodec>& codecs;
+    std::vector<ColumnState> columns;
+    uint32_t rows = 0;
+    
+    size_t chunkSize(size_t column, const ColumnState& state, uint32_t rowsInPage) const;
+};
+
+// Decodes a columnar data page; views stay valid until the next decode()
+class PageDecoder {
+public:
+    void decode(const char* payload, size_t bytes, uint32_t rowCount,
+                const std::vector<ColumnCodec>& codecs);
+    std::string_view cell(size_t column, size_t row) const { return cells[column][row]; }
+
+private:
+    std::vector<std::vector<std::string_view>> cells;
+    std::vector<std::vector<std::string>> formatted;   // FRAME_OF_REFERENCE text
+};
+
+#endif // COLUMN_ENCODING_H
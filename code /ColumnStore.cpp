@@ -0,0 +1,622 @@
+#include "ColumnStore.h"
+#include "ColumnEncoding.h"
+#include "ZoneMap.h"
+#include "TypedValue.h"
+#include "Utils.h"
+#include <charconv>
+#include <cstring>
+// A TEXT column whose dictionary grows past this many entries, with more than
+// every second value distinct, stores plain bytes instead
+static const size_t MAX_DICTIONARY_ENTRIES = 4096;
+// Reals are kept when std::to_string would print them back as given
+static bool toReal(std::string_view cell, double& value) {
+    const char* end = cell.data() + cell.size();
+    auto parsed = std::from_chars(cell.data(), end, value);
+    if (parsed.ec != std::errc() || parsed.ptr != end) {
+        return false;
+    }
+    char buffer[ColumnStore::CELL_BUFFER_BYTES];
+    auto printed = std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::fixed, 6);
+    return printed.ec == std::errc() && std::string_view(buffer, printed.ptr - buffer) == cell;
+}
+// Larger DECIMAL magnitudes would not divide into the double std::stod reads
+static const int64_t MAX_EXACT_DECIMAL = int64_t(1) << 53;
+static bool toDecimal(std::string_view cell, int scale, int64_t& value) {
+    return TypedValues::parseDecimal(cell, scale, value) && value < MAX_EXACT_DECIMAL &&
+           value > -MAX_EXACT_DECIMAL && TypedValues::formatDecimal(value, scale) == cell;
+}
+static std::string_view copyCell(const std::string& text, char* buffer) {
+    size_t length = std::min(text.size(), ColumnStore::CELL_BUFFER_BYTES);
+    std::memcpy(buffer, text.data(), length);
+    return std::string_view(buffer, length);
+}
+static std::string_view columnCell(const ColumnStore::Column& column, size_t row, char* buffer) {
+    if (column.isNull(row)) {
+        return {};
+    }
+    switch (column.kind) {
+        case ColumnStore::Kind::INTEGER: {
+            auto printed = std::to_chars(buffer, buffer + ColumnStore::CELL_BUFFER_BYTES, column.integers[row]);
+            return std::string_view(buffer, printed.ptr - buffer);
+        }
+        case ColumnStore::Kind::REAL: {
+            auto printed = std::to_chars(buffer, buffer + ColumnStore::CELL_BUFFER_BYTES, column.reals[row],
+                                         std::chars_format::fixed, 6);
+            return std::string_view(buffer, printed.ptr - buffer);
+        }
+        case ColumnStore::Kind::DECIMAL:
+            return copyCell(TypedValues::formatDecimal(column.integers[row], column.scale), buffer);
+        case ColumnStore::Kind::DATE:
+            return copyCell(TypedValues::formatDate(column.days[row]), buffer);
+        case ColumnStore::Kind::TIME:
+            return copyCell(TypedValues::formatTime(column.integers[row]), buffer);
+        case ColumnStore::Kind::TIMESTAMP:
+            return copyCell(TypedValues::formatTimestamp(column.integers[row]), buffer);
+        case ColumnStore::Kind::BOOLEAN:
+            return TypedValues::formatBoolean(column.flag(row));
+        case ColumnStore::Kind::TEXT:
+            return column.dictionary[column.codes[row]];
+        case ColumnStore::Kind::PLAIN: {
+            uint64_t begin = row == 0 ? 0 : column.offsets[row - 1];
+            return std::string_view(column.bytes).substr(begin, column.offsets[row] - begin);
+        }
+    }
+    return {};
+}
+// ColumnStore
+// -----------
+ColumnStore::ColumnStore(const std::vector<std::string>& columnTypes) : columns(columnTypes.size()) {
+    for (size_t i = 0; i < columnTypes.size(); ++i) {
+        Column& column = columns[i];
+        std::string type = toUpperCase(columnTypes[i]);
+        if (type.rfind("INT", 0) == 0 || type == "BIGINT" || type == "SMALLINT") {
+            column.kind = Kind::INTEGER;
+            continue;
+        }
+        DataType dataType = getDataType(type);
+        auto params = extractTypeParameters(type);
+        if (dataType == DataType::NUMERIC && params.first > 0 &&
+            params.first <= TypedValues::MAX_DECIMAL_DIGITS && params.second <= params.first) {
+            column.kind = Kind::DECIMAL;
+            column.scale = params.second;
+            for (int d = 0; d < column.scale; ++d) {
+                column.divisor *= 10;
+            }
+        } else if (dataType == DataType::NUMERIC || dataType == DataType::REAL ||
+                   dataType == DataType::DOUBLE_PRECISION || dataType == DataType::FLOAT) {
+            column.kind = Kind::REAL;
+        } else if (dataType == DataType::DATE) {
+            column.kind = Kind::DATE;
+        } else if (dataType == DataType::TIME) {
+            column.kind = Kind::TIME;
+        } else if (dataType == DataType::TIMESTAMP) {
+            column.kind = Kind::TIMESTAMP;
+        } else if (dataType == DataType::BOOLEAN) {
+            column.kind = Kind::BOOLEAN;
+        }
+    }
+}
+void ColumnStore::append(const RowView& row) {
+    for (size_t c = 0; c < columns.size(); ++c) {
+        appendCell(columns[c], row[c]);
+    }
+    rowCount++;
+}
+void ColumnStore::appendCell(Column& column, std::string_view cell) {
+    uint64_t bit = uint64_t(1) << (rowCount & 63);
+    if ((rowCount & 63) == 0) {
+        column.nulls.push_back(0);
+    }
+    if (cell.empty()) {
+        column.nulls.back() |= bit;
+    }
+
+    int64_t value = 0;
+    switch (column.kind) {
+        case Kind::INTEGER:
+            if (cell.empty() || ColumnCodecs::toNumber(cell, NumericForm::INTEGER, value)) {
+                column.integers.push_back(value);
+                return;
+            }
+            break;
+        case Kind::REAL: {
+            double real = 0;
+            if (cell.empty() || toReal(cell, real)) {
+                column.reals.push_back(real);
+                return;
+            }
+            break;
+        }
+        case Kind::DECIMAL:
+            if (cell.empty() || toDecimal(cell, column.scale, value)) {
+                column.integers.push_back(value);
+                return;
+            }
+            break;
+        case Kind::DATE:
+        case Kind::TIME:
+        case Kind::TIMESTAMP:
+            if (cell.empty() || parseInstant(column, cell, value)) {
+                if (column.kind == Kind::DATE) {
+                    column.days.push_back(static_cast<int32_t>(value));
+                } else {
+                    column.integers.push_back(value);
+                }
+                return;
+            }
+            break;
+        case Kind::BOOLEAN:
+            if ((rowCount & 63) == 0) {
+                column.flags.push_back(0);
+            }
+            if (cell.empty() || cell == "TRUE" || cell == "FALSE") {
+                if (cell == "TRUE") {
+                    column.flags.back() |= bit;
+                }
+                return;
+            }
+            break;
+        case Kind::TEXT:
+        case Kind::PLAIN:
+            appendText(column, cell);
+            return;
+    }
+    demote(column, Kind::TEXT, rowCount);
+    appendText(column, cell);
+}
+void ColumnStore::appendText(Column& column, std::string_view cell) {
+    if (column.kind == Kind::PLAIN) {
+        column.bytes.append(cell);
+        column.offsets.push_back(column.bytes.size());
+        return;
+    }
+
+    // NULL cells keep code 0 without adding a dictionary entry
+    uint32_t code = 0;
+    if (!cell.empty()) {
+        std::string value(cell);
+        auto it = column.lookup.find(value);
+        if (it == column.lookup.end()) {
+            code = static_cast<uint32_t>(column.dictionary.size());
+            column.dictionary.push_back(value);
+            column.lookup.emplace(std::move(value), code);
+        } else {
+            code = it->second;
+        }
+    }
+    column.codes.push_back(code);
+    if (column.dictionary.size() > MAX_DICTIONARY_ENTRIES && column.dictionary.size() * 2 > column.codes.size()) {
+        demote(column, Kind::PLAIN, column.codes.size());
+    }
+}
+void ColumnStore::demote(Column& column, Kind kind, size_t count) {
+    std::vector<std::string> texts;
+    texts.reserve(count);
+    char buffer[CELL_BUFFER_BYTES];
+    for (size_t r = 0; r < count; ++r) {
+        texts.emplace_back(columnCell(column, r, buffer));
+    }
+
+    column.integers = {};
+    column.reals = {};
+    column.days = {};
+    column.flags = {};
+    column.codes = {};
+    column.dictionary = {};
+    column.lookup = {};
+    column.bytes.clear();
+    column.offsets = {};
+    column.kind = kind;
+    for (const auto& text : texts) {
+        appendText(column, text);
+    }
+}
+void ColumnStore::retain(const std::vector<uint8_t>& keep) {
+    size_t kept = 0;
+    for (size_t r = 0; r < rowCount; ++r) {
+        kept += keep[r] ? 1 : 0;
+    }
+
+    for (auto& column : columns) {
+        std::vector<uint64_t> nulls((kept + 63) / 64, 0);
+        std::vector<uint64_t> flags(column.kind == Kind::BOOLEAN ? nulls.size() : 0, 0);
+        std::string bytes;
+        uint64_t begin = 0;   // PLAIN offset of row r before compaction
+        size_t out = 0;
+        for (size_t r = 0; r < rowCount; ++r) {
+            uint64_t end = column.kind == Kind::PLAIN ? column.offsets[r] : 0;
+            if (!keep[r]) {
+                begin = end;
+                continue;
+            }
+            if (column.isNull(r)) {
+                nulls[out >> 6] |= uint64_t(1) << (out & 63);
+            }
+            switch (column.kind) {
+                case Kind::INTEGER:
+                case Kind::DECIMAL:
+                case Kind::TIME:
+                case Kind::TIMESTAMP: column.integers[out] = column.integers[r]; break;
+                case Kind::REAL: column.reals[out] = column.reals[r]; break;
+                case Kind::DATE: column.days[out] = column.days[r]; break;
+                case Kind::BOOLEAN:
+                    if (column.flag(r)) {
+                        flags[out >> 6] |= uint64_t(1) << (out & 63);
+                    }
+                    break;
+                case Kind::TEXT: column.codes[out] = column.codes[r]; break;
+                case Kind::PLAIN:
+                    bytes.append(column.bytes, begin, end - begin);
+                    column.offsets[out] = bytes.size();
+                    begin = end;
+                    break;
+            }
+            out++;
+        }
+        column.nulls = std::move(nulls);
+        column.flags = std::move(flags);
+        column.integers.resize(std::min(column.integers.size(), kept));
+        column.reals.resize(std::min(column.reals.size(), kept));
+        column.days.resize(std::min(column.days.size(), kept));
+        column.codes.resize(std::min(column.codes.size(), kept));
+        if (column.kind == Kind::PLAIN) {
+            column.bytes = std::move(bytes);
+            column.offsets.resize(kept);
+        }
+    }
+    rowCount = kept;
+}
+std::string_view ColumnStore::cell(size_t row, size_t column, char* buffer) const {
+    return columnCell(columns[column], row, buffer);
+}
+void ColumnStore::readRow(size_t row, std::vector<std::string_view>& cells, std::vector<char>& scratch) const {
+    // Every column gets its own slot, so earlier views stay valid
+    if (scratch.size() < columns.size() * CELL_BUFFER_BYTES) {
+        scratch.resize(columns.size() * CELL_BUFFER_BYTES);
+    }
+    cells.resize(columns.size());
+    for (size_t c = 0; c < columns.size(); ++c) {
+        cells[c] = columnCell(columns[c], row, scratch.data() + c * CELL_BUFFER_BYTES);
+    }
+}
+void ColumnStore::appendRowsTo(std::vector<std::vector<std::string>>& out) const {
+    out.reserve(out.size() + rowCount);
+    char buffer[CELL_BUFFER_BYTES];
+    for (size_t r = 0; r < rowCount; ++r) {
+        std::vector<std::string>& row = out.emplace_back();
+        row.reserve(columns.size());
+        for (const auto& column : columns) {
+            row.emplace_back(columnCell(column, r, buffer));
+        }
+    }
+}
+bool ColumnStore::containsKey(const std::vector<int>& keyColumns, const std::vector<std::string>& key) const {
+    // Each key cell in the representation of its column; a value the column
+    // could not have stored matches no row
+    struct Probe {
+        const Column* column = nullptr;
+        bool null = false;
+        int64_t integer = 0;   // also DECIMAL, DATE, TIME and TIMESTAMP values
+        double real = 0;
+        uint32_t code = 0;
+        std::string_view text;
+    };
+    std::vector<Probe> probes;
+    for (int index : keyColumns) {
+        if (index < 0 || static_cast<size_t>(index) >= columns.size() || static_cast<size_t>(index) >= key.size()) {
+            return false;
+        }
+        const Column& column = columns[index];
+        Probe probe;
+        probe.column = &column;
+        probe.null = key[index].empty();
+        probe.text = key[index];
+        if (!probe.null) {
+            bool fits = true;
+            switch (column.kind) {
+                case Kind::INTEGER:
+                    fits = ColumnCodecs::toNumber(probe.text, NumericForm::INTEGER, probe.integer);
+                    break;
+                case Kind::REAL: fits = toReal(probe.text, probe.real); break;
+                case Kind::DECIMAL: fits = toDecimal(probe.text, column.scale, probe.integer); break;
+                case Kind::DATE:
+                case Kind::TIME:
+                case Kind::TIMESTAMP: fits = parseInstant(column, probe.text, probe.integer); break;
+                case Kind::BOOLEAN:
+                    fits = probe.text == "TRUE" || probe.text == "FALSE";
+                    probe.integer = probe.text == "TRUE";
+                    break;
+                default: break;
+            }
+            if (!fits) {
+                return false;
+            }
+            if (column.kind == Kind::TEXT) {
+                auto it = column.lookup.find(key[index]);
+                if (it == column.lookup.end()) {
+                    return false;
+                }
+                probe.code = it->second;
+            }
+        }
+        probes.push_back(probe);
+    }
+
+    char unused[1];
+    for (size_t r = 0; r < rowCount; ++r) {
+        bool allMatch = true;
+        for (const auto& probe : probes) {
+            const Column& column = *probe.column;
+            bool null = column.isNull(r);
+            if (null || probe.null) {
+                allMatch = null == probe.null;
+            } else if (column.kind == Kind::INTEGER || column.kind == Kind::DECIMAL ||
+                       column.kind == Kind::TIME || column.kind == Kind::TIMESTAMP) {
+                allMatch = column.integers[r] == probe.integer;
+            } else if (column.kind == Kind::DATE) {
+                allMatch = column.days[r] == probe.integer;
+            } else if (column.kind == Kind::BOOLEAN) {
+                allMatch = column.flag(r) == (probe.integer != 0);
+            } else if (column.kind == Kind::REAL) {
+                // Bitwise, as the texts compare: -0 and 0 differ, NaN equals NaN
+                allMatch = std::memcmp(&column.reals[r], &probe.real, sizeof(double)) == 0;
+            } else if (column.kind == Kind::TEXT) {
+                allMatch = column.codes[r] == probe.code;
+            } else {
+                allMatch = columnCell(column, r, unused) == probe.text;
+            }
+            if (!allMatch) {
+                break;
+            }
+        }
+        if (allMatch) {
+            return true;
+        }
+    }
+    return false;
+}
+// Aggregates
+// ----------
+// Numbers of the non-null cells of a column as Aggregation reads their text;
+// dictionary entries are parsed once instead of once per row
+class CellNumbers {
+public:
+    explicit CellNumbers(const ColumnStore::Column& column) : source(column) {
+        if (source.kind == ColumnStore::Kind::TEXT) {
+            entryValues.resize(source.dictionary.size());
+            entryNumeric.resize(source.dictionary.size());
+            for (size_t i = 0; i < source.dictionary.size(); ++i) {
+                entryNumeric[i] = ZoneMaps::parseNumber(source.dictionary[i], entryValues[i]) ? 1 : 0;
+            }
+        }
+    }
+    // False for cells that are not numbers
+    bool read(size_t row, double& value) {
+        if (source.isNumeric()) {
+            value = source.number(row);
+            return true;
+        }
+        if (source.kind == ColumnStore::Kind::TEXT) {
+            value = entryValues[source.codes[row]];
+            return entryNumeric[source.codes[row]] != 0;
+        }
+        return ZoneMaps::parseNumber(columnCell(source, row, buffer), value);
+    }
+
+private:
+    const ColumnStore::Column& source;
+    std::vector<double> entryValues;
+    std::vector<uint8_t> entryNumeric;
+    char buffer[ColumnStore::CELL_BUFFER_BYTES];
+};
+// Same steps as Aggregation: NULLs and non-numeric cells are skipped
+struct Accumulator {
+    size_t selected = 0;
+    size_t nonNull = 0;
+    size_t count = 0;
+    double sum = 0;
+    double minimum = 0;
+    double maximum = 0;
+
+    void add(double value) {
+        if (count == 0 || value < minimum) {
+            minimum = value;
+        }
+        if (count == 0 || value > maximum) {
+            maximum = value;
+        }
+        sum += value;
+        count++;
+    }
+    std::string result(const std::string& function) const {
+        if (selected == 0 || (nonNull == 0 && function != "COUNT")) {
+            return "NULL";
+        } else if (function == "SUM") {
+            return std::to_string(sum);
+        } else if (function == "AVG") {
+            return std::to_string(count == 0 ? 0 : sum / count);
+        } else if (function == "MIN") {
+            return std::to_string(minimum);
+        } else if (function == "MAX") {
+            return std::to_string(maximum);
+        }
+        return std::to_string(static_cast<int>(nonNull));
+    }
+};
+static bool isColumnarAggregate(const std::string& function) {
+    return function == "SUM" || function == "AVG" || function == "MIN" || function == "MAX" || function == "COUNT";
+}
+bool ColumnStore::aggregate(const std::string& function, size_t column,
+                            const std::vector<uint8_t>& selection, std::string& result) const {
+    if (!isColumnarAggregate(function)) {
+        return false;
+    }
+    const Column& source = columns[column];
+    CellNumbers numbers(source);
+    Accumulator total;
+    // 64 rows at a time: the selected rows' bits minus the null bitmap leave
+    // the rows to visit, and COUNT only needs the bits
+    bool counting = function == "COUNT";
+    for (size_t word = 0; word < source.nulls.size(); ++word) {
+        size_t base = word * 64;
+        size_t rows = std::min<size_t>(64, rowCount - base);
+        uint64_t live = rows == 64 ? ~uint64_t(0) : (uint64_t(1) << rows) - 1;
+        if (!selection.empty()) {
+            uint64_t chosen = 0;
+            for (size_t i = 0; i < rows; ++i) {
+                chosen |= uint64_t(selection[base + i] != 0) << i;
+            }
+            live &= chosen;
+        }
+        total.selected += __builtin_popcountll(live);
+        live &= ~source.nulls[word];
+        total.nonNull += __builtin_popcountll(live);
+        for (; live != 0 && !counting; live &= live - 1) {
+            double value;
+            if (numbers.read(base + __builtin_ctzll(live), value)) {
+                total.add(value);
+            }
+        }
+    }
+    result = total.result(function);
+    return true;
+}
+bool ColumnStore::aggregateGroups(const std::string& function, size_t column, const std::vector<uint32_t>& groupOf,
+                                  size_t groupCount, std::vector<std::string>& results) const {
+    if (!isColumnarAggregate(function)) {
+        return false;
+    }
+    const Column& source = columns[column];
+    CellNumbers numbers(source);
+    std::vector<Accumulator> groups(groupCount);
+    for (size_t r = 0; r < rowCount; ++r) {
+        if (groupOf[r] == NO_GROUP) {
+            continue;
+        }
+        Accumulator& group = groups[groupOf[r]];
+        group.selected++;
+        if (source.isNull(r)) {
+            continue;
+        }
+        group.nonNull++;
+        double value;
+        if (function != "COUNT" && numbers.read(r, value)) {
+            group.add(value);
+        }
+    }
+    results.clear();
+    results.reserve(groupCount);
+    for (const auto& group : groups) {
+        results.push_back(group.result(function));
+    }
+    return true;
+}
+// Grouping
+// --------
+// Numbers the selected rows of a column by value: 0 for NULL, then 1 up.
+// Dictionary codes serve as they are; typed values are numbered by their
+// bits, which are equal exactly when their text is. Returns the id count.
+static uint32_t valueIds(const ColumnStore::Column& column, size_t rowCount,
+                         const std::vector<uint8_t>& selection, std::vector<uint32_t>& ids) {
+    using Kind = ColumnStore::Kind;
+    ids.assign(rowCount, 0);
+    if (column.kind == Kind::TEXT || column.kind == Kind::BOOLEAN) {
+        for (size_t r = 0; r < rowCount; ++r) {
+            if (!column.isNull(r)) {
+                ids[r] = column.kind == Kind::TEXT ? column.codes[r] + 1 : column.flag(r) + 1;
+            }
+        }
+        return column.kind == Kind::TEXT ? static_cast<uint32_t>(column.dictionary.size()) + 1 : 3;
+    }
+    std::unordered_map<uint64_t, uint32_t> numbered;
+    std::unordered_map<std::string_view, uint32_t> textNumbered;
+    for (size_t r = 0; r < rowCount; ++r) {
+        if (column.isNull(r) || (!selection.empty() && !selection[r])) {
+            continue;
+        }
+        uint32_t next = static_cast<uint32_t>(numbered.size() + textNumbered.size()) + 1;
+        if (column.kind == Kind::PLAIN) {
+            uint64_t begin = r == 0 ? 0 : column.offsets[r - 1];
+            std::string_view text(column.bytes.data() + begin, column.offsets[r] - begin);
+            ids[r] = textNumbered.emplace(text, next).first->second;
+            continue;
+        }
+        uint64_t bits;
+        if (column.kind == Kind::REAL) {
+            std::memcpy(&bits, &column.reals[r], sizeof(bits));
+        } else {
+            bits = static_cast<uint64_t>(column.instant(r));
+        }
+        ids[r] = numbered.emplace(bits, next).first->second;
+    }
+    return static_cast<uint32_t>(numbered.size() + textNumbered.size()) + 1;
+}
+size_t ColumnStore::groupRows(const std::vector<size_t>& groupColumns, const std::vector<uint8_t>& selection,
+                              std::vector<uint32_t>& groupOf) const {
+    // Each row's key starts as its id in the first column; every further
+    // column pairs the key with that column's id and renumbers the pairs
+    std::vector<uint32_t> keys;
+    uint32_t keyCount = valueIds(columns[groupColumns[0]], rowCount, selection, keys);
+    std::vector<uint32_t> ids;
+    for (size_t i = 1; i < groupColumns.size(); ++i) {
+        valueIds(columns[groupColumns[i]], rowCount, selection, ids);
+        std::unordered_map<uint64_t, uint32_t> pairs;
+        for (size_t r = 0; r < rowCount; ++r) {
+            if (selection.empty() || selection[r]) {
+                uint64_t pair = (uint64_t(keys[r]) << 32) | ids[r];
+                keys[r] = pairs.emplace(pair, static_cast<uint32_t>(pairs.size())).first->second;
+            }
+        }
+        keyCount = static_cast<uint32_t>(pairs.size());
+    }
+    // Groups are numbered in the order their first rows appear
+    std::vector<uint32_t> groupOfKey(keyCount, NO_GROUP);
+    uint32_t groupCount = 0;
+    groupOf.assign(rowCount, NO_GROUP);
+    for (size_t r = 0; r < rowCount; ++r) {
+        if (selection.empty() || selection[r]) {
+            if (groupOfKey[keys[r]] == NO_GROUP) {
+                groupOfKey[keys[r]] = groupCount++;
+            }
+            groupOf[r] = groupOfKey[keys[r]];
+        }
+    }
+    return groupCount;
+}
+size_t ColumnStore::memoryBytes() const {
+    size_t total = sizeof(*this) + columns.capacity() * sizeof(Column);
+    for (const auto& column : columns) {
+        total += column.integers.capacity() * sizeof(int64_t);
+        total += column.reals.capacity() * sizeof(double);
+        total += column.days.capacity() * sizeof(int32_t) + column.flags.capacity() * sizeof(uint64_t);
+        total += column.codes.capacity() * sizeof(uint32_t);
+        total += column.nulls.capacity() * sizeof(uint64_t);
+        total += column.offsets.capacity() * sizeof(uint64_t) + column.bytes.capacity();
+        for (const auto& entry : column.dictionary) {
+            // Once in the dictionary, once as a lookup key
+            size_t heap = entry.capacity() > 15 ? entry.capacity() + 1 : 0;
+            total += 2 * (sizeof(std::string) + heap) + sizeof(uint32_t) + 2 * sizeof(void*);
+        }
+        total += column.lookup.bucket_count() * sizeof(void*);
+    }
+    return total;
+}
+bool ColumnStore::parseInstant(const Column& column, std::string_view cell, int64_t& value) {
+    switch (column.kind) {
+        case Kind::DATE: {
+            // Only the canonical spelling parses
+            int32_t days;
+            if (!TypedValues::parseDate(cell, days)) {
+                return false;
+            }
+            value = days;
+            return true;
+        }
+        case Kind::TIME:
+            return TypedValues::parseTime(cell, value) && TypedValues::formatTime(value) == cell;
+        case Kind::TIMESTAMP:
+            return TypedValues::parseTimestamp(cell, value) && TypedValues::formatTimestamp(value) == cell;
+        default:
+            return false;
+    }
+}
@@ -0,0 +1,117 @@
+#ifndef COLUMN_STORE_H
+#define COLUMN_STORE_H
+
+#include "ConditionParser.h"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+// In-memory rows of a table created WITH (storage = column), one contiguous
+// array per column instead of a string per cell:
+//   INTEGER    int64 values of INT columns
+//   REAL       doubles of floating point columns
+//   DECIMAL    int64 values scaled by 10^scale, for NUMERIC(p,d)
+//   DATE       days since 1970-01-01
+//   TIME       microseconds since midnight
+//   TIMESTAMP  microseconds since 1970-01-01 00:00:00
+//   BOOLEAN    one bit per row
+//   TEXT       codes into a dictionary of distinct values
+//   PLAIN      every value in one byte buffer, for text with few repeats
+// Empty cells are NULL and only set a bit in the column's null bitmap.
+//
+// Cells read back byte for byte as they were appended. A typed column keeps
+// only values whose text it can reproduce exactly (canonical integers, reals
+// as std::to_string prints them, the TypedValues spellings of the others);
+// the first value that does not fit turns the whole column into TEXT.
+class ColumnStore {
+public:
+    enum class Kind : uint8_t { INTEGER, REAL, DECIMAL, DATE, TIME, TIMESTAMP, BOOLEAN, TEXT, PLAIN };
+
+    struct Column {
+        Kind kind = Kind::TEXT;
+        int scale = 0;                   // DECIMAL digits after the point
+        double divisor = 1;              // 10^scale
+        std::vector<int64_t> integers;   // INTEGER, DECIMAL, TIME and TIMESTAMP
+        std::vector<double> reals;
+        std::vector<int32_t> days;       // DATE
+        std::vector<uint64_t> flags;     // BOOLEAN bit per row, set for TRUE
+        std::vector<uint32_t> codes;
+        std::vector<std::string> dictionary;
+        std::unordered_map<std::string, uint32_t> lookup;
+        std::string bytes;               // PLAIN values, back to back
+        std::vector<uint64_t> offsets;   // PLAIN end offset of every value
+        std::vector<uint64_t> nulls;     // bit per row, set for empty cells
+
+        bool isNull(size_t row) const { return (nulls[row >> 6] >> (row & 63)) & 1; }
+        bool flag(size_t row) const { return (flags[row >> 6] >> (row & 63)) & 1; }
+        bool isNumeric() const { return kind == Kind::INTEGER || kind == Kind::REAL || kind == Kind::DECIMAL; }
+        // Value of a non-null INTEGER, REAL or DECIMAL cell
+        double number(size_t row) const {
+            return kind == Kind::REAL ? reals[row]
+                 : kind == Kind::DECIMAL ? static_cast<double>(integers[row]) / divisor
+                 : static_cast<double>(integers[row]);
+        }
+        // Value of a non-null DATE, TIME or TIMESTAMP cell in its own unit
+        int64_t instant(size_t row) const { return kind == Kind::DATE ? days[row] : integers[row]; }
+    };
+
+    // Longest text of a typed cell
+    static const size_t CELL_BUFFER_BYTES = 512;
+
+    explicit ColumnStore(const std::vector<std::string>& columnTypes);
+
+    size_t getRowCount() const { return rowCount; }
+    size_t getColumnCount() const { return columns.size(); }
+    const Column& getColumn(size_t index) const { return columns[index]; }
+
+    // row must have one cell per column
+    void append(const RowView& row);
+    // Keeps the rows whose flag in keep is set, in order
+    void retain(const std::vector<uint8_t>& keep);
+
+    // Text of a cell; typed cells are printed into buffer
+    // (CELL_BUFFER_BYTES), so the view lasts until buffer is reused
+    std::string_view cell(size_t row, size_t column, char* buffer) const;
+    // Views of every cell of row; typed cells are printed into scratch
+    void readRow(size_t row, std::vector<std::string_view>& cells, std::vector<char>& scratch) const;
+    void appendRowsTo(std::vector<std::vector<std::string>>& out) const;
+
+    // True if some row holds key's values in all of keyColumns
+    bool containsKey(const std::vector<int>& keyColumns, const std::vector<std::string>& key) const;
+    // SUM, AVG, MIN, MAX and COUNT over the selected rows (all rows when
+    // selection is empty), with the results Aggregation gives for the text;
+    // false for other functions
+    bool aggregate(const std::string& function, size_t column,
+                   const std::vector<uint8_t>& selection, std::string& result) const;
+
+    // GROUP BY on dictionary codes and typed values instead of cell text.
+    // Numbers the groups of the selected rows in order of first appearance,
+    // sets groupOf to each row's group (NO_GROUP for unselected rows) and
+    // returns the group count. NULLs form one group per column.
+    static constexpr uint32_t NO_GROUP = UINT32_MAX;
+    size_t groupRows(const std::vector<size_t>& groupColumns, const std::vector<uint8_t>& selection,
+                     std::vector<uint32_t>& groupOf) const;
+    // aggregate() for every group at once
+    bool aggregateGroups(const std::string& function, size_t column, const std::vector<uint32_t>& groupOf,
+                         size_t groupCount, std::vector<std::string>& results) const;
+
+    // Bytes held by the arrays, dictionaries and bitmaps
+    size_t memoryBytes() const;
+
+    // Value cell holds in a DATE, TIME or TIMESTAMP column; false unless
+    // cell is spelled exactly as the column prints that value
+    static bool parseInstant(const Column& column, std::string_view cell, int64_t& value);
+
+private:
+    std::vector<Column> columns;
+    size_t rowCount = 0;
+
+    void appendCell(Column& column, std::string_view cell);
+    void appendText(Column& column, std::string_view cell);
+    // count is the number of cells column holds
+    void demote(Column& column, Kind kind, size_t count);
+};
+
+#endif // COLUMN_STORE_H
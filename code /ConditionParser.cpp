@@ -1,5 +1,8 @@
 #include "ConditionParser.h"
 #include "Utils.h"
+#include "ZoneMap.h"
+#include "ColumnStore.h"
+#include "TypedValue.h"
 #include <sstream>
 #include <cctype>
 #include <stdexcept>
@@ -12,7 +15,7 @@ class LiteralExpression : public ConditionExpression {
 public:
     explicit LiteralExpression(const std::string& value) : value(value) {}
     
-    bool evaluate(const std::vector<std::string>& row,
+    bool evaluate(const RowView& row,
                   const std::vector<std::string>& columns) const override {
         return !value.empty() && value != "0" && value != "FALSE" && toLowerCase(value) != "false";
     }
@@ -37,7 +40,7 @@ class ColumnExpression : public ConditionExpression {
 public:
     explicit ColumnExpression(const std::string& column) : column(column) {}
     
-    bool evaluate(const std::vector<std::string>& row,
+    bool evaluate(const RowView& row,
                   const std::vector<std::string>& columns) const override {
         auto it = std::find(columns.begin(), columns.end(), column);
         if (it == columns.end()) return false;
@@ -45,11 +48,11 @@ public:
         int idx = std::distance(columns.begin(), it);
         if (idx >= row.size()) return false;
         
-        const std::string& cell = row[idx];
-        return !cell.empty() && cell != "0" && cell != "FALSE" && toLowerCase(cell) != "false";
+        std::string_view cell = row[idx];
+        return !cell.empty() && cell != "0" && cell != "FALSE" && toLowerCase(std::string(cell)) != "false";
     }
     
-    std::string getStringValue(const std::vector<std::string>& row,
+    std::string getStringValue(const RowView& row,
                               const std::vector<std::string>& columns) const {
         auto it = std::find(columns.begin(), columns.end(), column);
         if (it == columns.end()) return "";
@@ -57,10 +60,10 @@ public:
         int idx = std::distance(columns.begin(), it);
         if (idx >= row.size()) return "";
         
-        return row[idx];
+        return std::string(row[idx]);
     }
     
-    double getNumericValue(const std::vector<std::string>& row,
+    double getNumericValue(const RowView& row,
                           const std::vector<std::string>& columns) const {
         std::string strValue = getStringValue(row, columns);
         try {
@@ -74,9 +77,181 @@ public:
         return column;
     }
     
+    // Position of this column in a packed store; -1 if the store lacks it
+    int getStoreIndex(const ColumnStore& store,
+                      const std::vector<std::string>& columns) const {
+        auto it = std::find(columns.begin(), columns.end(), column);
+        size_t idx = std::distance(columns.begin(), it);
+        if (it == columns.end() || idx >= store.getColumnCount()) return -1;
+        return static_cast<int>(idx);
+    }
+    
+    // Summary of this column in a block; null if the block does not cover it
+    const ColumnZone* getZone(const BlockZone& zone,
+                              const std::vector<std::string>& columns) const {
+        auto it = std::find(columns.begin(), columns.end(), column);
+        size_t idx = std::distance(columns.begin(), it);
+        if (it == columns.end() || idx >= zone.columns.size()) return nullptr;
+        return &zone.columns[idx];
+    }
+    
 private:
     std::string column;
 };
+// Zone map checks mirroring the comparisons below: "cell op value" for some
+// cell between the zone's bounds
+static bool numericZoneCanMatch(const ColumnZone& zone, const std::string& op, double value) {
+    if (zone.numericCount == 0) return false;
+    if (op == "=") return value - zone.numericMax < 1e-9 && zone.numericMin - value < 1e-9;
+    else if (op == ">") return zone.numericMax > value;
+    else if (op == "<") return zone.numericMin < value;
+    else if (op == ">=") return zone.numericMax >= value;
+    else if (op == "<=") return zone.numericMin <= value;
+    return true;
+}
+static bool textZoneCanMatch(const ColumnZone& zone, const std::string& op, const std::string& value) {
+    if (zone.numericCount + zone.textCount == 0) return false;
+    bool belowMax = zone.textMaxUnbounded || value <= zone.textMax;
+    bool aboveMax = zone.textMaxUnbounded || zone.textMax > value;
+    if (op == "=") return zone.textMin <= value && belowMax;
+    else if (op == ">") return aboveMax;
+    else if (op == "<") return zone.textMin < value;
+    else if (op == ">=") return belowMax;
+    else if (op == "<=") return zone.textMin <= value;
+    return true;
+}
+// A literal that compares numerically: it reads as a number and is not a
+// date or time, whose leading year or hour would otherwise be taken for it
+static bool numericLiteral(const std::string& value, double& number) {
+    return !TypedValues::isTemporal(value) && ZoneMaps::parseNumber(value, number);
+}
+// "left op right" for two cell texts: numerically when both read as numbers,
+// as text otherwise or when asText is set. Nothing compares with NULL, not
+// even NULL itself.
+static bool compareValues(std::string_view left, const std::string& op, std::string_view right, bool asText) {
+    if (left.empty() || right.empty()) return false;
+    double leftNum, rightNum;
+    if (!asText && ZoneMaps::parseNumber(left, leftNum) && ZoneMaps::parseNumber(right, rightNum)) {
+        if (op == "=") return std::abs(leftNum - rightNum) < 1e-9;
+        else if (op == "!=") return std::abs(leftNum - rightNum) >= 1e-9;
+        else if (op == ">") return leftNum > rightNum;
+        else if (op == "<") return leftNum < rightNum;
+        else if (op == ">=") return leftNum >= rightNum;
+        else if (op == "<=") return leftNum <= rightNum;
+        return false;
+    }
+    if (op == "=") return left == right;
+    else if (op == "!=") return left != right;
+    else if (op == ">") return left > right;
+    else if (op == "<") return left < right;
+    else if (op == ">=") return left >= right;
+    else if (op == "<=") return left <= right;
+    return false;
+}
+// "cell LIKE pattern"; false when either is NULL
+static bool likeValues(const std::string& cell, const std::string& pattern) {
+    return !cell.empty() && !pattern.empty() && matchLikePattern(cell, pattern);
+}
+// Bloom filter probe for "cell = value"; a number can only equal numeric
+// cells, anything else only equal text
+static bool bloomMayMatch(const ColumnZone& zone, const std::string& value) {
+    if (zone.bloom.empty()) return true;
+    double number;
+    if (numericLiteral(value, number)) {
+        std::vector<uint64_t> keys;
+        BloomFilter::numberKeys(number, keys);
+        for (uint64_t key : keys) {
+            if (zone.bloom.mayContain(key)) return true;
+        }
+        return false;
+    }
+    return zone.bloom.mayContain(BloomFilter::textKey(value));
+}
+// Numeric cells compare numerically against a numeric literal; everything
+// else compares as text
+static bool zoneCanMatch(const ColumnZone& zone, const std::string& op, const std::string& value) {
+    double number;
+    if (numericLiteral(value, number)) {
+        return numericZoneCanMatch(zone, op, number) ||
+               (zone.textCount > 0 && textZoneCanMatch(zone, op, value));
+    }
+    return textZoneCanMatch(zone, op, value);
+}
+// Columnar selection for a predicate that reads a single column: evaluated
+// once per distinct value of a dictionary column, once per row otherwise
+static void selectByCell(const ConditionExpression& predicate, const ColumnStore& store, size_t column,
+                         const std::vector<std::string>& columns, std::vector<uint8_t>& matches) {
+    std::vector<std::string_view> cells(columns.size());
+    RowView row(cells);
+    auto test = [&](std::string_view cell) -> uint8_t {
+        cells[column] = cell;
+        return predicate.evaluate(row, columns) ? 1 : 0;
+    };
+    const ColumnStore::Column& source = store.getColumn(column);
+    size_t rowCount = store.getRowCount();
+    matches.resize(rowCount);
+    if (source.kind == ColumnStore::Kind::TEXT) {
+        uint8_t nullMatch = test(std::string_view());
+        std::vector<uint8_t> entryMatches(source.dictionary.size());
+        for (size_t i = 0; i < source.dictionary.size(); ++i) {
+            entryMatches[i] = test(source.dictionary[i]);
+        }
+        for (size_t r = 0; r < rowCount; ++r) {
+            matches[r] = source.isNull(r) ? nullMatch : entryMatches[source.codes[r]];
+        }
+        return;
+    }
+    char buffer[ColumnStore::CELL_BUFFER_BYTES];
+    for (size_t r = 0; r < rowCount; ++r) {
+        matches[r] = test(store.cell(r, column, buffer));
+    }
+}
+// Result of a predicate for a NULL cell, which evaluate() rejects for every
+// predicate but IS NULL; asked rather than assumed so the two cannot differ
+static uint8_t nullCellMatch(const ConditionExpression& predicate, const std::vector<std::string>& columns) {
+    std::vector<std::string_view> cells(columns.size());
+    return predicate.evaluate(RowView(cells), columns) ? 1 : 0;
+}
+// Marks the rows of a numeric column whose value passes test
+template <typename Test>
+static void selectNumbers(const ColumnStore::Column& source, size_t rowCount, uint8_t nullMatch,
+                          std::vector<uint8_t>& matches, Test test) {
+    matches.resize(rowCount);
+    if (source.kind == ColumnStore::Kind::INTEGER) {
+        for (size_t r = 0; r < rowCount; ++r) {
+            matches[r] = source.isNull(r) ? nullMatch : test(static_cast<double>(source.integers[r]));
+        }
+    } else if (source.kind == ColumnStore::Kind::REAL) {
+        for (size_t r = 0; r < rowCount; ++r) {
+            matches[r] = source.isNull(r) ? nullMatch : test(source.reals[r]);
+        }
+    } else {
+        for (size_t r = 0; r < rowCount; ++r) {
+            matches[r] = source.isNull(r) ? nullMatch : test(source.number(r));
+        }
+    }
+}
+// Marks the rows of a DATE, TIME or TIMESTAMP column whose value passes
+// test. Canonical values order as their text does, so comparing the values
+// gives what evaluate() gets comparing text.
+template <typename Test>
+static void selectInstants(const ColumnStore::Column& source, size_t rowCount, uint8_t nullMatch,
+                           std::vector<uint8_t>& matches, Test test) {
+    matches.resize(rowCount);
+    if (source.kind == ColumnStore::Kind::DATE) {
+        for (size_t r = 0; r < rowCount; ++r) {
+            matches[r] = source.isNull(r) ? nullMatch : test(static_cast<int64_t>(source.days[r]));
+        }
+    } else {
+        for (size_t r = 0; r < rowCount; ++r) {
+            matches[r] = source.isNull(r) ? nullMatch : test(source.integers[r]);
+        }
+    }
+}
+static bool isInstantColumn(const ColumnStore::Column& column) {
+    return column.kind == ColumnStore::Kind::DATE || column.kind == ColumnStore::Kind::TIME ||
+           column.kind == ColumnStore::Kind::TIMESTAMP;
+}
 // Comparison expression
 class ComparisonExpression : public ConditionExpression {
 public:
@@ -84,7 +259,7 @@ public:
                         const std::string& op, 
                         std::unique_ptr<ConditionExpression> right)
         : left(std::move(left)), op(op), right(std::move(right)) {}
-    bool evaluate(const std::vector<std::string>& row,
+    bool evaluate(const RowView& row,
                   const std::vector<std::string>& columns) const override {
         // Check for specific column expression cases
         auto leftCol = dynamic_cast<ColumnExpression*>(left.get());
@@ -99,29 +274,9 @@ public:
             
             // Special case for LIKE operator
             if (op == "LIKE") {
-                return matchLikePattern(colValue, litValue);
-            }
-            
-            // Try numeric comparison first
-            try {
-                double colNum = std::stod(colValue);
-                double litNum = std::stod(litValue);
-                
-                if (op == "=") return std::abs(colNum - litNum) < 1e-9;
-                else if (op == "!=") return std::abs(colNum - litNum) >= 1e-9;
-                else if (op == ">") return colNum > litNum;
-                else if (op == "<") return colNum < litNum;
-                else if (op == ">=") return colNum >= litNum;
-                else if (op == "<=") return colNum <= litNum;
-            } catch (...) {
-                // Fall back to string comparison
-                if (op == "=") return colValue == litValue;
-                else if (op == "!=") return colValue != litValue;
-                else if (op == ">") return colValue > litValue;
-                else if (op == "<") return colValue < litValue;
-                else if (op == ">=") return colValue >= litValue;
-                else if (op == "<=") return colValue <= litValue;
+                return likeValues(colValue, litValue);
             }
+            return compareValues(colValue, op, litValue, TypedValues::isTemporal(litValue));
         } else if (rightCol && leftLit) {
             // Literal <op> Column
             std::string colValue = rightCol->getStringValue(row, columns);
@@ -129,54 +284,15 @@ public:
             
             // Special case for LIKE operator
             if (op == "LIKE") {
-                return matchLikePattern(colValue, litValue);
-            }
-            
-            // Try numeric comparison first
-            try {
-                double colNum = std::stod(colValue);
-                double litNum = std::stod(litValue);
-                
-                if (op == "=") return std::abs(litNum - colNum) < 1e-9;
-                else if (op == "!=") return std::abs(litNum - colNum) >= 1e-9;
-                else if (op == ">") return litNum > colNum;
-                else if (op == "<") return litNum < colNum;
-                else if (op == ">=") return litNum >= colNum;
-                else if (op == "<=") return litNum <= colNum;
-            } catch (...) {
-                // Fall back to string comparison
-                if (op == "=") return litValue == colValue;
-                else if (op == "!=") return litValue != colValue;
-                else if (op == ">") return litValue > colValue;
-                else if (op == "<") return litValue < colValue;
-                else if (op == ">=") return litValue >= colValue;
-                else if (op == "<=") return litValue <= colValue;
+                return likeValues(colValue, litValue);
             }
+            return compareValues(litValue, op, colValue, TypedValues::isTemporal(litValue));
         } else if (leftCol && rightCol) {
             // Column <op> Column
             std::string leftValue = leftCol->getStringValue(row, columns);
             std::string rightValue = rightCol->getStringValue(row, columns);
-            
-            // Try numeric comparison first
-            try {
-                double leftNum = std::stod(leftValue);
-                double rightNum = std::stod(rightValue);
-                
-                if (op == "=") return std::abs(leftNum - rightNum) < 1e-9;
-                else if (op == "!=") return std::abs(leftNum - rightNum) >= 1e-9;
-                else if (op == ">") return leftNum > rightNum;
-                else if (op == "<") return leftNum < rightNum;
-                else if (op == ">=") return leftNum >= rightNum;
-                else if (op == "<=") return leftNum <= rightNum;
-            } catch (...) {
-                // Fall back to string comparison
-                if (op == "=") return leftValue == rightValue;
-                else if (op == "!=") return leftValue != rightValue;
-                else if (op == ">") return leftValue > rightValue;
-                else if (op == "<") return leftValue < rightValue;
-                else if (op == ">=") return leftValue >= rightValue;
-                else if (op == "<=") return leftValue <= rightValue;
-            }
+            return compareValues(leftValue, op, rightValue,
+                                 TypedValues::isTemporal(leftValue) || TypedValues::isTemporal(rightValue));
         } else {
             // Generic case - evaluate boolean expressions
             bool leftResult = left->evaluate(row, columns);
@@ -190,6 +306,122 @@ public:
         return false;
     }
     
+    bool canMatchBlock(const BlockZone& zone,
+                       const std::vector<std::string>& columns) const override {
+        auto leftCol = dynamic_cast<ColumnExpression*>(left.get());
+        auto rightCol = dynamic_cast<ColumnExpression*>(right.get());
+        auto leftLit = dynamic_cast<LiteralExpression*>(left.get());
+        auto rightLit = dynamic_cast<LiteralExpression*>(right.get());
+        
+        const ColumnExpression* column = nullptr;
+        const LiteralExpression* literal = nullptr;
+        std::string columnOp = op;
+        if (leftCol && rightLit) {
+            column = leftCol;
+            literal = rightLit;
+        } else if (rightCol && leftLit) {
+            // Literal <op> Column, seen from the column
+            column = rightCol;
+            literal = leftLit;
+            if (op == ">") columnOp = "<";
+            else if (op == "<") columnOp = ">";
+            else if (op == ">=") columnOp = "<=";
+            else if (op == "<=") columnOp = ">=";
+        } else {
+            return true;
+        }
+        
+        const ColumnZone* columnZone = column->getZone(zone, columns);
+        if (!columnZone || columnOp == "LIKE" || columnOp == "!=") {
+            return true;
+        }
+        std::string value = literal->getStringValue();
+        if (value.empty()) {
+            return false;   // compared with NULL
+        }
+        return zoneCanMatch(*columnZone, columnOp, value) &&
+               (columnOp != "=" || bloomMayMatch(*columnZone, value));
+    }
+    
+    bool selectColumnar(const ColumnStore& store,
+                        const std::vector<std::string>& columns,
+                        std::vector<uint8_t>& matches) const override {
+        auto leftCol = dynamic_cast<ColumnExpression*>(left.get());
+        auto rightCol = dynamic_cast<ColumnExpression*>(right.get());
+        auto leftLit = dynamic_cast<LiteralExpression*>(left.get());
+        auto rightLit = dynamic_cast<LiteralExpression*>(right.get());
+        
+        const ColumnExpression* column = nullptr;
+        const LiteralExpression* literal = nullptr;
+        std::string columnOp = op;
+        if (leftCol && rightLit) {
+            column = leftCol;
+            literal = rightLit;
+        } else if (rightCol && leftLit) {
+            column = rightCol;
+            literal = leftLit;
+            if (op == ">") columnOp = "<";
+            else if (op == "<") columnOp = ">";
+            else if (op == ">=") columnOp = "<=";
+            else if (op == "<=") columnOp = ">=";
+        } else {
+            return false;
+        }
+        int index = column->getStoreIndex(store, columns);
+        if (index < 0) {
+            return false;
+        }
+        
+        // Numbers against a numeric literal compare as evaluate() does after
+        // parsing both sides, without the parsing
+        const ColumnStore::Column& source = store.getColumn(index);
+        std::string literalValue = literal->getStringValue();
+        uint8_t nullMatch = nullCellMatch(*this, columns);
+        size_t rowCount = store.getRowCount();
+        double value;
+        if (source.isNumeric() && columnOp != "LIKE" && numericLiteral(literalValue, value)) {
+            if (columnOp == "=") {
+                selectNumbers(source, rowCount, nullMatch, matches, [value](double x) { return std::abs(x - value) < 1e-9; });
+            } else if (columnOp == "!=") {
+                selectNumbers(source, rowCount, nullMatch, matches, [value](double x) { return std::abs(x - value) >= 1e-9; });
+            } else if (columnOp == ">") {
+                selectNumbers(source, rowCount, nullMatch, matches, [value](double x) { return x > value; });
+            } else if (columnOp == "<") {
+                selectNumbers(source, rowCount, nullMatch, matches, [value](double x) { return x < value; });
+            } else if (columnOp == ">=") {
+                selectNumbers(source, rowCount, nullMatch, matches, [value](double x) { return x >= value; });
+            } else if (columnOp == "<=") {
+                selectNumbers(source, rowCount, nullMatch, matches, [value](double x) { return x <= value; });
+            } else {
+                selectNumbers(source, rowCount, nullMatch, matches, [](double) { return false; });
+            }
+            return true;
+        }
+        // Dates and times against a literal of the same kind and spelling
+        int64_t instant;
+        if (isInstantColumn(source) && columnOp != "LIKE" &&
+            ColumnStore::parseInstant(source, literalValue, instant)) {
+            if (columnOp == "=") {
+                selectInstants(source, rowCount, nullMatch, matches, [instant](int64_t x) { return x == instant; });
+            } else if (columnOp == "!=") {
+                selectInstants(source, rowCount, nullMatch, matches, [instant](int64_t x) { return x != instant; });
+            } else if (columnOp == ">") {
+                selectInstants(source, rowCount, nullMatch, matches, [instant](int64_t x) { return x > instant; });
+            } else if (columnOp == "<") {
+                selectInstants(source, rowCount, nullMatch, matches, [instant](int64_t x) { return x < instant; });
+            } else if (columnOp == ">=") {
+                selectInstants(source, rowCount, nullMatch, matches, [instant](int64_t x) { return x >= instant; });
+            } else if (columnOp == "<=") {
+                selectInstants(source, rowCount, nullMatch, matches, [instant](int64_t x) { return x <= instant; });
+            } else {
+                selectInstants(source, rowCount, nullMatch, matches, [](int64_t) { return false; });
+            }
+            return true;
+        }
+        selectByCell(*this, store, index, columns, matches);
+        return true;
+    }
+    
 private:
     std::unique_ptr<ConditionExpression> left;
     std::string op;
@@ -199,10 +431,27 @@ class AndExpression : public ConditionExpression {
 public:
     AndExpression(std::unique_ptr<ConditionExpression> left, std::unique_ptr<ConditionExpression> right)
         : left(std::move(left)), right(std::move(right)) {}
-    bool evaluate(const std::vector<std::string>& row,
+    bool evaluate(const RowView& row,
                   const std::vector<std::string>& columns) const override {
         return left->evaluate(row, columns) && right->evaluate(row, columns);
     }
+    bool canMatchBlock(const BlockZone& zone,
+                       const std::vector<std::string>& columns) const override {
+        return left->canMatchBlock(zone, columns) && right->canMatchBlock(zone, columns);
+    }
+    bool selectColumnar(const ColumnStore& store,
+                        const std::vector<std::string>& columns,
+                        std::vector<uint8_t>& matches) const override {
+        std::vector<uint8_t> rightMatches;
+        if (!left->selectColumnar(store, columns, matches) ||
+            !right->selectColumnar(store, columns, rightMatches)) {
+            return false;
+        }
+        for (size_t r = 0; r < matches.size(); ++r) {
+            matches[r] &= rightMatches[r];
+        }
+        return true;
+    }
     
 private:
     std::unique_ptr<ConditionExpression> left;
@@ -212,10 +461,27 @@ class OrExpression : public ConditionExpression {
 public:
     OrExpression(std::unique_ptr<ConditionExpression> left, std::unique_ptr<ConditionExpression> right)
         : left(std::move(left)), right(std::move(right)) {}
-    bool evaluate(const std::vector<std::string>& row,
+    bool evaluate(const RowView& row,
                   const std::vector<std::string>& columns) const override {
         return left->evaluate(row, columns) || right->evaluate(row, columns);
     }
+    bool canMatchBlock(const BlockZone& zone,
+                       const std::vector<std::string>& columns) const override {
+        return left->canMatchBlock(zone, columns) || right->canMatchBlock(zone, columns);
+    }
+    bool selectColumnar(const ColumnStore& store,
+                        const std::vector<std::string>& columns,
+                        std::vector<uint8_t>& matches) const override {
+        std::vector<uint8_t> rightMatches;
+        if (!left->selectColumnar(store, columns, matches) ||
+            !right->selectColumnar(store, columns, rightMatches)) {
+            return false;
+        }
+        for (size_t r = 0; r < matches.size(); ++r) {
+            matches[r] |= rightMatches[r];
+        }
+        return true;
+    }
     
 private:
     std::unique_ptr<ConditionExpression> left;
@@ -225,10 +491,21 @@ class NotExpression : public ConditionExpression {
 public:
     explicit NotExpression(std::unique_ptr<ConditionExpression> expr)
         : expr(std::move(expr)) {}
-    bool evaluate(const std::vector<std::string>& row,
+    bool evaluate(const RowView& row,
                   const std::vector<std::string>& columns) const override {
         return !expr->evaluate(row, columns);
     }
+    bool selectColumnar(const ColumnStore& store,
+                        const std::vector<std::string>& columns,
+                        std::vector<uint8_t>& matches) const override {
+        if (!expr->selectColumnar(store, columns, matches)) {
+            return false;
+        }
+        for (auto& match : matches) {
+            match = !match;
+        }
+        return true;
+    }
     
 private:
     std::unique_ptr<ConditionExpression> expr;
@@ -237,7 +514,7 @@ class IsNullExpression : public ConditionExpression {
 public:
     IsNullExpression(std::unique_ptr<ConditionExpression> expr, bool isNull)
         : expr(std::move(expr)), isNull(isNull) {}
-    bool evaluate(const std::vector<std::string>& row,
+    bool evaluate(const RowView& row,
                   const std::vector<std::string>& columns) const override {
         // Only makes sense for column expressions
         auto colExpr = dynamic_cast<ColumnExpression*>(expr.get());
@@ -248,6 +525,32 @@ public:
         return false;
     }
     
+    bool canMatchBlock(const BlockZone& zone,
+                       const std::vector<std::string>& columns) const override {
+        auto colExpr = dynamic_cast<ColumnExpression*>(expr.get());
+        const ColumnZone* columnZone = colExpr ? colExpr->getZone(zone, columns) : nullptr;
+        if (!columnZone) {
+            return true;
+        }
+        return isNull ? columnZone->nullCount > 0 : columnZone->nullCount < zone.rowCount;
+    }
+    
+    bool selectColumnar(const ColumnStore& store,
+                        const std::vector<std::string>& columns,
+                        std::vector<uint8_t>& matches) const override {
+        auto colExpr = dynamic_cast<ColumnExpression*>(expr.get());
+        int index = colExpr ? colExpr->getStoreIndex(store, columns) : -1;
+        if (index < 0) {
+            return false;
+        }
+        const ColumnStore::Column& source = store.getColumn(index);
+        matches.resize(store.getRowCount());
+        for (size_t r = 0; r < matches.size(); ++r) {
+            matches[r] = source.isNull(r) == isNull;
+        }
+        return true;
+    }
+    
 private:
     std::unique_ptr<ConditionExpression> expr;
     bool isNull; // true for IS NULL, false for IS NOT NULL
@@ -260,7 +563,7 @@ public:
                      bool notBetween)
         : expr(std::move(expr)), lower(std::move(lower)), 
           upper(std::move(upper)), notBetween(notBetween) {}
-    bool evaluate(const std::vector<std::string>& row,
+    bool evaluate(const RowView& row,
                   const std::vector<std::string>& columns) const override {
         // Handles Column BETWEEN Literal AND Literal
         auto colExpr = dynamic_cast<ColumnExpression*>(expr.get());
@@ -272,25 +575,82 @@ public:
             std::string colValue = colExpr->getStringValue(row, columns);
             std::string lowerValue = lowerLit->getStringValue();
             std::string upperValue = upperLit->getStringValue();
+            if (colValue.empty() || lowerValue.empty() || upperValue.empty()) {
+                return false;   // NULL is neither between nor outside
+            }
             
-            // Try numeric comparison first
-            try {
-                double colNum = std::stod(colValue);
-                double lowerNum = std::stod(lowerValue);
-                double upperNum = std::stod(upperValue);
-                
-                bool betweenResult = (colNum >= lowerNum && colNum <= upperNum);
-                return notBetween ? !betweenResult : betweenResult;
-            } catch (...) {
-                // Fall back to string comparison
-                bool betweenResult = (colValue >= lowerValue && colValue <= upperValue);
-                return notBetween ? !betweenResult : betweenResult;
+            // Numeric comparison unless a bound is a date or time
+            bool asText = TypedValues::isTemporal(lowerValue) || TypedValues::isTemporal(upperValue);
+            double colNum, lowerNum, upperNum;
+            bool betweenResult;
+            if (!asText && ZoneMaps::parseNumber(colValue, colNum) && ZoneMaps::parseNumber(lowerValue, lowerNum) &&
+                ZoneMaps::parseNumber(upperValue, upperNum)) {
+                betweenResult = (colNum >= lowerNum && colNum <= upperNum);
+            } else {
+                betweenResult = (colValue >= lowerValue && colValue <= upperValue);
             }
+            return notBetween ? !betweenResult : betweenResult;
         }
         
         return false;
     }
     
+    bool canMatchBlock(const BlockZone& zone,
+                       const std::vector<std::string>& columns) const override {
+        auto colExpr = dynamic_cast<ColumnExpression*>(expr.get());
+        auto lowerLit = dynamic_cast<LiteralExpression*>(lower.get());
+        auto upperLit = dynamic_cast<LiteralExpression*>(upper.get());
+        const ColumnZone* columnZone = colExpr ? colExpr->getZone(zone, columns) : nullptr;
+        if (notBetween || !columnZone || !lowerLit || !upperLit) {
+            return true;
+        }
+        
+        // Some cell must lie between both bounds, compared as evaluate() does
+        std::string lowerValue = lowerLit->getStringValue();
+        std::string upperValue = upperLit->getStringValue();
+        bool textCanMatch = textZoneCanMatch(*columnZone, ">=", lowerValue) &&
+                            textZoneCanMatch(*columnZone, "<=", upperValue);
+        double lowerNum, upperNum;
+        if (numericLiteral(lowerValue, lowerNum) && numericLiteral(upperValue, upperNum)) {
+            bool numericCanMatch = numericZoneCanMatch(*columnZone, ">=", lowerNum) &&
+                                   numericZoneCanMatch(*columnZone, "<=", upperNum);
+            return numericCanMatch || (columnZone->textCount > 0 && textCanMatch);
+        }
+        return textCanMatch;
+    }
+    
+    bool selectColumnar(const ColumnStore& store,
+                        const std::vector<std::string>& columns,
+                        std::vector<uint8_t>& matches) const override {
+        auto colExpr = dynamic_cast<ColumnExpression*>(expr.get());
+        auto lowerLit = dynamic_cast<LiteralExpression*>(lower.get());
+        auto upperLit = dynamic_cast<LiteralExpression*>(upper.get());
+        int index = colExpr && lowerLit && upperLit ? colExpr->getStoreIndex(store, columns) : -1;
+        if (index < 0) {
+            return false;
+        }
+        
+        const ColumnStore::Column& source = store.getColumn(index);
+        std::string lowerValue = lowerLit->getStringValue();
+        std::string upperValue = upperLit->getStringValue();
+        bool inside = !notBetween;
+        double lowerNum, upperNum;
+        if (source.isNumeric() && numericLiteral(lowerValue, lowerNum) && numericLiteral(upperValue, upperNum)) {
+            selectNumbers(source, store.getRowCount(), nullCellMatch(*this, columns), matches,
+                          [=](double x) { return (x >= lowerNum && x <= upperNum) == inside; });
+            return true;
+        }
+        int64_t lowerInstant, upperInstant;
+        if (isInstantColumn(source) && ColumnStore::parseInstant(source, lowerValue, lowerInstant) &&
+            ColumnStore::parseInstant(source, upperValue, upperInstant)) {
+            selectInstants(source, store.getRowCount(), nullCellMatch(*this, columns), matches,
+                           [=](int64_t x) { return (x >= lowerInstant && x <= upperInstant) == inside; });
+            return true;
+        }
+        selectByCell(*this, store, index, columns, matches);
+        return true;
+    }
+    
 private:
     std::unique_ptr<ConditionExpression> expr;
     std::unique_ptr<ConditionExpression> lower;
@@ -303,27 +663,66 @@ public:
                std::vector<std::unique_ptr<ConditionExpression>> valueList,
                bool notIn)
         : expr(std::move(expr)), valueList(std::move(valueList)), notIn(notIn) {}
-    bool evaluate(const std::vector<std::string>& row,
+    bool evaluate(const RowView& row,
                   const std::vector<std::string>& columns) const override {
         // Only makes sense for column expressions
         auto colExpr = dynamic_cast<ColumnExpression*>(expr.get());
         if (colExpr) {
             std::string colValue = colExpr->getStringValue(row, columns);
+            if (colValue.empty()) {
+                return false;   // NULL is neither in nor out of the list
+            }
             
-            // Check if the column value is in the list
+            // Check if the column value is in the list. A NULL in the list
+            // matches nothing, but leaves NOT IN unknown for the rest.
+            bool listHasNull = false;
             for (const auto& valueExpr : valueList) {
                 auto litExpr = dynamic_cast<LiteralExpression*>(valueExpr.get());
                 if (litExpr && litExpr->getStringValue() == colValue) {
                     return !notIn; // Found a match
                 }
+                listHasNull = listHasNull || (litExpr && litExpr->getStringValue().empty());
             }
             
-            return notIn; // No match found
+            return notIn && !listHasNull; // No match found
+        }
+        
+        return false;
+    }
+    
+    bool canMatchBlock(const BlockZone& zone,
+                       const std::vector<std::string>& columns) const override {
+        auto colExpr = dynamic_cast<ColumnExpression*>(expr.get());
+        const ColumnZone* columnZone = colExpr ? colExpr->getZone(zone, columns) : nullptr;
+        if (notIn || !columnZone) {
+            return true;
         }
         
+        // IN compares text exactly, so every value probes the text key
+        for (const auto& valueExpr : valueList) {
+            auto litExpr = dynamic_cast<LiteralExpression*>(valueExpr.get());
+            if (!litExpr) continue;
+            std::string value = litExpr->getStringValue();
+            if (!value.empty() && textZoneCanMatch(*columnZone, "=", value) &&
+                (columnZone->bloom.empty() || columnZone->bloom.mayContain(BloomFilter::textKey(value)))) {
+                return true;
+            }
+        }
         return false;
     }
     
+    bool selectColumnar(const ColumnStore& store,
+                        const std::vector<std::string>& columns,
+                        std::vector<uint8_t>& matches) const override {
+        auto colExpr = dynamic_cast<ColumnExpression*>(expr.get());
+        int index = colExpr ? colExpr->getStoreIndex(store, columns) : -1;
+        if (index < 0) {
+            return false;
+        }
+        selectByCell(*this, store, index, columns, matches);
+        return true;
+    }
+    
 private:
     std::unique_ptr<ConditionExpression> expr;
     std::vector<std::unique_ptr<ConditionExpression>> valueList;
@@ -511,7 +910,7 @@ ConditionExprPtr ConditionParser::parsePredicate() {
     // Check if it's a literal or column reference
     if (identifier.size() >= 2 && identifier.front() == '\'' && identifier.back() == '\'') {
         // String literal: 'value'
-        leftExpr = std::make_unique<LiteralExpression>(identifier.substr(1, identifier.size() - 2));
+        leftExpr = std::make_unique<LiteralExpression>(literalCell(identifier));
     } else if (std::isdigit(identifier[0]) || 
               (identifier.size() > 1 && identifier[0] == '-' && std::isdigit(identifier[1]))) {
         // Numeric literal: 123, -456
@@ -587,11 +986,14 @@ ConditionExprPtr ConditionParser::parseSimpleValue() {
     // Check if it's a literal or column reference
     if (value.size() >= 2 && value.front() == '\'' && value.back() == '\'') {
         // String literal: 'value'
-        return std::make_unique<LiteralExpression>(value.substr(1, value.size() - 2));
+        return std::make_unique<LiteralExpression>(literalCell(value));
     } else if (std::isdigit(value[0]) || 
               (value.size() > 1 && value[0] == '-' && std::isdigit(value[1]))) {
         // Numeric literal: 123, -456
         return std::make_unique<LiteralExpression>(value);
+    } else if (toUpperCase(value) == "NULL") {
+        // The NULL keyword, which nothing compares equal to
+        return std::make_unique<LiteralExpression>(literalCell(value));
     } else {
         // Column reference
         return std::make_unique<ColumnExpression>(value);
@@ -2,14 +2,51 @@
 #define CONDITIONPARSER_H
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <memory>
+#include <cstdint>
+
+// Read-only view of a row's cells. Wraps either owned strings or string_views
+// into a mapped table segment, so conditions are evaluated without copying.
+class RowView {
+public:
+    RowView(const std::vector<std::string>& cells) : strings(&cells) {}
+    RowView(const std::vector<std::string_view>& cells) : views(&cells) {}
+    
+    size_t size() const { return strings ? strings->size() : views->size(); }
+    std::string_view operator[](size_t index) const {
+        return strings ? std::string_view((*strings)[index]) : (*views)[index];
+    }
+
+private:
+    const std::vector<std::string>* strings = nullptr;
+    const std::vector<std::string_view>* views = nullptr;
+};
+
+struct BlockZone;
+class ColumnStore;
 
 class ConditionExpression {
 public:
     virtual ~ConditionExpression() = default;
-    virtual bool evaluate(const std::vector<std::string>& row,
+    virtual bool evaluate(const RowView& row,
                           const std::vector<std::string>& columns) const = 0;
+    // False only if no row summarized by zone can satisfy the condition, so
+    // a scan may skip the whole block
+    virtual bool canMatchBlock(const BlockZone& /*zone*/,
+                               const std::vector<std::string>& /*columns*/) const {
+        return true;
+    }
+    // Sets matches[r] (resized to the row count) for every row r of a packed
+    // column store that satisfies the condition, reading the typed columns
+    // directly. False when the condition has no columnar form; the caller
+    // then evaluates it row by row.
+    virtual bool selectColumnar(const ColumnStore& /*store*/,
+                                const std::vector<std::string>& /*columns*/,
+                                std::vector<uint8_t>& /*matches*/) const {
+        return false;
+    }
 };
 
 using ConditionExprPtr = std::unique_ptr<ConditionExpression>;
@@ -8,6 +8,7 @@
 #include "ConditionParser.h"
 #include "Parser.h"
 #include "ForeignKeyValidator.h"
+#include "RowArena.h"
 Database* _g_db = nullptr;
 // Add this at the top of Database.cpp after the includes
 bool validateForeignKeySimple(const Constraint& constraint, 
@@ -36,7 +37,7 @@ if (colIdx >= row.size()) {
 return false;
 }
 // Allow NULL values in FK
-if (row[colIdx].empty() || toLowerCase(row[colIdx]) == "null") {
+if (row[colIdx].empty()) {
 return true;
 }
 fkValues.push_back(row[colIdx]);
@@ -72,9 +73,14 @@ return false;
 // Create table
 void Database::createTable(const std::string& tableName,
     const std::vector<std::pair<std::string, std::string>>& cols,
-    const std::vector<Constraint>& constraints) {
+    const std::vector<Constraint>& constraints,
+    Table::StorageMode storageMode,
+    Table::PartitionKind partitionKind,
+    const std::string& partitionColumn,
+    const std::vector<Table::Partition>& partitions) {
     
     
+    std::unique_lock<std::mutex> stateLock(stateMutex);
     std::unique_lock<std::mutex> lock(databaseMutex);
     
     
@@ -116,14 +122,30 @@ void Database::createTable(const std::string& tableName,
         }
     }
     
-    // Get column names for registration
-    std::vector<std::string> columnNames;
-    for (const auto& col : cols) {
-        columnNames.push_back(col.first);
+    // A clustered table orders its rows by the PRIMARY KEY added above
+    table->setStorageMode(storageMode);
+    if (partitionKind != Table::PartitionKind::NONE) {
+        table->setPartitioning(partitionKind, partitionColumn, partitions);
     }
     
-    // Create callback function for value existence check
-    auto valueExists = [this, lowerName](const std::string& columnName, const std::string& value) -> bool {
+    // Add table to tables map first
+    tables[lowerName] = std::move(table);
+    
+    // Then register with FK validator
+    registerForeignKeyTable(lowerName);
+    
+    std::cout << "Table " << tableName << " created." << std::endl;
+    
+    lock.unlock();
+    stateLock.unlock();
+    schemaChanged({lowerName});
+}
+// Registers a table with the FK validator. The callbacks look the table up by
+// key on every call, so they stay valid when a rollback swaps the table object.
+void Database::registerForeignKeyTable(const std::string& tableKey) {
+    Table* registeredTable = tables[tableKey].get();
+    
+    auto valueExists = [this, tableKey](const std::string& columnName, const std::string& value) -> bool {
         std::string condition = columnName + " = '" + value + "'";
         std::vector<std::string> selectColumns = {columnName};
         
@@ -132,7 +154,7 @@ void Database::createTable(const std::string& tableName,
             Table* table;
             {
                 std::lock_guard<std::mutex> tempLock(this->databaseMutex);
-                auto tableIt = this->tables.find(lowerName);
+                auto tableIt = this->tables.find(tableKey);
                 if (tableIt == this->tables.end()) return false;
                 table = tableIt->second.get();
             }
@@ -147,42 +169,41 @@ void Database::createTable(const std::string& tableName,
         }
     };
     
-    // Create callback function for getting all rows
-    auto getAllRows = [this, lowerName]() -> std::vector<std::vector<std::string>> {
+    auto getAllRows = [this, tableKey]() -> std::vector<std::vector<std::string>> {
         try {
-            // Use a temporary lock to avoid deadlocks
             Table* table;
             {
                 std::lock_guard<std::mutex> tempLock(this->databaseMutex);
-                auto tableIt = this->tables.find(lowerName);
+                auto tableIt = this->tables.find(tableKey);
                 if (tableIt == this->tables.end()) return {};
                 table = tableIt->second.get();
             }
             
             if (!table) return {};
             
-            // Return a copy of all rows
-            return table->getRows();
+            // Return a copy of all rows, read in place so a packed table
+            // stays packed
+            std::vector<std::vector<std::string>> copied;
+            table->forEachRow([&](const RowView& row) {
+                std::vector<std::string>& copy = copied.emplace_back();
+                copy.reserve(row.size());
+                for (size_t i = 0; i < row.size(); ++i) {
+                    copy.emplace_back(row[i]);
+                }
+            });
+            return copied;
         } catch (const std::exception& e) {
             std::cout << "Error getting rows: " << e.what() << std::endl;
             return {};
         }
     };
     
-   
-    
-    
-    // Add table to tables map first
-    tables[lowerName] = std::move(table);
-    
-    // Then register with FK validator
-    ForeignKeyValidator::getInstance().registerTable(tableName, columnNames, valueExists, getAllRows);
-    
-    std::cout << "Table " << tableName << " created." << std::endl;
-    
+    ForeignKeyValidator::getInstance().registerTable(registeredTable->getName(), registeredTable->getColumns(),
+                                                     valueExists, getAllRows);
 }
 // Modify the dropTable method to unregister from FK validator
 void Database::dropTable(const std::string& tableName) {
+    std::unique_lock<std::mutex> stateLock(stateMutex);
     std::string lowerName = toLowerCase(tableName);
     
     // Unregister from FK validator first
@@ -196,8 +217,12 @@ void Database::dropTable(const std::string& tableName) {
         std::cout << "Table " << tableName << " does not exist." << std::endl;
         
     }
+    
+    stateLock.unlock();
+    schemaChanged({lowerName});
 }
 void Database::alterTableAddColumn(const std::string& tableName, const std::pair<std::string, std::string>& column, bool isNotNull) {
+    std::unique_lock<std::mutex> stateLock(stateMutex);
     std::string lowerName = toLowerCase(tableName);
     if (tables.find(lowerName) == tables.end()) {
         std::cout << "Table " << tableName << " does not exist." << std::endl;
@@ -207,8 +232,11 @@ void Database::alterTableAddColumn(const std::string& tableName, const std::pair
     tables[lowerName]->addColumn(column.first, column.second);
     std::cout << "Column " << column.first << " added to " << tableName << "." << std::endl;
     
+    stateLock.unlock();
+    schemaChanged({lowerName});
 }
 void Database::alterTableDropColumn(const std::string& tableName, const std::string& columnName) {
+    std::unique_lock<std::mutex> stateLock(stateMutex);
     std::string lowerName = toLowerCase(tableName);
     if (tables.find(lowerName) == tables.end()) {
         std::cout << "Table " << tableName << " does not exist." << std::endl;
@@ -222,6 +250,9 @@ void Database::alterTableDropColumn(const std::string& tableName, const std::str
     else{
         std::cout << "Column " << columnName << " does not exist in " << tableName << "." << std::endl;
         }
+    
+    stateLock.unlock();
+    schemaChanged({lowerName});
 }
 void Database::describeTable(const std::string& tableName) {
     std::string lowerName = toLowerCase(tableName);
@@ -236,9 +267,47 @@ void Database::describeTable(const std::string& tableName) {
     for (const auto& col : cols)
         std::cout << col << "\t";
     std::cout << std::endl;
+    const Table& table = *tables[lowerName];
+    if (table.getStorageMode() == Table::StorageMode::COLUMN) {
+        std::cout << "Storage: column" << std::endl;
+    } else if (table.getStorageMode() == Table::StorageMode::CLUSTERED) {
+        std::cout << "Storage: clustered on (";
+        for (size_t i = 0; i < table.getClusterColumns().size(); ++i) {
+            std::cout << (i ? ", " : "") << table.getClusterColumns()[i];
+        }
+        std::cout << ")" << std::endl;
+    }
+    if (table.isPartitioned()) {
+        std::cout << "Partitioned by " << Table::partitionKindName(table.getPartitionKind()) << " ("
+                  << table.getPartitionColumn() << "):" << std::endl;
+        const auto& partitions = table.getPartitions();
+        for (size_t p = 0; p < partitions.size(); ++p) {
+            const auto& partition = partitions[p];
+            std::cout << "  " << partition.name;
+            if (table.getPartitionKind() == Table::PartitionKind::RANGE) {
+                std::cout << " VALUES LESS THAN "
+                          << (partition.values.empty() ? "MAXVALUE" : std::string(displayCell(partition.values[0])));
+            } else if (table.getPartitionKind() == Table::PartitionKind::LIST) {
+                std::cout << " VALUES IN (";
+                for (size_t i = 0; i < partition.values.size(); ++i) {
+                    std::cout << (i ? ", " : "") << displayCell(partition.values[i]);
+                }
+                std::cout << ")";
+            }
+            if (table.isPartitionCold(p)) {
+                std::cout << " (cold)";
+            }
+            std::cout << std::endl;
+        }
+        if (table.getColdPolicy() != Table::ColdPolicy::NONE) {
+            std::cout << "Cold after " << table.getColdAfter()
+                      << (table.getColdPolicy() == Table::ColdPolicy::AGE ? " days" : " idle seconds") << std::endl;
+        }
+    }
 }
 // Enhanced version with more debugging
 void Database::insertRecord(const std::string& tableName, const std::vector<std::vector<std::string>>& values) {
+    std::unique_lock<std::mutex> stateLock(stateMutex);
     std::string lowerName = toLowerCase(tableName);
     
     
@@ -254,6 +323,12 @@ void Database::insertRecord(const std::string& tableName, const std::vector<std:
     
     Table* table = tables[lowerName].get();
     
+    WalRecord record;
+    record.type = WalRecordType::INSERT;
+    record.tableName = tableName;
+    record.rows = values;
+    uint64_t lsn = logStatement(record);
+    
     // Track successful insertions
     int successCount = 0;
     
@@ -279,6 +354,9 @@ void Database::insertRecord(const std::string& tableName, const std::vector<std:
     
     
     
+    stateLock.unlock();
+    commitStatement(lsn);
+    
     if (successCount > 0) {
         std::cout << successCount << " record(s) inserted into " << tableName << "." << std::endl;
     } else {
@@ -351,7 +429,7 @@ void Database::selectRecords(const std::string& tableName,
             // Print each row
             for (const auto& row : result) {
                 for (const auto& val : row) {
-                    std::cout << val << "\t";
+                    std::cout << displayCell(val) << "\t";
                 }
                 std::cout << "\n";
             }
@@ -380,7 +458,7 @@ void Database::selectRecords(const std::string& tableName,
         // Print each row
         for (const auto& row : result) {
             for (const auto& val : row) {
-                std::cout << val << "\t";
+                std::cout << displayCell(val) << "\t";
             }
             std::cout << "\n";
         }
@@ -502,33 +580,60 @@ void Database::selectRecords(const std::string& tableName,
         // Print results
         for (const auto& row : joinResult) {
             for (const auto& value : row) {
-                std::cout << value << "\t";
+                std::cout << displayCell(value) << "\t";
             }
             std::cout << std::endl;
         }
     }
 }
 void Database::deleteRecords(const std::string& tableName, const std::string& condition) {
+    std::unique_lock<std::mutex> stateLock(stateMutex);
     std::string lowerName = toLowerCase(tableName);
     if (tables.find(lowerName) == tables.end()) {
         std::cout << "Table " << tableName << " does not exist." << std::endl;
         
         return;
     }
+    
+    WalRecord record;
+    record.type = WalRecordType::DELETE;
+    record.tableName = tableName;
+    record.arguments = {condition};
+    uint64_t lsn = logStatement(record);
+    
     tables[lowerName]->deleteRows(condition);
+    bool compact = tables[lowerName]->needsCompaction();
+    stateLock.unlock();
+    commitStatement(lsn);
+    if (compact) {
+        requestCompaction();
+    }
     std::cout << "Records deleted from " << tableName << "." << std::endl;
     
 }
 void Database::updateRecords(const std::string& tableName,
                              const std::vector<std::pair<std::string, std::string>>& updates,
                              const std::string& condition) {
+    std::unique_lock<std::mutex> stateLock(stateMutex);
     std::string lowerName = toLowerCase(tableName);
     if (tables.find(lowerName) == tables.end()) {
         std::cout << "Table " << tableName << " does not exist." << std::endl;
         
         return;
     }
+    
+    WalRecord record;
+    record.type = WalRecordType::UPDATE;
+    record.tableName = tableName;
+    record.arguments = {condition};
+    for (const auto& update : updates) {
+        record.rows.push_back({update.first, update.second});
+    }
+    uint64_t lsn = logStatement(record);
+    
     tables[lowerName]->updateRows(updates, condition);
+    stateLock.unlock();
+    commitStatement(lsn);
     std::cout << "Records updated in " << tableName << "." << std::endl;
     
 }
@@ -538,11 +643,63 @@ void Database::showTables() {
     for (const auto& pair : tables)
         std::cout << pair.first << std::endl;
 }
+void Database::showTableStats(const std::string& tableName) {
+    std::unique_lock<std::mutex> stateLock(stateMutex);
+    std::vector<std::string> names;
+    if (!tableName.empty()) {
+        std::string lowerName = toLowerCase(tableName);
+        if (tables.find(lowerName) == tables.end()) {
+            std::cout << "Table " << tableName << " does not exist." << std::endl;
+            return;
+        }
+        names.push_back(lowerName);
+    } else {
+        for (const auto& pair : tables) {
+            names.push_back(pair.first);
+        }
+        std::sort(names.begin(), names.end());
+    }
+    std::cout << "Table\tRows\tAvg row\tPayload\tStore\tHeap\tIndexes\tBackup\tTotal" << std::endl;
+    Table::MemoryStats sum;
+    size_t backupSum = 0;
+    for (const auto& name : names) {
+        const Table& table = *tables[name];
+        Table::MemoryStats stats = table.getMemoryStats();
+        // Rollback copy taken by BEGIN TRANSACTION, less the chunks it still
+        // shares with the table
+        auto backup = backupTables.find(name);
+        size_t backupBytes = 0;
+        if (backup != backupTables.end()) {
+            Table::MemoryStats backupStats = backup->second->getMemoryStats();
+            backupBytes = backupStats.total() - backupStats.sharedBytes;
+        }
+        std::cout << table.getName() << "\t";
+        if (!table.isLoaded()) {
+            std::cout << "(not loaded)" << std::endl;
+            continue;
+        }
+        std::cout << stats.rowCount << "\t" << (stats.rowCount ? stats.payloadBytes / stats.rowCount : 0) << "\t"
+                  << stats.payloadBytes << "\t" << stats.storeBytes << "\t" << stats.heapBytes << "\t"
+                  << stats.indexBytes << "\t" << backupBytes << "\t" << stats.total() + backupBytes << std::endl;
+        sum.rowCount += stats.rowCount;
+        sum.payloadBytes += stats.payloadBytes;
+        sum.storeBytes += stats.storeBytes;
+        sum.heapBytes += stats.heapBytes;
+        sum.indexBytes += stats.indexBytes;
+        backupSum += backupBytes;
+    }
+    if (names.size() > 1) {
+        std::cout << "TOTAL\t" << sum.rowCount << "\t" << (sum.rowCount ? sum.payloadBytes / sum.rowCount : 0) << "\t"
+                  << sum.payloadBytes << "\t" << sum.storeBytes << "\t" << sum.heapBytes << "\t" << sum.indexBytes
+                  << "\t" << backupSum << "\t" << sum.total() + backupSum << std::endl;
+    }
+}
 // Transaction functions
 // In Database.cpp, fix the beginTransaction method
 // Fix for Database.cpp: beginTransaction method
 // Begin Transaction
 Transaction* Database::beginTransaction() {
+    std::unique_lock<std::mutex> stateLock(stateMutex);
     std::unique_lock<std::mutex> lock(databaseMutex);
     
     if (inTransaction) {
@@ -553,28 +710,16 @@ Transaction* Database::beginTransaction() {
     // Set transaction flag
     inTransaction = true;
     
-    // Create backup of tables for potential rollback
+    // LSNs only grow, so the next one doubles as a transaction id that stays
+    // unique across restarts
+    currentTransactionId = wal.isOpen() ? wal.getLastLsn() + 1 : 0;
+    
+    // Create backup of tables for potential rollback. Snapshots share the
+    // tables' row chunks (and files), so this copies no rows; constraints
+    // are left out to avoid validation loops.
     backupTables.clear();
     for (const auto& [name, tablePtr] : tables) {
-        auto tableCopy = std::make_unique<Table>(tablePtr->getName());
-        
-        // Copy columns and types without validation
-        const auto& columns = tablePtr->getColumns();
-        const auto& columnTypes = tablePtr->getColumnTypes();
-        const auto& notNullConstraints = tablePtr->getNotNullConstraints();
-        
-        for (size_t i = 0; i < columns.size(); ++i) {
-            tableCopy->addColumn(columns[i], columnTypes[i], notNullConstraints[i]);
-        }
-        
-        // Skip constraint copying during backup to avoid validation loops
-        
-        // Copy rows directly without validation
-        for (const auto& row : tablePtr->getRows()) {
-            tableCopy->addRowDirect(row);
-        }
-        
-        backupTables[name] = std::move(tableCopy);
+        backupTables[name] = tablePtr->snapshot();
     }
     
     std::cout << "Transaction started." << std::endl;
@@ -582,6 +727,7 @@ Transaction* Database::beginTransaction() {
 }
 // Commit Transaction
 Transaction* Database::commitTransaction() {
+    std::unique_lock<std::mutex> stateLock(stateMutex);
     std::unique_lock<std::mutex> lock(databaseMutex);
     
     
@@ -590,18 +736,44 @@ Transaction* Database::commitTransaction() {
         return nullptr;
     }
     
+    uint64_t commitLsn = 0;
+    if (wal.isOpen() && !replayingLog) {
+        WalRecord record;
+        record.type = WalRecordType::COMMIT;
+        record.transactionId = currentTransactionId;
+        commitLsn = wal.append(record);
+    }
+    
     // On commit, we just discard the backups
     backupTables.clear();
     
     // Clear transaction flag
     inTransaction = false;
     
+    bool schemaCheckpoint = checkpointAfterCommit;
+    checkpointAfterCommit = false;
+    std::set<std::string> schemaTables;
+    schemaTables.swap(checkpointTables);
+    lock.unlock();
+    stateLock.unlock();
+    
+    // Make the transaction durable before acknowledging it
+    if (commitLsn != 0) {
+        wal.commit(commitLsn);
+        if (schemaCheckpoint) {
+            writeCheckpoint(false, &schemaTables);
+        } else if (wal.getSize() >= checkpointWalBytes) {
+            requestCheckpoint();
+        }
+    }
+    
     std::cout << "Transaction committed." << std::endl;
     return nullptr;
 }
 // Rollback Transaction
 // Rollback Transaction
 Transaction* Database::rollbackTransaction() {
+    std::unique_lock<std::mutex> stateLock(stateMutex);
     std::unique_lock<std::mutex> lock(databaseMutex);
     
     
@@ -610,6 +782,13 @@ Transaction* Database::rollbackTransaction() {
         return nullptr;
     }
     
+    if (wal.isOpen() && !replayingLog) {
+        WalRecord record;
+        record.type = WalRecordType::ABORT;
+        record.transactionId = currentTransactionId;
+        wal.append(record);
+    }
+    
     // Restore from backups
     // We need to unregister each table from the FK validator first
     for (const auto& pair : tables) {
@@ -619,58 +798,11 @@ Transaction* Database::rollbackTransaction() {
     // Now restore from backups
     tables.clear();
     for (auto& pair : backupTables) {
-        std::string tableName = pair.second->getName();
         std::string tableKey = pair.first;
-        std::vector<std::string> columnNames = pair.second->getColumns();
         
         // Move the table to the main tables collection first
         tables[tableKey] = std::move(pair.second);
-        
-        // Create callback functions for the restored table using the key
-        auto valueExists = [this, tableKey](const std::string& columnName, const std::string& value) -> bool {
-            std::string condition = columnName + " = '" + value + "'";
-            std::vector<std::string> selectColumns = {columnName};
-            
-            try {
-                Table* table;
-                {
-                    std::lock_guard<std::mutex> tempLock(this->databaseMutex);
-                    auto tableIt = this->tables.find(tableKey);
-                    if (tableIt == this->tables.end()) return false;
-                    table = tableIt->second.get();
-                }
-                
-                if (!table) return false;
-                
-                auto result = table->selectRows(selectColumns, condition);
-                return !result.empty();
-            } catch (const std::exception& e) {
-                std::cout << "Error in value check: " << e.what() << std::endl;
-                return false;
-            }
-        };
-        
-        auto getAllRows = [this, tableKey]() -> std::vector<std::vector<std::string>> {
-            try {
-                Table* table;
-                {
-                    std::lock_guard<std::mutex> tempLock(this->databaseMutex);
-                    auto tableIt = this->tables.find(tableKey);
-                    if (tableIt == this->tables.end()) return {};
-                    table = tableIt->second.get();
-                }
-                
-                if (!table) return {};
-                
-                return table->getRows();
-            } catch (const std::exception& e) {
-                std::cout << "Error getting rows: " << e.what() << std::endl;
-                return {};
-            }
-        };
-        
-        // Register with FK validator
-        ForeignKeyValidator::getInstance().registerTable(tableName, columnNames, valueExists, getAllRows);
+        registerForeignKeyTable(tableKey);
     }
     
     // Clear backups
@@ -678,12 +810,15 @@ Transaction* Database::rollbackTransaction() {
     
     // Clear transaction flag
     inTransaction = false;
+    checkpointAfterCommit = false;
+    checkpointTables.clear();
     
     std::cout << "Transaction rolled back." << std::endl;
     return nullptr;
 }
 // New functionalities
 void Database::truncateTable(const std::string& tableName) {
+    std::unique_lock<std::mutex> stateLock(stateMutex);
     std::string lowerName = toLowerCase(tableName);
     if (tables.find(lowerName) == tables.end()) {
         std::cout << "Table " << tableName << " does not exist." << std::endl;
@@ -693,8 +828,11 @@ void Database::truncateTable(const std::string& tableName) {
     tables[lowerName]->clearRows();
     std::cout << "Table " << tableName << " truncated." << std::endl;
     
+    stateLock.unlock();
+    schemaChanged({lowerName});
 }
 void Database::renameTable(const std::string& oldName, const std::string& newName) {
+    std::unique_lock<std::mutex> stateLock(stateMutex);
     std::string lowerOld = toLowerCase(oldName);
     std::string lowerNew = toLowerCase(newName);
     if (tables.find(lowerOld) == tables.end()) {
@@ -704,8 +842,11 @@ void Database::renameTable(const std::string& oldName, const std::string& newNam
     }
     tables[lowerNew] = std::move(tables[lowerOld]);
     tables.erase(lowerOld);
+    tables[lowerNew]->tableName = newName;
     std::cout << "Table " << oldName << " renamed to " << newName << "." << std::endl;
     
+    stateLock.unlock();
+    schemaChanged({lowerOld, lowerNew});
 }
 void Database::createIndex(const std::string& indexName, const std::string& tableName, const std::string& columnName) {
     std::string lowerTable = toLowerCase(tableName);
@@ -728,6 +869,7 @@ void Database::dropIndex(const std::string& indexName) {
         }
 }
 void Database::mergeRecords(const std::string& tableName, const std::string& mergeCommand) {
+    std::unique_lock<std::mutex> stateLock(stateMutex);
     // --- Step 1: Locate key clauses ---
     // Expected syntax:
     // MERGE INTO tableName USING (SELECT ... AS col, ... ) AS src
@@ -776,9 +918,7 @@ void Database::mergeRecords(const std::string& tableName, const std::string& mer
         std::string literal = trim(trimmedExpr.substr(0, asPos));
         std::string alias = trim(trimmedExpr.substr(asPos + 2));
         // Remove quotes if the literal is quoted.
-        if (!literal.empty() && literal.front() == '\'' && literal.back() == '\'' && literal.size() > 1)
-            literal = literal.substr(1, literal.size() - 2);
-        srcRecord[toLowerCase(alias)] = literal;
+        srcRecord[toLowerCase(alias)] = literalCell(literal);
     }
     
     // --- Step 3: Parse the ON clause ---
@@ -821,8 +961,8 @@ void Database::mergeRecords(const std::string& tableName, const std::string& mer
                 if (srcRecord.find(refCol) != srcRecord.end()) {
                     val = srcRecord[refCol];
                 }
-            } else if (!val.empty() && val.front() == '\'' && val.back() == '\'' && val.size() > 1) {
-                val = val.substr(1, val.size() - 2);
+            } else {
+                val = literalCell(val);
             }
             updateAssignments[col] = val;
         }
@@ -846,8 +986,8 @@ void Database::mergeRecords(const std::string& tableName, const std::string& mer
             std::string refCol = toLowerCase(trim(val.substr(pos + 4)));
             if (srcRecord.find(refCol) != srcRecord.end())
                 val = srcRecord[refCol];
-        } else if (!val.empty() && val.front() == '\'' && val.back() == '\'' && val.size() > 1) {
-            val = val.substr(1, val.size() - 2);
+        } else {
+            val = literalCell(val);
         }
     }
     
@@ -871,20 +1011,32 @@ void Database::mergeRecords(const std::string& tableName, const std::string& mer
         return;
     }
     
+    WalRecord record;
+    record.type = WalRecordType::MERGE;
+    record.tableName = tableName;
+    record.arguments = {mergeCommand};
+    uint64_t lsn = logStatement(record);
+    
     bool matched = false;
     // Check each row for a match on the ON condition.
-    for (auto &row : tables[lowerTable]->getRowsNonConst()) {
-        if (row.size() > targetIndex && toLowerCase(row[targetIndex]) == toLowerCase(srcRecord[srcColumn])) {
-            // When matched, update the row using the UPDATE assignments.
-            for (size_t j = 0; j < targetCols.size(); j++) {
-                std::string colName = toLowerCase(targetCols[j]);
-                if (updateAssignments.find(colName) != updateAssignments.end()) {
-                    row[j] = updateAssignments[colName];
-                }
+    std::string sourceKey = toLowerCase(srcRecord[srcColumn]);
+    tables[lowerTable]->rewriteRows([&](const RowView& row, std::vector<std::string>& newRow) {
+        if (row.size() <= static_cast<size_t>(targetIndex) ||
+            toLowerCase(std::string(row[targetIndex])) != sourceKey) {
+            return false;
+        }
+        // When matched, update the row using the UPDATE assignments.
+        newRow.assign(targetCols.size(), "");
+        for (size_t j = 0; j < targetCols.size() && j < row.size(); j++) {
+            newRow[j] = row[j];
+            std::string colName = toLowerCase(targetCols[j]);
+            if (updateAssignments.find(colName) != updateAssignments.end()) {
+                newRow[j] = updateAssignments[colName];
             }
-            matched = true;
         }
-    }
+        matched = true;
+        return true;
+    });
     
     if (!matched) {
         // No matching row found; build a new row using the INSERT values.
@@ -899,27 +1051,40 @@ void Database::mergeRecords(const std::string& tableName, const std::string& mer
         tables[lowerTable]->addRow(newRow);
     }
     
+    stateLock.unlock();
+    commitStatement(lsn);
     std::cout << "MERGE command executed on " << tableName << "." << std::endl;
 }
 void Database::replaceInto(const std::string& tableName, const std::vector<std::vector<std::string>>& values) {
+    std::unique_lock<std::mutex> stateLock(stateMutex);
     std::string lowerName = toLowerCase(tableName);
     if (tables.find(lowerName) == tables.end()) {
         std::cout << "Table " << tableName << " does not exist." << std::endl;
         return;
     }
+    
+    WalRecord record;
+    record.type = WalRecordType::REPLACE;
+    record.tableName = tableName;
+    record.rows = values;
+    uint64_t lsn = logStatement(record);
+    
     for (const auto& row : values) {
         bool replaced = false;
-        for (auto& existingRow : tables[lowerName]->getRowsNonConst()) {
-            if (!existingRow.empty() && !row.empty() && existingRow[0] == row[0]) {
-                existingRow = row;
-                replaced = true;
-                break;
+        tables[lowerName]->rewriteRows([&](const RowView& existingRow, std::vector<std::string>& newRow) {
+            if (replaced || existingRow.size() == 0 || row.empty() || existingRow[0] != row[0]) {
+                return false;
             }
-        }
+            newRow = row;
+            replaced = true;
+            return true;
+        });
         if (!replaced) {
             tables[lowerName]->addRow(row);
         }
     }
+    stateLock.unlock();
+    commitStatement(lsn);
     std::cout << "REPLACE INTO executed on " << tableName << "." << std::endl;
 }
 // Add these implementations to Database.cpp
@@ -932,7 +1097,12 @@ Database::Database() {
     users["admin"] = User("admin", "admin");
 }
 Database::~Database() {
-    // Clean up any resources
+    // Stop the checkpointer and write a final checkpoint
+    try {
+        close();
+    } catch (const std::exception& e) {
+        std::cerr << "Error closing database: " << e.what() << std::endl;
+    }
     // For tables, the unique_ptr will automatically clean up
 }
 // Authentication and authorization
@@ -1066,6 +1236,7 @@ void Database::createType(const std::string& typeName, const std::vector<std::pa
 }
 // View management
 void Database::createView(const std::string& viewName, const std::string& viewDefinition) {
+    std::unique_lock<std::mutex> stateLock(stateMutex);
     std::string lowerName = toLowerCase(viewName);
     if (views.find(lowerName) != views.end() || tables.find(lowerName) != tables.end()) {
         std::cout << "View or table '" << viewName << "' already exists." << std::endl;
@@ -1078,8 +1249,12 @@ void Database::createView(const std::string& viewName, const std::string& viewDe
     catalog.addView(viewName, viewDefinition);
     
     std::cout << "View " << viewName << " created." << std::endl;
+    
+    stateLock.unlock();
+    schemaChanged({});
 }
 void Database::dropView(const std::string& viewName) {
+    std::unique_lock<std::mutex> stateLock(stateMutex);
     std::string lowerName = toLowerCase(viewName);
     if (views.find(lowerName) == views.end()) {
         std::cout << "View '" << viewName << "' does not exist." << std::endl;
@@ -1092,6 +1267,9 @@ void Database::dropView(const std::string& viewName) {
     catalog.removeView(viewName);
     
     std::cout << "View " << viewName << " dropped." << std::endl;
+    
+    stateLock.unlock();
+    schemaChanged({});
 }
 // Assertion management
 void Database::createAssertion(const std::string& name, const std::string& condition) {
@@ -1118,6 +1296,7 @@ void Database::createAssertion(const std::string& name, const std::string& condi
 }
 // Table modification
 void Database::alterTableAddConstraint(const std::string& tableName, const Constraint& constraint) {
+    std::unique_lock<std::mutex> stateLock(stateMutex);
     std::string lowerName = toLowerCase(tableName);
     if (tables.find(lowerName) == tables.end()) {
         std::cout << "Table '" << tableName << "' does not exist." << std::endl;
@@ -1131,8 +1310,12 @@ void Database::alterTableAddConstraint(const std::string& tableName, const Const
     } catch (const std::exception& e) {
         std::cout << "Failed to add constraint: " << e.what() << std::endl;
     }
+    
+    stateLock.unlock();
+    schemaChanged({lowerName});
 }
 void Database::alterTableDropConstraint(const std::string& tableName, const std::string& constraintName) {
+    std::unique_lock<std::mutex> stateLock(stateMutex);
     std::string lowerName = toLowerCase(tableName);
     if (tables.find(lowerName) == tables.end()) {
         std::cout << "Table '" << tableName << "' does not exist." << std::endl;
@@ -1145,6 +1328,125 @@ void Database::alterTableDropConstraint(const std::string& tableName, const std:
     } else {
         std::cout << "Constraint " << constraintName << " does not exist in " << tableName << "." << std::endl;
     }
+    
+    stateLock.unlock();
+    schemaChanged({lowerName});
+}
+void Database::alterTableAddBloomFilter(const std::string& tableName, const std::vector<std::string>& columnNames) {
+    std::unique_lock<std::mutex> stateLock(stateMutex);
+    std::string lowerName = toLowerCase(tableName);
+    if (tables.find(lowerName) == tables.end()) {
+        std::cout << "Table '" << tableName << "' does not exist." << std::endl;
+        return;
+    }
+    
+    try {
+        // Check every column first so that a typo adds no filter at all
+        for (const auto& columnName : columnNames) {
+            if (!tables[lowerName]->hasColumn(columnName)) {
+                throw DatabaseException("Column '" + columnName + "' does not exist");
+            }
+        }
+        for (const auto& columnName : columnNames) {
+            tables[lowerName]->addBloomFilter(columnName);
+        }
+        std::cout << "Bloom filter added to " << tableName << "." << std::endl;
+    } catch (const std::exception& e) {
+        std::cout << "Failed to add Bloom filter: " << e.what() << std::endl;
+    }
+    
+    stateLock.unlock();
+    schemaChanged({lowerName});
+}
+void Database::alterTableDropBloomFilter(const std::string& tableName, const std::vector<std::string>& columnNames) {
+    std::unique_lock<std::mutex> stateLock(stateMutex);
+    std::string lowerName = toLowerCase(tableName);
+    if (tables.find(lowerName) == tables.end()) {
+        std::cout << "Table '" << tableName << "' does not exist." << std::endl;
+        return;
+    }
+    
+    for (const auto& columnName : columnNames) {
+        if (tables[lowerName]->dropBloomFilter(columnName)) {
+            std::cout << "Bloom filter on " << columnName << " dropped from " << tableName << "." << std::endl;
+        } else {
+            std::cout << "Column " << columnName << " has no Bloom filter in " << tableName << "." << std::endl;
+        }
+    }
+    
+    stateLock.unlock();
+    schemaChanged({lowerName});
+}
+void Database::alterTableAddPartition(const std::string& tableName, Table::PartitionKind kind,
+                                      const Table::Partition& partition) {
+    std::unique_lock<std::mutex> stateLock(stateMutex);
+    std::string lowerName = toLowerCase(tableName);
+    if (tables.find(lowerName) == tables.end()) {
+        std::cout << "Table '" << tableName << "' does not exist." << std::endl;
+        return;
+    }
+    
+    try {
+        Table& table = *tables[lowerName];
+        if (kind != table.getPartitionKind()) {
+            throw DatabaseException("Table '" + tableName + "' is partitioned by " +
+                                    Table::partitionKindName(table.getPartitionKind()) + ", not " +
+                                    Table::partitionKindName(kind));
+        }
+        table.addPartition(partition);
+        std::cout << "Partition " << partition.name << " added to " << tableName << "." << std::endl;
+    } catch (const std::exception& e) {
+        std::cout << "Failed to add partition: " << e.what() << std::endl;
+        return;
+    }
+    
+    stateLock.unlock();
+    schemaChanged({lowerName});
+}
+void Database::alterTableDropPartition(const std::string& tableName, const std::string& partitionName) {
+    std::unique_lock<std::mutex> stateLock(stateMutex);
+    std::string lowerName = toLowerCase(tableName);
+    if (tables.find(lowerName) == tables.end()) {
+        std::cout << "Table '" << tableName << "' does not exist." << std::endl;
+        return;
+    }
+    
+    try {
+        size_t dropped = tables[lowerName]->dropPartition(partitionName);
+        std::cout << "Partition " << partitionName << " dropped from " << tableName << "; " << dropped
+                  << " record(s) removed." << std::endl;
+    } catch (const std::exception& e) {
+        std::cout << "Failed to drop partition: " << e.what() << std::endl;
+        return;
+    }
+    
+    stateLock.unlock();
+    schemaChanged({lowerName});
+}
+void Database::alterTableSetColdPolicy(const std::string& tableName, Table::ColdPolicy policy, uint32_t after) {
+    std::unique_lock<std::mutex> stateLock(stateMutex);
+    std::string lowerName = toLowerCase(tableName);
+    if (tables.find(lowerName) == tables.end()) {
+        std::cout << "Table '" << tableName << "' does not exist." << std::endl;
+        return;
+    }
+    
+    try {
+        tables[lowerName]->setColdPolicy(policy, after);
+        if (policy == Table::ColdPolicy::NONE) {
+            std::cout << "Partitions of " << tableName << " stay in memory." << std::endl;
+        } else {
+            std::cout << "Partitions of " << tableName << " turn cold after " << after
+                      << (policy == Table::ColdPolicy::AGE ? " days." : " idle seconds.") << std::endl;
+        }
+    } catch (const std::exception& e) {
+        std::cout << "Failed to set cold policy: " << e.what() << std::endl;
+        return;
+    }
+    
+    stateLock.unlock();
+    schemaChanged({lowerName});
+    requestCompaction();
 }
 // Reference validation
 void Database::validateReferences(const Constraint& constraint) {
@@ -1227,7 +1529,7 @@ std::cout << std::endl;
 // Display results
 for (const auto& row : result) {
 for (const auto& cell : row) {
-std::cout << cell << "\t";
+std::cout << displayCell(cell) << "\t";
 }
 std::cout << std::endl;
 }
@@ -1280,7 +1582,7 @@ void Database::joinTables(const std::string& leftTable,
     
     for (const auto& row : result) {
         for (const auto& cell : row) {
-            std::cout << cell << "\t";
+            std::cout << displayCell(cell) << "\t";
         }
         std::cout << std::endl;
     }
@@ -1406,4 +1708,430 @@ void Database::showIndexes() {
         std::cout << "  " << indexPair.first << " on " 
                  << indexPair.second.first << "(" << indexPair.second.second << ")" << std::endl;
     }
-}
\ No newline at end of file
+}
+// Durability
+// ----------
+// Discards std::cout output while the log is replayed, so recovery does not
+// echo every statement it re-applies
+class SilencedOutput {
+public:
+    SilencedOutput() : saved(std::cout.rdbuf(nullptr)) {}
+    ~SilencedOutput() {
+        std::cout.rdbuf(saved);
+        std::cout.clear();
+    }
+private:
+    std::streambuf* saved;
+};
+void Database::open(const std::string& dbName) {
+    if (wal.isOpen()) {
+        throw DatabaseException("Database " + databaseName + " is already open");
+    }
+    databaseName = dbName;
+    
+    // Start from the last checkpoint
+    std::map<std::string, Table*> loadedTables;
+    std::map<std::string, std::string> loadedViews;
+    checkpointLsn = storage.loadCheckpoint(dbName, loadedTables, loadedViews);
+    for (const auto& [tableKey, table] : loadedTables) {
+        tables[tableKey].reset(table);
+        registerForeignKeyTable(tableKey);
+    }
+    for (const auto& [viewName, viewDef] : loadedViews) {
+        views[viewName] = viewDef;
+        catalog.addView(viewName, viewDef);
+    }
+    
+    // Then re-apply what was committed after it; only the log tail is read
+    std::string logPath = dbName + ".wal";
+    size_t failed = 0;
+    size_t replayed = replayLog(WriteAheadLog::readLog(logPath), failed);
+    wal.open(logPath, checkpointLsn);
+    
+    std::cout << "Database " << dbName << " opened: " << tables.size() << " table(s), "
+              << replayed << " log record(s) replayed, " << failed << " failed (sync policy "
+              << WriteAheadLog::syncPolicyName(wal.getSyncPolicy()) << ")." << std::endl;
+    
+    // Fold the replayed tail into a checkpoint so the next start is quick
+    if (replayed > 0) {
+        writeCheckpoint(false);
+    }
+    
+    stopCheckpointer = false;
+    checkpointer = std::thread(&Database::checkpointerLoop, this);
+}
+void Database::close() {
+    if (checkpointer.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(checkpointerMutex);
+            stopCheckpointer = true;
+        }
+        checkpointerWake.notify_all();
+        checkpointer.join();
+    }
+    
+    if (!wal.isOpen()) {
+        return;
+    }
+    
+    // A clean shutdown leaves an empty log; an open transaction is not
+    // committed and is discarded by the next recovery instead
+    writeCheckpoint(true);
+    wal.close();
+}
+void Database::checkpoint() {
+    if (!wal.isOpen()) {
+        throw DatabaseException("No database is open; start with a database name to enable checkpoints");
+    }
+    if (!writeCheckpoint(false)) {
+        std::cout << "Checkpoint deferred until the open transaction ends." << std::endl;
+        return;
+    }
+    // As after a background checkpoint, so cold partitions have moved out
+    // of memory once the statement returns; every deleted row is reclaimed
+    compactTables(true);
+    tierTables();
+    std::cout << "Checkpoint written at LSN " << checkpointLsn << "." << std::endl;
+}
+// The last checkpoint plus the log up to now form the copy. Only capturing
+// them holds the state lock, and the checkpoint lock so no checkpoint is
+// replacing the files meanwhile; they are copied while statements run.
+void Database::backup(const std::string& directory) {
+    if (!wal.isOpen()) {
+        throw DatabaseException("No database is open; start with a database name to enable backups");
+    }
+    
+    std::unique_ptr<BackupSnapshot> snapshot;
+    uint64_t lsn;
+    {
+        std::lock_guard<std::mutex> checkpointLock(checkpointMutex);
+        std::lock_guard<std::mutex> stateLock(stateMutex);
+        lsn = wal.getLastLsn();
+        uint64_t logBytes = wal.flush();
+        snapshot = storage.captureBackup(databaseName, wal.getPath(), logBytes);
+        activeBackups++;
+    }
+    
+    uint64_t bytes;
+    try {
+        bytes = storage.writeBackup(*snapshot, databaseName, directory);
+    } catch (...) {
+        activeBackups--;
+        throw;
+    }
+    activeBackups--;
+    if (wal.getSize() >= checkpointWalBytes) {
+        requestCheckpoint();
+    }
+    
+    std::cout << "Backup of " << snapshot->manifest.tableFiles.size() << " table(s) at LSN " << lsn
+              << " written to " << directory << " (" << bytes << " bytes)." << std::endl;
+}
+void Database::applySetting(const std::string& name, const std::string& value) {
+    std::string upperName = toUpperCase(trim(name));
+    
+    if (upperName == "WAL_SYNC") {
+        wal.setSyncPolicy(WriteAheadLog::parseSyncPolicy(value));
+    } else if (upperName == "WAL_GROUP_COMMIT_DELAY") {
+        int micros = std::stoi(value);
+        if (micros < 0) {
+            throw DatabaseException("WAL_GROUP_COMMIT_DELAY must not be negative");
+        }
+        wal.setGroupCommitDelay(std::chrono::microseconds(micros));
+    } else if (upperName == "CHECKPOINT_INTERVAL") {
+        int seconds = std::stoi(value);
+        if (seconds < 0) {
+            throw DatabaseException("CHECKPOINT_INTERVAL must not be negative");
+        }
+        {
+            std::lock_guard<std::mutex> lock(checkpointerMutex);
+            checkpointInterval = std::chrono::seconds(seconds);
+        }
+        // Wake the checkpointer so it starts waiting on the new interval
+        requestCheckpoint();
+    } else if (upperName == "CHECKPOINT_WAL_SIZE") {
+        long long bytes = std::stoll(value);
+        if (bytes <= 0) {
+            throw DatabaseException("CHECKPOINT_WAL_SIZE must be positive");
+        }
+        checkpointWalBytes = static_cast<uint64_t>(bytes);
+    } else if (upperName == "LAZY_LOAD") {
+        std::string flag = toUpperCase(trim(value));
+        if (flag == "ON" || flag == "TRUE" || flag == "1") {
+            storage.setLazyLoading(true);
+        } else if (flag == "OFF" || flag == "FALSE" || flag == "0") {
+            storage.setLazyLoading(false);
+        } else {
+            throw DatabaseException("LAZY_LOAD must be ON or OFF");
+        }
+    } else if (upperName == "MMAP_THRESHOLD") {
+        long long bytes = std::stoll(value);
+        if (bytes < 0) {
+            throw DatabaseException("MMAP_THRESHOLD must not be negative");
+        }
+        storage.setMappingThreshold(static_cast<uint64_t>(bytes));
+    } else if (upperName == "BUFFER_POOL_SIZE") {
+        long long bytes = std::stoll(value);
+        if (bytes < 0) {
+            throw DatabaseException("BUFFER_POOL_SIZE must not be negative");
+        }
+        storage.setBufferPoolSize(static_cast<size_t>(bytes));
+    } else if (upperName == "COMPRESSION") {
+        std::string flag = toUpperCase(trim(value));
+        if (flag == "ON" || flag == "TRUE" || flag == "1") {
+            storage.setCompression(true);
+        } else if (flag == "OFF" || flag == "FALSE" || flag == "0") {
+            storage.setCompression(false);
+        } else {
+            throw DatabaseException("COMPRESSION must be ON or OFF");
+        }
+    } else if (upperName == "VERIFY_ON_LOAD") {
+        std::string flag = toUpperCase(trim(value));
+        if (flag == "ON" || flag == "TRUE" || flag == "1") {
+            storage.setVerifyOnLoad(true);
+        } else if (flag == "OFF" || flag == "FALSE" || flag == "0") {
+            storage.setVerifyOnLoad(false);
+        } else {
+            throw DatabaseException("VERIFY_ON_LOAD must be ON or OFF");
+        }
+    } else if (upperName == "IO_QUEUE_DEPTH") {
+        int depth = std::stoi(value);
+        if (depth < 0) {
+            throw DatabaseException("IO_QUEUE_DEPTH must not be negative");
+        }
+        storage.setIoQueueDepth(static_cast<unsigned>(depth));
+    } else if (upperName == "LOAD_THREADS") {
+        int threads = std::stoi(value);
+        if (threads < 0) {
+            throw DatabaseException("LOAD_THREADS must not be negative");
+        }
+        storage.setLoadThreads(static_cast<size_t>(threads));
+    } else {
+        throw DatabaseException("Unknown setting: " + name);
+    }
+    
+    std::cout << "Setting " << upperName << " = " << value << std::endl;
+}
+// Appends a DML record before the statement is applied. Returns 0 when the
+// statement is not logged (no log open, or the log itself is being replayed).
+uint64_t Database::logStatement(WalRecord& record) {
+    if (!wal.isOpen() || replayingLog) {
+        return 0;
+    }
+    record.transactionId = inTransaction ? currentTransactionId : 0;
+    return wal.append(record);
+}
+// Auto-committed statements become durable once applied; statements inside a
+// transaction wait for COMMIT instead.
+void Database::commitStatement(uint64_t lsn) {
+    if (lsn == 0 || inTransaction) {
+        return;
+    }
+    wal.commit(lsn);
+    if (wal.getSize() >= checkpointWalBytes && activeBackups == 0) {
+        requestCheckpoint();
+    }
+}
+// Re-applies the committed records of a log. Statements that failed when they
+// were first run fail the same way again, so type and constraint errors only
+// count as failed records; anything else means the log cannot be recovered.
+size_t Database::replayLog(const std::vector<WalRecord>& records, size_t& failed) {
+    std::set<uint64_t> committedTransactions;
+    for (const auto& record : records) {
+        if (record.type == WalRecordType::COMMIT) {
+            committedTransactions.insert(record.transactionId);
+        }
+    }
+    
+    size_t replayed = 0;
+    failed = 0;
+    SilencedOutput silence;
+    replayingLog = true;
+    for (const auto& record : records) {
+        if (record.lsn <= checkpointLsn ||
+            record.type == WalRecordType::COMMIT || record.type == WalRecordType::ABORT) {
+            continue;
+        }
+        // A table written by a later schema change already holds the record
+        if (record.lsn <= storage.getCheckpointedLsn(toLowerCase(record.tableName))) {
+            continue;
+        }
+        if (record.transactionId != 0 &&
+            committedTransactions.find(record.transactionId) == committedTransactions.end()) {
+            continue;
+        }
+        
+        try {
+            replayRecord(record);
+            replayed++;
+        } catch (const DataTypeException&) {
+            failed++;
+        } catch (const ConstraintViolationException&) {
+            failed++;
+        } catch (const std::exception& e) {
+            replayingLog = false;
+            throw DatabaseException("Cannot replay log record " + std::to_string(record.lsn) + ": " + e.what());
+        }
+    }
+    replayingLog = false;
+    
+    return replayed;
+}
+void Database::replayRecord(const WalRecord& record) {
+    // Statements are logged only for tables that exist, and DDL checkpoints
+    if (tables.find(toLowerCase(record.tableName)) == tables.end()) {
+        throw DatabaseException("table '" + record.tableName + "' does not exist");
+    }
+    switch (record.type) {
+        case WalRecordType::INSERT:
+            insertRecord(record.tableName, record.rows);
+            break;
+        case WalRecordType::UPDATE: {
+            std::vector<std::pair<std::string, std::string>> updates;
+            for (const auto& pair : record.rows) {
+                updates.emplace_back(pair.at(0), pair.at(1));
+            }
+            updateRecords(record.tableName, updates, record.arguments.at(0));
+            break;
+        }
+        case WalRecordType::DELETE:
+            deleteRecords(record.tableName, record.arguments.at(0));
+            break;
+        case WalRecordType::MERGE:
+            mergeRecords(record.tableName, record.arguments.at(0));
+            break;
+        case WalRecordType::REPLACE:
+            replaceInto(record.tableName, record.rows);
+            break;
+        default:
+            break;
+    }
+}
+// Writes every table and view as of the current log position, then drops the
+// log records the checkpoint covers. Skipped while a transaction is open,
+// since its changes must not become durable before COMMIT. Only copying the
+// tables holds the state lock; they are encoded and written while statements
+// run.
+bool Database::writeCheckpoint(bool skipIfUnchanged, const std::set<std::string>* onlyTables) {
+    std::lock_guard<std::mutex> checkpointLock(checkpointMutex);
+    PendingCheckpoint checkpoint;
+    {
+        std::lock_guard<std::mutex> stateLock(stateMutex);
+        if (inTransaction) {
+            return false;
+        }
+        
+        uint64_t lsn = wal.getLastLsn();
+        if (skipIfUnchanged && lsn == checkpointLsn) {
+            return true;
+        }
+        
+        std::map<std::string, Table*> snapshot;
+        for (const auto& [tableKey, table] : tables) {
+            snapshot[tableKey] = table.get();
+        }
+        std::map<std::string, std::string> viewSnapshot(views.begin(), views.end());
+        checkpoint = storage.prepareCheckpoint(databaseName, snapshot, viewSnapshot, lsn, onlyTables);
+    }
+    
+    storage.saveCheckpoint(checkpoint);
+    
+    // Tables left out keep the log position of their files
+    uint64_t coveredLsn = checkpoint.lsn;
+    for (const auto& entry : checkpoint.tables) {
+        coveredLsn = std::min(coveredLsn, entry.second.lsn);
+    }
+    std::lock_guard<std::mutex> stateLock(stateMutex);
+    checkpointLsn = coveredLsn;
+    if (activeBackups == 0) {
+        wal.truncate(coveredLsn);
+    }
+    return true;
+}
+// DDL is not logged; the schema becomes durable through a checkpoint of the
+// table list, the views and the tables the statement changed
+void Database::schemaChanged(const std::set<std::string>& tableKeys) {
+    if (!wal.isOpen() || replayingLog) {
+        return;
+    }
+    if (inTransaction) {
+        checkpointAfterCommit = true;
+        checkpointTables.insert(tableKeys.begin(), tableKeys.end());
+        return;
+    }
+    writeCheckpoint(false, &tableKeys);
+}
+void Database::requestCheckpoint() {
+    {
+        std::lock_guard<std::mutex> lock(checkpointerMutex);
+        checkpointRequested = true;
+    }
+    checkpointerWake.notify_all();
+}
+void Database::requestCompaction() {
+    {
+        std::lock_guard<std::mutex> lock(checkpointerMutex);
+        compactionRequested = true;
+    }
+    checkpointerWake.notify_all();
+}
+// Reclaims the space of deleted rows in tables where they have piled up,
+// or wherever there are any with anyDeleted. Rows keep their IDs and the
+// table files are not touched.
+void Database::compactTables(bool anyDeleted) {
+    std::lock_guard<std::mutex> stateLock(stateMutex);
+    for (const auto& entry : tables) {
+        entry.second->compactRows(anyDeleted);
+    }
+}
+// Moves the partitions that their table's cold policy selects out of memory.
+// Every spill goes to a file of its own, which is gone again once nothing
+// reads the partition's segment.
+void Database::tierTables() {
+    std::lock_guard<std::mutex> stateLock(stateMutex);
+    for (const auto& [name, table] : tables) {
+        if (table->getColdPolicy() == Table::ColdPolicy::NONE) {
+            continue;
+        }
+        for (size_t partition : table->findColdPartitions()) {
+            std::string path = databaseName + "." + name + "." + table->getPartitions()[partition].name + "." +
+                               std::to_string(++coldFiles) + ".cold";
+            table->coolPartition(partition, [&](const Table& rows) {
+                return storage.spillTable(rows, path);
+            });
+        }
+    }
+}
+// Background checkpointer: runs every checkpointInterval, or earlier when the
+// log outgrows checkpointWalBytes, so recovery only replays a short tail.
+// It also compacts tables and moves cold partitions out of memory after each
+// checkpoint, or does so alone when a DELETE or a cold policy asks for it.
+void Database::checkpointerLoop() {
+    std::unique_lock<std::mutex> lock(checkpointerMutex);
+    while (!stopCheckpointer) {
+        auto woken = [this]() { return stopCheckpointer || checkpointRequested || compactionRequested; };
+        if (checkpointInterval.count() > 0) {
+            checkpointerWake.wait_for(lock, checkpointInterval, woken);
+        } else {
+            checkpointerWake.wait(lock, woken);
+        }
+        if (stopCheckpointer) {
+            break;
+        }
+        bool compactOnly = compactionRequested && !checkpointRequested;
+        checkpointRequested = false;
+        compactionRequested = false;
+        
+        lock.unlock();
+        try {
+            if (!compactOnly) {
+                writeCheckpoint(true);
+            }
+            compactTables();
+            tierTables();
+        } catch (const std::exception& e) {
+            std::cerr << "Background checkpoint failed: " << e.what() << std::endl;
+        }
+        lock.lock();
+    }
+}
@@ -8,10 +8,15 @@
 #include <mutex>
 #include <set>
 #include <queue>
+#include <thread>
+#include <condition_variable>
+#include <chrono>
+#include <atomic>
 #include "Table.h"
 #include "Storage.h"
 #include "Catalog.h"
 #include "Transaction.h"
+#include "WriteAheadLog.h"
 #include "user.h"
 extern Database* _g_db;
 
@@ -34,7 +39,11 @@ Transaction* commitTransaction();
     // DDL operations
     void createTable(const std::string& tableName,
                      const std::vector<std::pair<std::string, std::string>>& columns,
-                     const std::vector<Constraint>& constraints);
+                     const std::vector<Constraint>& constraints,
+                     Table::StorageMode storageMode = Table::StorageMode::ROW,
+                     Table::PartitionKind partitionKind = Table::PartitionKind::NONE,
+                     const std::string& partitionColumn = "",
+                     const std::vector<Table::Partition>& partitions = {});
     void dropTable(const std::string& tableName);
     void alterTableAddColumn(const std::string& tableName, const std::pair<std::string, std::string>& column,
                             bool isNotNull = false);
@@ -42,6 +51,12 @@ Transaction* commitTransaction();
     void alterTableRenameColumn(const std::string& tableName, const std::string& oldName, const std::string& newName);
     void alterTableAddConstraint(const std::string& tableName, const Constraint& constraint);
     void alterTableDropConstraint(const std::string& tableName, const std::string& constraintName);
+    void alterTableAddBloomFilter(const std::string& tableName, const std::vector<std::string>& columnNames);
+    void alterTableDropBloomFilter(const std::string& tableName, const std::vector<std::string>& columnNames);
+    void alterTableAddPartition(const std::string& tableName, Table::PartitionKind kind,
+                                const Table::Partition& partition);
+    void alterTableDropPartition(const std::string& tableName, const std::string& partitionName);
+    void alterTableSetColdPolicy(const std::string& tableName, Table::ColdPolicy policy, uint32_t after);
     void describeTable(const std::string& tableName);
 
     // DML operations
@@ -63,6 +78,9 @@ Transaction* commitTransaction();
                        const std::vector<std::pair<std::string, std::string>>& updates,
                        const std::string& condition);
     void showTables();
+    // Rows, payload and the bytes held in memory per table (all tables when
+    // tableName is empty), including the copies kept for rollback
+    void showTableStats(const std::string& tableName = "");
 
     // JOIN operations
     void joinTables(const std::string& leftTable, 
@@ -133,6 +151,16 @@ Transaction* commitTransaction();
     // Get table reference (with appropriate locking)
     Table* getTable(const std::string& tableName, bool exclusiveLock = false);
 
+    // Durability
+    // Load the last checkpoint of dbName, replay its log and keep both up to date
+    void open(const std::string& dbName);
+    void close();
+    void checkpoint();
+    // Consistent copy of every table and view as of now, written to directory
+    // while statements keep running; open it like any other database
+    void backup(const std::string& directory);
+    void applySetting(const std::string& name, const std::string& value);
+
 private:
     bool inTransaction = false;
     std::unordered_map<std::string, std::unique_ptr<Table>> backupTables;
@@ -151,11 +179,56 @@ private:
     // Catalog information
     Catalog catalog;
 
+    // Write-ahead log for DML
+    WriteAheadLog wal;
+    bool replayingLog = false;
+    uint64_t currentTransactionId = 0;
+    
+    // Checkpointing. stateMutex is held while table contents change and while
+    // a checkpoint copies the tables, so a checkpoint always matches a log
+    // position. checkpointMutex keeps checkpoints and backup captures apart
+    // while the files are written; it is taken before stateMutex.
+    Storage storage;
+    std::string databaseName;
+    std::mutex stateMutex;
+    std::mutex checkpointMutex;
+    uint64_t checkpointLsn = 0;
+    bool checkpointAfterCommit = false;   // DDL ran inside the open transaction
+    std::set<std::string> checkpointTables;   // keys of the tables it changed
+    // Backups copying the log; checkpoints leave the log untruncated meanwhile
+    std::atomic<int> activeBackups{0};
+    
+    std::thread checkpointer;
+    std::mutex checkpointerMutex;
+    std::condition_variable checkpointerWake;
+    bool stopCheckpointer = false;
+    bool checkpointRequested = false;
+    bool compactionRequested = false;
+    uint64_t coldFiles = 0;   // spill files written, for unique names
+    std::chrono::seconds checkpointInterval{60};
+    std::atomic<uint64_t> checkpointWalBytes{64 * 1024 * 1024};
+
     // Helper methods
     bool tableExists(const std::string& tableName);
     bool viewExists(const std::string& viewName);
     void validateReferences(const Constraint& constraint);
     std::vector<std::vector<std::string>> evaluateViewQuery(const std::string& viewName);
+    uint64_t logStatement(WalRecord& record);
+    void commitStatement(uint64_t lsn);
+    void registerForeignKeyTable(const std::string& tableKey);
+    // Returns the records applied; failed counts those that failed again
+    size_t replayLog(const std::vector<WalRecord>& records, size_t& failed);
+    void replayRecord(const WalRecord& record);
+    // Given onlyTables, other changed tables keep their files and the log
+    // keeps their records
+    bool writeCheckpoint(bool skipIfUnchanged, const std::set<std::string>* onlyTables = nullptr);
+    void schemaChanged(const std::set<std::string>& tableKeys);
+    void requestCheckpoint();
+    // Wakes the checkpointer to compact tables without checkpointing
+    void requestCompaction();
+    void compactTables(bool anyDeleted = false);
+    void tierTables();
+    void checkpointerLoop();
     void executeWithClauseHelper(const std::vector<std::pair<std::string, std::string>>& cteList,
                                 const std::string& mainQuery);
 };
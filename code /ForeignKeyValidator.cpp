@@ -89,7 +89,7 @@ bool ForeignKeyValidator::validateForeignKey(
         }
         
         // Allow NULL values in FK
-        if (row[colIdx].empty() || toLowerCase(row[colIdx]) == "null") {
+        if (row[colIdx].empty()) {
             
             
             return true;
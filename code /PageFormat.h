@@ -0,0 +1,174 @@
+#ifndef PAGE_FORMAT_H
+#define PAGE_FORMAT_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Utils.h"
+
+// Binary table file layout (.tbl)
+// -------------------------------
+// Header pages : fixed file header followed by the length-prefixed schema block;
+//                version 2 adds a length-prefixed block with the encoding of
+//                every column (see ColumnEncoding.h)
+// Data pages   : page header followed by the page's rows.
+//                Version 1: each row is a cell count and length-prefixed cells.
+//                Version 2: one length-prefixed chunk per column holding that
+//                column's values for all rows of the page, in its encoding.
+//                A page never splits a row; a row larger than one page gets a
+//                run of consecutive pages (spanPages).
+// Zone trailer : optional min/max summary and key Bloom filters of every page
+//                run, after the last data page (see ZoneMap.h); files without
+//                one are still valid
+// All integers are little-endian.
+namespace PageFormat {
+    const char MAGIC[8] = {'C', 'S', 'Q', 'L', 'T', 'B', 'L', '1'};
+    const char ZONE_MAGIC_V1[8] = {'C', 'S', 'Q', 'L', 'Z', 'O', 'N', 'E'};
+    const char ZONE_MAGIC[8] = {'C', 'S', 'Q', 'L', 'Z', 'O', 'N', '2'};
+    const uint32_t ROW_VERSION = 1;
+    const uint32_t COLUMNAR_VERSION = 2;
+    const uint32_t VERSION = COLUMNAR_VERSION;   // newest version written
+    const uint32_t PAGE_SIZE = 16384;
+
+    // magic(8) version(4) pageSize(4) headerPages(4) dataPages(4) rowCount(8)
+    const size_t FILE_HEADER_SIZE = 32;
+    // rowCount(4) payloadBytes(4) spanPages(4) checksum(4)
+    const size_t PAGE_HEADER_SIZE = 16;
+
+    // Number of pages pulled from disk per read while loading
+    const size_t PAGES_PER_READ = 64;
+
+    inline bool hasMagic(const char* data, size_t size) {
+        return size >= sizeof(MAGIC) && std::memcmp(data, MAGIC, sizeof(MAGIC)) == 0;
+    }
+
+    // FNV-1a over the page payload, used to detect torn or corrupted pages
+    inline uint32_t checksum(const char* data, size_t size) {
+        uint32_t hash = 2166136261u;
+        for (size_t i = 0; i < size; ++i) {
+            hash ^= static_cast<unsigned char>(data[i]);
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+
+    // Bytes needed to store a row (cell count plus length-prefixed cells)
+    template <typename Row>
+    inline size_t encodedRowSize(const Row& row) {
+        size_t size = 4;
+        for (size_t i = 0; i < row.size(); ++i) {
+            size += 4 + row[i].size();
+        }
+        return size;
+    }
+}
+
+// Appends little-endian values to a byte buffer
+class ByteWriter {
+public:
+    explicit ByteWriter(std::vector<char>& buffer) : buffer(buffer) {}
+
+    void putU8(uint8_t value) {
+        buffer.push_back(static_cast<char>(value));
+    }
+
+    void putU32(uint32_t value) {
+        for (int i = 0; i < 4; ++i) {
+            buffer.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+        }
+    }
+
+    void putU64(uint64_t value) {
+        for (int i = 0; i < 8; ++i) {
+            buffer.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+        }
+    }
+
+    void putString(std::string_view value) {
+        putU32(static_cast<uint32_t>(value.size()));
+        buffer.insert(buffer.end(), value.begin(), value.end());
+    }
+
+    void putBytes(const char* data, size_t size) {
+        buffer.insert(buffer.end(), data, data + size);
+    }
+
+    size_t size() const { return buffer.size(); }
+
+private:
+    std::vector<char>& buffer;
+};
+
+// Reads little-endian values from a byte range, throwing on overrun
+class ByteReader {
+public:
+    ByteReader(const char* data, size_t size) : data(data), size(size), pos(0) {}
+
+    uint8_t getU8() {
+        require(1);
+        return static_cast<uint8_t>(data[pos++]);
+    }
+
+    uint32_t getU32() {
+        require(4);
+        uint32_t value = 0;
+        for (int i = 0; i < 4; ++i) {
+            value |= static_cast<uint32_t>(static_cast<unsigned char>(data[pos + i])) << (8 * i);
+        }
+        pos += 4;
+        return value;
+    }
+
+    uint64_t getU64() {
+        require(8);
+        uint64_t value = 0;
+        for (int i = 0; i < 8; ++i) {
+            value |= static_cast<uint64_t>(static_cast<unsigned char>(data[pos + i])) << (8 * i);
+        }
+        pos += 8;
+        return value;
+    }
+
+    std::string getString() {
+        uint32_t length = getU32();
+        require(length);
+        std::string value(data + pos, length);
+        pos += length;
+        return value;
+    }
+
+    // Like getString, but points into the underlying bytes instead of copying
+    std::string_view getStringView() {
+        uint32_t length = getU32();
+        require(length);
+        std::string_view value(data + pos, length);
+        pos += length;
+        return value;
+    }
+    
+    // Points at the next size bytes and skips them
+    const char* getBytes(size_t bytes) {
+        require(bytes);
+        const char* value = data + pos;
+        pos += bytes;
+        return value;
+    }
+    
+    size_t position() const { return pos; }
+    size_t remaining() const { return size - pos; }
+
+private:
+    const char* data;
+    size_t size;
+    size_t pos;
+
+    void require(size_t bytes) const {
+        if (size - pos < bytes) {
+            throw DatabaseException("Unexpected end of encoded data");
+        }
+    }
+};
+
+#endif // PAGE_FORMAT_H
@@ -94,7 +94,12 @@ Query Parser::parseQuery(const std::string& queryStr) {
     } else if (command == "SHOW") {
         q.type = "SHOW";
         iss >> word; // Optional object type (tables, views, etc.)
-        if (!word.empty()) {
+        std::string next;
+        if (toUpperCase(word) == "TABLE" && iss >> next && toUpperCase(next) == "STATS") {
+            // SHOW TABLE STATS [name]
+            q.type = "SHOWSTATS";
+            iss >> q.tableName;
+        } else if (!word.empty()) {
             q.tableName = word; // Reuse tableName for the object type
         }
     } else if (command == "BEGIN") {
@@ -114,6 +119,12 @@ Query Parser::parseQuery(const std::string& queryStr) {
         iss >> word; // Expect "INTO"
         iss >> q.tableName;
         q.values = extractValues(queryStr);
+    } else if (command == "SET") {
+        return parseSet(queryStr);
+    } else if (command == "CHECKPOINT") {
+        q.type = "CHECKPOINT";
+    } else if (command == "BACKUP") {
+        return parseBackup(queryStr);
     }
     
     return q;
@@ -152,12 +163,9 @@ std::vector<std::vector<std::string>> Parser::extractValues(const std::string& q
             rowValues.push_back(trim(currentValue));
         }
         
-        // Process each value (remove quotes, etc.)
+        // Process each value (remove quotes, NULL, etc.)
         for (auto& val : rowValues) {
-            val = trim(val);
-            if (val.size() >= 2 && val.front() == '\'' && val.back() == '\'') {
-                val = val.substr(1, val.size() - 2);
-            }
+            val = literalCell(trim(val));
         }
         
         values.push_back(rowValues);
@@ -424,6 +432,34 @@ std::vector<std::pair<std::string, std::string>> Parser::extractWithClauses(cons
     
     return clauses;
 }
+std::vector<Table::Partition> Parser::extractPartitions(const std::string& text, Table::PartitionKind& kind) {
+    std::vector<Table::Partition> partitions;
+    kind = Table::PartitionKind::NONE;
+    std::regex partitionRegex(
+        R"(PARTITION\s+(\w+)(\s+VALUES\s+(LESS\s+THAN\s*(\(\s*MAXVALUE\s*\)|MAXVALUE|\(([^)]*)\))|IN\s*\(([^)]*)\)))?)",
+        std::regex::icase);
+    for (std::sregex_iterator it(text.begin(), text.end(), partitionRegex), end; it != end; ++it) {
+        const std::smatch& match = *it;
+        Table::PartitionKind partitionKind = Table::PartitionKind::NONE;
+        Table::Partition partition;
+        partition.name = match[1];
+        if (match[3].matched) {
+            partitionKind = match[6].matched ? Table::PartitionKind::LIST : Table::PartitionKind::RANGE;
+            std::string values = match[6].matched ? match[6].str() : match[5].str();
+            if (match[5].matched || match[6].matched) {
+                for (const auto& value : split(values, ',')) {
+                    partition.values.push_back(literalCell(trim(value)));
+                }
+            }
+        }
+        if (!partitions.empty() && partitionKind != kind) {
+            throw DatabaseException("Partition '" + partition.name + "' is not declared like the ones before it");
+        }
+        kind = partitionKind;
+        partitions.push_back(std::move(partition));
+    }
+    return partitions;
+}
 Query Parser::parseCreateTable(const std::string& query) {
     Query q;
     q.type = "CREATE";
@@ -435,9 +471,68 @@ Query Parser::parseCreateTable(const std::string& query) {
         q.tableName = match[1];
     }
     
+    // A trailing WITH (storage = ...) is cut off first, as the column list
+    // ends at the last closing parenthesis (or PARTITIONS n ends the line)
+    std::string definition = query;
+    std::regex storageRegex(R"([)\d]\s*WITH\s*\(\s*storage\s*=\s*(\w+)\s*\)\s*;?\s*$)", std::regex::icase);
+    if (std::regex_search(query, match, storageRegex)) {
+        std::string mode = toLowerCase(match[1].str());
+        if (mode == "column") {
+            q.storageMode = Table::StorageMode::COLUMN;
+        } else if (mode == "clustered") {
+            q.storageMode = Table::StorageMode::CLUSTERED;
+        } else if (mode != "row") {
+            throw DatabaseException("Unknown storage mode '" + match[1].str() + "'. Expected row, column or clustered");
+        }
+        definition = query.substr(0, match.position(0) + 1);
+    }
+    
+    // PARTITION BY RANGE|LIST (column) (PARTITION ..., ...) or
+    // PARTITION BY HASH (column) PARTITIONS n follows the column list
+    std::string scheme = definition;
+    std::regex partitionByRegex(R"(\)\s*PARTITION\s+BY\s+(RANGE|LIST|HASH)\s*\(\s*(\w+)\s*\)([\s\S]*)$)",
+                                std::regex::icase);
+    if (std::regex_search(scheme, match, partitionByRegex)) {
+        std::string kindName = toUpperCase(match[1].str());
+        q.partitionColumn = match[2];
+        std::string spec = match[3];
+        definition = scheme.substr(0, match.position(0) + 1);
+        
+        std::smatch countMatch;
+        std::regex hashCountRegex(R"(^\s*PARTITIONS\s+(\d+)\s*;?\s*$)", std::regex::icase);
+        Table::PartitionKind declared;
+        if (std::regex_search(spec, countMatch, hashCountRegex)) {
+            if (kindName != "HASH") {
+                throw DatabaseException("PARTITIONS n only applies to PARTITION BY HASH");
+            }
+            int count = std::stoi(countMatch[1].str());
+            if (count < 1 || count > 1024) {
+                throw DatabaseException("PARTITION BY HASH takes between 1 and 1024 partitions");
+            }
+            for (int p = 0; p < count; ++p) {
+                q.partitions.push_back({"p" + std::to_string(p), {}});
+            }
+            declared = Table::PartitionKind::NONE;
+        } else {
+            q.partitions = extractPartitions(spec, declared);
+        }
+        
+        q.partitionKind = kindName == "RANGE" ? Table::PartitionKind::RANGE
+                        : kindName == "LIST" ? Table::PartitionKind::LIST
+                        : Table::PartitionKind::HASH;
+        if (q.partitions.empty()) {
+            throw DatabaseException("PARTITION BY " + kindName + " declares no partitions");
+        }
+        if (declared != (q.partitionKind == Table::PartitionKind::HASH ? Table::PartitionKind::NONE : q.partitionKind)) {
+            throw DatabaseException(kindName == "RANGE" ? "RANGE partitions need VALUES LESS THAN"
+                                    : kindName == "LIST" ? "LIST partitions need VALUES IN"
+                                    : "HASH partitions take no VALUES");
+        }
+    }
+    
     // Extract columns and constraints
-    q.columns = extractColumns(query);
-    q.constraints = extractConstraints(query);
+    q.columns = extractColumns(definition);
+    q.constraints = extractConstraints(definition);
     
     // Validate duplicate column names and data types
     std::unordered_set<std::string> seen;
@@ -544,7 +639,35 @@ Query Parser::parseAlterTable(const std::string& query) {
     }
     
     // Extract alter action
-    if (query.find("ADD CONSTRAINT") != std::string::npos) {
+    std::regex bloomFilterRegex(R"((ADD|DROP)\s+BLOOM\s+FILTER\s*\(([^)]*)\))", std::regex::icase);
+    if (std::regex_search(query, match, bloomFilterRegex)) {
+        q.alterAction = toUpperCase(match[1].str()) + " BLOOM FILTER";
+        for (const auto& column : split(match[2].str(), ',')) {
+            q.columns.push_back({trim(column), ""});
+        }
+    } else if (std::regex_search(query, match, std::regex(R"(ADD\s+PARTITION\b([\s\S]*))", std::regex::icase))) {
+        // ADD PARTITION p VALUES ... or ADD PARTITION (PARTITION p VALUES ...)
+        q.alterAction = "ADD PARTITION";
+        std::string definition = match[1].str();
+        if (!std::regex_search(definition, std::regex(R"(^\s*\(\s*PARTITION\b)", std::regex::icase))) {
+            definition = "PARTITION " + definition;
+        }
+        q.partitions = extractPartitions(definition, q.partitionKind);
+        if (q.partitions.size() != 1) {
+            throw DatabaseException("ADD PARTITION takes exactly one partition");
+        }
+    } else if (std::regex_search(query, match, std::regex(R"(DROP\s+PARTITION\s+(\w+))", std::regex::icase))) {
+        q.alterAction = "DROP PARTITION";
+        q.partitions.push_back({match[1], {}});
+    } else if (std::regex_search(query, match, std::regex(R"(SET\s+COLD\s+(?:OFF\b|AFTER\s+(\d+)\s+(DAYS?|SECONDS?)\b))",
+                                                          std::regex::icase))) {
+        // SET COLD AFTER n DAYS (partition bound age) | n SECONDS (idle) | OFF
+        q.alterAction = "SET COLD";
+        if (match[1].matched) {
+            q.coldPolicy = toUpperCase(match[2].str())[0] == 'D' ? Table::ColdPolicy::AGE : Table::ColdPolicy::IDLE;
+            q.coldAfter = static_cast<uint32_t>(std::stoul(match[1].str()));
+        }
+    } else if (query.find("ADD CONSTRAINT") != std::string::npos) {
         q.alterAction = "ADD CONSTRAINT";
         q.constraints = extractConstraints(query);
     } else if (query.find("DROP CONSTRAINT") != std::string::npos) {
@@ -979,4 +1102,36 @@ std::vector<std::string> Parser::extractSubqueries(const std::string& query) {
     }
     
     return subqueries;
-}
\ No newline at end of file
+}
+Query Parser::parseSet(const std::string& query) {
+    Query q;
+    q.type = "SET";
+    
+    // SET name = value  (the '=' is optional: SET name value)
+    std::regex setRegex(R"(SET\s+(\w+)\s*(?:=\s*|\s+)(.+))", std::regex::icase);
+    std::smatch match;
+    if (!std::regex_search(query, match, setRegex)) {
+        throw DatabaseException("Invalid SET syntax. Expected: SET name = value");
+    }
+    
+    q.settingName = toUpperCase(match[1].str());
+    q.settingValue = trim(match[2].str());
+    if (q.settingValue.size() >= 2 && q.settingValue.front() == '\'' && q.settingValue.back() == '\'') {
+        q.settingValue = q.settingValue.substr(1, q.settingValue.size() - 2);
+    }
+    
+    return q;
+}
+Query Parser::parseBackup(const std::string& query) {
+    Query q;
+    q.type = "BACKUP";
+    
+    std::regex backupRegex(R"(BACKUP\s+TO\s+'([^']+)'\s*;?\s*$)", std::regex::icase);
+    std::smatch match;
+    if (!std::regex_search(query, match, backupRegex)) {
+        throw DatabaseException("Invalid BACKUP syntax. Expected: BACKUP TO 'directory'");
+    }
+    q.backupDirectory = match[1].str();
+    
+    return q;
+}
@@ -80,6 +80,26 @@ struct Query {
     // Recursive queries
     bool isRecursive = false;
     std::string recursiveQuery;
+    
+    // Runtime settings (SET name = value)
+    std::string settingName;
+    std::string settingValue;
+    
+    // BACKUP TO 'directory'
+    std::string backupDirectory;
+    
+    // CREATE TABLE ... WITH (storage = row|column|clustered)
+    Table::StorageMode storageMode = Table::StorageMode::ROW;
+    
+    // CREATE TABLE ... PARTITION BY kind (column) ..., and the partition of
+    // ALTER TABLE ... ADD|DROP PARTITION
+    Table::PartitionKind partitionKind = Table::PartitionKind::NONE;
+    std::string partitionColumn;
+    std::vector<Table::Partition> partitions;
+    
+    // ALTER TABLE ... SET COLD AFTER n DAYS|SECONDS, or SET COLD OFF
+    Table::ColdPolicy coldPolicy = Table::ColdPolicy::NONE;
+    uint32_t coldAfter = 0;
 };
 
 class Parser {
@@ -94,6 +114,9 @@ public:
     std::string extractCondition(const std::string& query);
     std::vector<Constraint> extractConstraints(const std::string& query);
     std::vector<std::pair<std::string, std::string>> extractWithClauses(const std::string& query);
+    // PARTITION name [VALUES LESS THAN (v) | VALUES IN (v, ...)] definitions;
+    // kind tells which VALUES form they use, NONE if neither
+    std::vector<Table::Partition> extractPartitions(const std::string& text, Table::PartitionKind& kind);
     
     // Parse specific statement types
     Query parseCreateTable(const std::string& query);
@@ -108,6 +131,8 @@ public:
     Query parseGrant(const std::string& query);
     Query parseRevoke(const std::string& query);
     Query parseCreateAssertion(const std::string& query);
+    Query parseSet(const std::string& query);
+    Query parseBackup(const std::string& query);
     
     // Parse JOIN conditions
     std::pair<std::string, std::string> parseJoinCondition(const std::string& query);
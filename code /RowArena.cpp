@@ -0,0 +1,278 @@
+#include "RowArena.h"
+#include <algorithm>
+#include <cstring>
+static uint32_t readU32(const char* at) {
+    uint32_t value;
+    std::memcpy(&value, at, sizeof(value));
+    return value;
+}
+// Chunks
+// ------
+size_t RowArena::Chunk::memoryBytes() const {
+    return sizeof(*this) + bytes.capacity() + starts.capacity() * sizeof(size_t) +
+           ids.capacity() * sizeof(uint64_t) + dead.capacity();
+}
+RowArena::Chunk& RowArena::ownChunk(size_t index) {
+    if (chunks[index].use_count() > 1) {
+        chunks[index] = std::make_shared<Chunk>(*chunks[index]);
+    }
+    return *chunks[index];
+}
+RowArena::Chunk& RowArena::appendChunk() {
+    if (chunks.empty() || chunks.back()->ids.size() == CHUNK_ROWS) {
+        auto chunk = std::make_shared<Chunk>();
+        // Rows of a table tend to be alike, so the next chunk takes about
+        // as many bytes as the last one
+        if (!chunks.empty()) {
+            chunk->bytes.reserve(chunks.back()->bytes.size());
+        }
+        chunk->starts.reserve(CHUNK_ROWS);
+        chunk->ids.reserve(CHUNK_ROWS);
+        chunks.push_back(std::move(chunk));
+    }
+    return ownChunk(chunks.size() - 1);
+}
+size_t RowArena::slotBytes(size_t slot) const {
+    size_t count = cellCount(slot);
+    size_t dataBytes = count == 0 ? 0 : readU32(rowStart(slot) + count * sizeof(uint32_t));
+    return (1 + count) * sizeof(uint32_t) + dataBytes;
+}
+// Appending
+// ---------
+size_t RowArena::writeRow(Chunk& chunk, const RowView& row, size_t& bytes) {
+    uint32_t count = static_cast<uint32_t>(row.size());
+    size_t dataBytes = 0;
+    for (size_t c = 0; c < count; ++c) {
+        dataBytes += row[c].size();
+    }
+    size_t headerBytes = (1 + count) * sizeof(uint32_t);
+    size_t offset = chunk.bytes.size();
+    chunk.bytes.resize(offset + headerBytes + dataBytes);
+    char* start = chunk.bytes.data() + offset;
+    std::memcpy(start, &count, sizeof(count));
+    char* ends = start + sizeof(uint32_t);
+    char* data = start + headerBytes;
+    uint32_t end = 0;
+    for (size_t c = 0; c < count; ++c) {
+        std::string_view cell = row[c];
+        std::memcpy(data + end, cell.data(), cell.size());
+        end += static_cast<uint32_t>(cell.size());
+        std::memcpy(ends + c * sizeof(uint32_t), &end, sizeof(end));
+    }
+    bytes = headerBytes + dataBytes;
+    return offset;
+}
+void RowArena::append(const RowView& row, uint64_t id) {
+    Chunk& chunk = appendChunk();
+    size_t bytes = 0;
+    chunk.starts.push_back(writeRow(chunk, row, bytes));
+    chunk.ids.push_back(id);
+    if (!chunk.dead.empty()) {
+        chunk.dead.push_back(0);
+    }
+    slotCount++;
+    liveRows++;
+    rowBytes += bytes;
+}
+void RowArena::appendArena(RowArena&& other) {
+    if (other.slotCount == 0) {
+        other.clear();
+        return;
+    }
+    if (slotCount % CHUNK_ROWS != 0) {
+        // Padding slots hold rows without cells under the last ID, which
+        // keeps the IDs in slot order
+        Chunk& last = ownChunk(chunks.size() - 1);
+        uint64_t padId = last.ids.back();
+        last.dead.resize(last.ids.size(), 0);
+        const uint32_t noCells = 0;
+        while (last.ids.size() < CHUNK_ROWS) {
+            last.starts.push_back(last.bytes.size());
+            last.bytes.insert(last.bytes.end(), reinterpret_cast<const char*>(&noCells),
+                              reinterpret_cast<const char*>(&noCells) + sizeof(noCells));
+            last.ids.push_back(padId);
+            last.dead.push_back(1);
+            slotCount++;
+            rowBytes += sizeof(noCells);
+            deadBytes += sizeof(noCells);
+        }
+    }
+    chunks.insert(chunks.end(), std::make_move_iterator(other.chunks.begin()),
+                  std::make_move_iterator(other.chunks.end()));
+    slotCount += other.slotCount;
+    liveRows += other.liveRows;
+    rowBytes += other.rowBytes;
+    deadBytes += other.deadBytes;
+    other.clear();
+}
+void RowArena::numberRows(size_t first, uint64_t firstId) {
+    for (size_t slot = first; slot < slotCount; ) {
+        Chunk& chunk = ownChunk(slot / CHUNK_ROWS);
+        for (size_t i = slot % CHUNK_ROWS; i < chunk.ids.size(); ++i, ++slot) {
+            chunk.ids[i] = firstId++;
+        }
+    }
+}
+void RowArena::truncate(size_t count) {
+    if (count >= slotCount) {
+        return;
+    }
+    for (size_t slot = count; slot < slotCount; ++slot) {
+        size_t bytes = slotBytes(slot);
+        rowBytes -= bytes;
+        if (isLive(slot)) {
+            liveRows--;
+        } else {
+            deadBytes -= bytes;
+        }
+    }
+    chunks.resize((count + CHUNK_ROWS - 1) / CHUNK_ROWS);
+    size_t keep = count % CHUNK_ROWS;
+    if (keep != 0) {
+        // A replaced row may lie past the first dropped slot's bytes
+        size_t end = 0;
+        for (size_t i = 0; i < keep; ++i) {
+            end = std::max(end, chunks.back()->starts[i] + slotBytes(count - keep + i));
+        }
+        Chunk& last = ownChunk(chunks.size() - 1);
+        last.bytes.resize(end);
+        last.starts.resize(keep);
+        last.ids.resize(keep);
+        if (!last.dead.empty()) {
+            last.dead.resize(keep);
+        }
+    }
+    slotCount = count;
+}
+void RowArena::clear() {
+    std::vector<std::shared_ptr<Chunk>>().swap(chunks);
+    slotCount = 0;
+    liveRows = 0;
+    rowBytes = 0;
+    deadBytes = 0;
+}
+// Tombstones
+// ----------
+void RowArena::erase(size_t slot) {
+    if (!isLive(slot)) {
+        return;
+    }
+    Chunk& chunk = ownChunk(slot / CHUNK_ROWS);
+    if (chunk.dead.empty()) {
+        chunk.dead.resize(chunk.ids.size(), 0);
+    }
+    chunk.dead[slot % CHUNK_ROWS] = 1;
+    liveRows--;
+    deadBytes += slotBytes(slot);
+}
+void RowArena::replace(size_t slot, const RowView& row) {
+    size_t oldBytes = slotBytes(slot);
+    Chunk& chunk = ownChunk(slot / CHUNK_ROWS);
+    size_t bytes = 0;
+    chunk.starts[slot % CHUNK_ROWS] = writeRow(chunk, row, bytes);
+    rowBytes += bytes;
+    deadBytes += oldBytes;
+}
+bool RowArena::needsCompaction() const {
+    return deadBytes >= COMPACT_BYTES && deadBytes * 2 >= rowBytes;
+}
+void RowArena::compact() {
+    if (deadBytes == 0) {
+        return;
+    }
+    std::vector<size_t> live;
+    live.reserve(liveRows);
+    for (size_t slot = 0; slot < slotCount; ++slot) {
+        if (isLive(slot)) {
+            live.push_back(slot);
+        }
+    }
+    reorder(live);
+}
+void RowArena::reorder(const std::vector<size_t>& slots) {
+    RowArena moved;
+    std::vector<std::string_view> cells;
+    for (size_t slot : slots) {
+        readRow(slot, cells);
+        moved.append(cells, rowId(slot));
+    }
+    *this = std::move(moved);
+}
+// Reading
+// -------
+size_t RowArena::cellCount(size_t slot) const {
+    return readU32(rowStart(slot));
+}
+std::string_view RowArena::cell(size_t slot, size_t column) const {
+    const char* start = rowStart(slot);
+    uint32_t count = readU32(start);
+    const char* data = start + (1 + count) * sizeof(uint32_t);
+    uint32_t begin = column == 0 ? 0 : readU32(start + column * sizeof(uint32_t));
+    uint32_t end = readU32(start + (1 + column) * sizeof(uint32_t));
+    return std::string_view(data + begin, end - begin);
+}
+void RowArena::readRow(size_t slot, std::vector<std::string_view>& cells) const {
+    const char* start = rowStart(slot);
+    uint32_t count = readU32(start);
+    const char* data = start + (1 + count) * sizeof(uint32_t);
+    cells.resize(count);
+    uint32_t begin = 0;
+    for (uint32_t c = 0; c < count; ++c) {
+        uint32_t end = readU32(start + (1 + c) * sizeof(uint32_t));
+        cells[c] = std::string_view(data + begin, end - begin);
+        begin = end;
+    }
+}
+void RowArena::appendRowsTo(std::vector<std::vector<std::string>>& out, std::vector<uint64_t>* ids) const {
+    out.reserve(out.size() + liveRows);
+    std::vector<std::string_view> cells;
+    for (size_t slot = 0; slot < slotCount; ++slot) {
+        if (!isLive(slot)) {
+            continue;
+        }
+        readRow(slot, cells);
+        out.emplace_back(cells.begin(), cells.end());
+        if (ids) {
+            ids->push_back(rowId(slot));
+        }
+    }
+}
+bool RowArena::holdsKey(const RowView& row, const std::vector<int>& keyColumns,
+                        const std::vector<std::string>& key) {
+    for (int idx : keyColumns) {
+        size_t column = static_cast<size_t>(idx);
+        if (idx < 0 || column >= row.size() || column >= key.size() || row[column] != key[column]) {
+            return false;
+        }
+    }
+    return true;
+}
+bool RowArena::containsKey(const std::vector<int>& keyColumns, const std::vector<std::string>& key) const {
+    std::vector<std::string_view> row;
+    for (size_t slot = 0; slot < slotCount; ++slot) {
+        if (!isLive(slot)) {
+            continue;
+        }
+        readRow(slot, row);
+        if (holdsKey(row, keyColumns, key)) {
+            return true;
+        }
+    }
+    return false;
+}
+size_t RowArena::memoryBytes() const {
+    size_t total = sizeof(*this) + chunks.capacity() * sizeof(std::shared_ptr<Chunk>);
+    for (const auto& chunk : chunks) {
+        total += chunk->memoryBytes();
+    }
+    return total;
+}
+size_t RowArena::sharedBytes() const {
+    size_t total = 0;
+    for (const auto& chunk : chunks) {
+        if (chunk.use_count() > 1) {
+            total += chunk->memoryBytes();
+        }
+    }
+    return total;
+}
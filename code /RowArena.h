@@ -0,0 +1,111 @@
+#ifndef ROW_ARENA_H
+#define ROW_ARENA_H
+
+#include "ConditionParser.h"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+// In-memory rows of a ROW table, packed back to back into chunks instead of
+// a std::vector<std::string> per row. A row is its cell count, the end
+// offset of every cell and then the cell bytes, so appending one costs a
+// single copy. Cells are read as string_views into the chunks, and clearing
+// frees whole chunks.
+//
+// Every row sits in a slot and carries a row ID, usually ascending with the
+// slot. erase() only marks the slot dead, so a delete never moves another
+// row; compact() later copies the live rows into fresh chunks, renumbering
+// the slots but keeping every row's ID. replace() writes a row's new cells at
+// the end of its chunk and points the slot there, so an update keeps the
+// row's slot and ID; the old bytes count as dead until compaction.
+//
+// A chunk holds CHUNK_ROWS slots and is reference-counted: copying an arena
+// shares every chunk, and a chunk is copied only when one of the arenas
+// sharing it writes to it. A snapshot of a table thus costs a pointer per
+// chunk, and later writes copy just the chunks they touch.
+class RowArena {
+public:
+    // Slots per chunk
+    static constexpr size_t CHUNK_ROWS = 1024;
+    // Dead bytes from which compaction pays off
+    static constexpr size_t COMPACT_BYTES = 256 * 1024;
+
+    // Live rows, and slots including dead ones
+    size_t getRowCount() const { return liveRows; }
+    size_t getSlotCount() const { return slotCount; }
+
+    void append(const RowView& row, uint64_t id = 0);
+    // Moves every row of other to the end, taking over its chunks. A partial
+    // last chunk is filled up with dead slots first, so slots stay aligned
+    // to chunks.
+    void appendArena(RowArena&& other);
+    // Gives the slots from first on the IDs firstId, firstId + 1, ...
+    void numberRows(size_t first, uint64_t firstId);
+    // Drops the slots from count on
+    void truncate(size_t count);
+    void clear();
+
+    // Tombstones
+    bool isLive(size_t slot) const {
+        const Chunk& chunk = *chunks[slot / CHUNK_ROWS];
+        return chunk.dead.empty() || !chunk.dead[slot % CHUNK_ROWS];
+    }
+    void erase(size_t slot);
+    void replace(size_t slot, const RowView& row);
+    // Dead rows hold at least half of the row bytes, and COMPACT_BYTES
+    bool needsCompaction() const;
+    void compact();
+    // Rebuilds the arena from the given live slots in that order, keeping
+    // their IDs
+    void reorder(const std::vector<size_t>& slots);
+
+    // Row IDs
+    uint64_t rowId(size_t slot) const { return chunks[slot / CHUNK_ROWS]->ids[slot % CHUNK_ROWS]; }
+
+    // Views into the chunks, valid until the arena changes. These read dead
+    // slots as well; the whole-arena readers below skip them.
+    size_t cellCount(size_t slot) const;
+    std::string_view cell(size_t slot, size_t column) const;
+    void readRow(size_t slot, std::vector<std::string_view>& cells) const;
+    void appendRowsTo(std::vector<std::vector<std::string>>& out, std::vector<uint64_t>* ids = nullptr) const;
+
+    // True if row, or some live row, holds key's values in all of keyColumns
+    static bool holdsKey(const RowView& row, const std::vector<int>& keyColumns, const std::vector<std::string>& key);
+    bool containsKey(const std::vector<int>& keyColumns, const std::vector<std::string>& key) const;
+
+    // Bytes held by the chunks, and the part of them in chunks that another
+    // arena shares
+    size_t memoryBytes() const;
+    size_t sharedBytes() const;
+
+private:
+    struct Chunk {
+        std::vector<char> bytes;
+        std::vector<size_t> starts;    // offset of every slot's row in bytes
+        std::vector<uint64_t> ids;
+        std::vector<uint8_t> dead;     // empty until the first erase()
+        size_t memoryBytes() const;
+    };
+    std::vector<std::shared_ptr<Chunk>> chunks;
+    size_t slotCount = 0;
+    size_t liveRows = 0;
+    size_t rowBytes = 0;
+    size_t deadBytes = 0;
+
+    // Chunk index that no other arena shares, copying it if one does
+    Chunk& ownChunk(size_t index);
+    // Chunk with room for one more slot
+    Chunk& appendChunk();
+    // Writes row after the chunk's last byte; returns its offset and sets
+    // bytes to its size
+    static size_t writeRow(Chunk& chunk, const RowView& row, size_t& bytes);
+    const char* rowStart(size_t slot) const {
+        const Chunk& chunk = *chunks[slot / CHUNK_ROWS];
+        return chunk.bytes.data() + chunk.starts[slot % CHUNK_ROWS];
+    }
+    size_t slotBytes(size_t slot) const;
+};
+
+#endif // ROW_ARENA_H
@@ -1,92 +1,694 @@
 #include "Storage.h"
+#include "PageFormat.h"
+#include "AsyncIO.h"
+#include "TableSegment.h"
+#include "ColumnEncoding.h"
+#include "ZoneMap.h"
+#include "RowArena.h"
 #include "Utils.h"
+#include <algorithm>
+#include <set>
+#include <memory>
 #include <fstream>
 #include <iostream>
 #include <sstream>
+#include <filesystem>
+#include <thread>
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+// First line of a checkpoint manifest; older .db files start with a table count
+static const char* MANIFEST_MAGIC = "CSQLDB3";
+// Manifests written before tables had a log position of their own
+static const char* MANIFEST_MAGIC_V2 = "CSQLDB2";
+// Manifests written before delta files list one file per table and no row count
+static const char* MANIFEST_MAGIC_V1 = "CSQLDB1";
+// Delta files a table may collect before the next checkpoint rewrites it whole
+static const size_t MAX_DELTA_FILES = 8;
+// Tables with fewer data pages are decoded on the calling thread
+static const uint32_t PARALLEL_LOAD_MIN_PAGES = 256;
+// Page ranges handed out per load thread, so uneven pages still balance
+static const size_t RANGES_PER_THREAD = 4;
+// Schema (de)serialization shared by the binary table format
+static uint8_t encodeConstraintType(Constraint::Type type) {
+    switch (type) {
+        case Constraint::Type::PRIMARY_KEY: return 1;
+        case Constraint::Type::FOREIGN_KEY: return 2;
+        case Constraint::Type::UNIQUE: return 3;
+        case Constraint::Type::CHECK: return 4;
+        case Constraint::Type::NOT_NULL: return 5;
+    }
+    return 0;
+}
+static Constraint::Type decodeConstraintType(int type) {
+    switch (type) {
+        case 1: return Constraint::Type::PRIMARY_KEY;
+        case 2: return Constraint::Type::FOREIGN_KEY;
+        case 3: return Constraint::Type::UNIQUE;
+        case 4: return Constraint::Type::CHECK;
+        case 5: return Constraint::Type::NOT_NULL;
+        default: throw DatabaseException("Invalid constraint type");
+    }
+}
+static void writeSchema(ByteWriter& writer, const Table& table) {
+    const auto& columns = table.getColumns();
+    const auto& columnTypes = table.getColumnTypes();
+    const auto& notNullConstraints = table.getNotNullConstraints();
+    const auto& constraints = table.getConstraints();
+    
+    writer.putU32(static_cast<uint32_t>(columns.size()));
+    for (size_t i = 0; i < columns.size(); ++i) {
+        writer.putString(columns[i]);
+        writer.putString(columnTypes[i]);
+        writer.putU8(notNullConstraints[i] ? 1 : 0);
+    }
+    
+    writer.putU32(static_cast<uint32_t>(constraints.size()));
+    for (const auto& constraint : constraints) {
+        writer.putString(constraint.name);
+        writer.putU8(encodeConstraintType(constraint.type));
+        writer.putU32(static_cast<uint32_t>(constraint.columns.size()));
+        for (const auto& col : constraint.columns) {
+            writer.putString(col);
+        }
+        writer.putString(constraint.referencedTable);
+        writer.putU32(static_cast<uint32_t>(constraint.referencedColumns.size()));
+        for (const auto& col : constraint.referencedColumns) {
+            writer.putString(col);
+        }
+        writer.putU8(constraint.cascadeDelete ? 1 : 0);
+        writer.putU8(constraint.cascadeUpdate ? 1 : 0);
+        writer.putString(constraint.checkExpression);
+    }
+    
+    const auto& bloomColumns = table.getBloomFilterColumns();
+    writer.putU32(static_cast<uint32_t>(bloomColumns.size()));
+    for (const auto& col : bloomColumns) {
+        writer.putString(col);
+    }
+    
+    writer.putU8(static_cast<uint8_t>(table.getStorageMode()));
+    if (table.getStorageMode() == Table::StorageMode::CLUSTERED) {
+        const auto& clusterColumns = table.getClusterColumns();
+        writer.putU32(static_cast<uint32_t>(clusterColumns.size()));
+        for (const auto& col : clusterColumns) {
+            writer.putString(col);
+        }
+    }
+    
+    writer.putU8(static_cast<uint8_t>(table.getPartitionKind()));
+    if (table.isPartitioned()) {
+        writer.putString(table.getPartitionColumn());
+        const auto& partitions = table.getPartitions();
+        writer.putU32(static_cast<uint32_t>(partitions.size()));
+        for (const auto& partition : partitions) {
+            writer.putString(partition.name);
+            writer.putU32(static_cast<uint32_t>(partition.values.size()));
+            for (const auto& value : partition.values) {
+                writer.putString(value);
+            }
+        }
+    }
+    
+    writer.putU8(static_cast<uint8_t>(table.getColdPolicy()));
+    writer.putU32(table.getColdAfter());
+}
+static void readSchema(ByteReader& reader, Table* table) {
+    uint32_t columnCount = reader.getU32();
+    for (uint32_t i = 0; i < columnCount; ++i) {
+        std::string columnName = reader.getString();
+        std::string columnType = reader.getString();
+        bool notNull = reader.getU8() != 0;
+        table->addColumn(columnName, columnType, notNull);
+    }
+    
+    uint32_t constraintCount = reader.getU32();
+    for (uint32_t i = 0; i < constraintCount; ++i) {
+        std::string constraintName = reader.getString();
+        Constraint constraint(decodeConstraintType(reader.getU8()), constraintName);
+        
+        uint32_t colCount = reader.getU32();
+        for (uint32_t j = 0; j < colCount; ++j) {
+            constraint.columns.push_back(reader.getString());
+        }
+        constraint.referencedTable = reader.getString();
+        uint32_t refColCount = reader.getU32();
+        for (uint32_t j = 0; j < refColCount; ++j) {
+            constraint.referencedColumns.push_back(reader.getString());
+        }
+        constraint.cascadeDelete = reader.getU8() != 0;
+        constraint.cascadeUpdate = reader.getU8() != 0;
+        constraint.checkExpression = reader.getString();
+        
+        table->addConstraint(constraint);
+    }
+    
+    // Schemas written before Bloom filter columns existed end here
+    if (reader.remaining() > 0) {
+        uint32_t bloomCount = reader.getU32();
+        for (uint32_t i = 0; i < bloomCount; ++i) {
+            table->addBloomFilter(reader.getString());
+        }
+    }
+    // ... and before storage modes existed here
+    if (reader.remaining() > 0) {
+        uint8_t mode = reader.getU8();
+        if (mode == static_cast<uint8_t>(Table::StorageMode::COLUMN)) {
+            table->setStorageMode(Table::StorageMode::COLUMN);
+        } else if (mode == static_cast<uint8_t>(Table::StorageMode::CLUSTERED)) {
+            std::vector<std::string> clusterColumns(reader.getU32());
+            for (auto& col : clusterColumns) {
+                col = reader.getString();
+            }
+            table->setStorageMode(Table::StorageMode::CLUSTERED, clusterColumns);
+        } else if (mode != 0) {
+            throw DatabaseException("Invalid storage mode");
+        }
+    }
+    // ... and before partitioning existed here
+    if (reader.remaining() > 0) {
+        uint8_t kind = reader.getU8();
+        if (kind > static_cast<uint8_t>(Table::PartitionKind::HASH)) {
+            throw DatabaseException("Invalid partition kind");
+        }
+        if (kind != 0) {
+            std::string column = reader.getString();
+            std::vector<Table::Partition> partitions(reader.getU32());
+            for (auto& partition : partitions) {
+                partition.name = reader.getString();
+                uint32_t valueCount = reader.getU32();
+                for (uint32_t i = 0; i < valueCount; ++i) {
+                    partition.values.push_back(reader.getString());
+                }
+            }
+            table->setPartitioning(static_cast<Table::PartitionKind>(kind), column, partitions);
+        }
+    }
+    // ... and before tiering existed here
+    if (reader.remaining() > 0) {
+        uint8_t policy = reader.getU8();
+        uint32_t after = reader.getU32();
+        if (policy > static_cast<uint8_t>(Table::ColdPolicy::IDLE)) {
+            throw DatabaseException("Invalid cold policy");
+        }
+        if (policy != 0) {
+            table->setColdPolicy(static_cast<Table::ColdPolicy>(policy), after);
+        }
+    }
+}
+// Layout fields of a binary table file header
+struct TableFileHeader {
+    uint32_t version = 0;
+    uint32_t pageSize = 0;
+    uint32_t headerPages = 0;
+    uint32_t dataPages = 0;
+    uint64_t rowCount = 0;
+};
+// Reads the fixed header and the schema block, leaving the stream at the first
+// data page. Returns false for files in the legacy text format.
+static bool readTableHeader(std::ifstream& tableFile, TableFileHeader& header, std::vector<char>& schema) {
+    char fixedHeader[PageFormat::FILE_HEADER_SIZE];
+    tableFile.read(fixedHeader, sizeof(fixedHeader));
+    if (!PageFormat::hasMagic(fixedHeader, tableFile.gcount())) {
+        return false;
+    }
+    
+    ByteReader headerReader(fixedHeader, sizeof(fixedHeader));
+    headerReader.getU64(); // magic
+    header.version = headerReader.getU32();
+    header.pageSize = headerReader.getU32();
+    header.headerPages = headerReader.getU32();
+    header.dataPages = headerReader.getU32();
+    header.rowCount = headerReader.getU64();
+    
+    if (header.version != PageFormat::ROW_VERSION && header.version != PageFormat::COLUMNAR_VERSION) {
+        throw DatabaseException("Unsupported table file version " + std::to_string(header.version));
+    }
+    if (header.pageSize < PageFormat::FILE_HEADER_SIZE + 4 || header.headerPages == 0) {
+        throw DatabaseException("Corrupt table file header");
+    }
+    
+    // Read the rest of the header pages and cut out the schema
+    std::vector<char> buffer(static_cast<size_t>(header.headerPages) * header.pageSize - PageFormat::FILE_HEADER_SIZE);
+    tableFile.read(buffer.data(), buffer.size());
+    if (static_cast<size_t>(tableFile.gcount()) != buffer.size()) {
+        throw DatabaseException("Failed to read table schema");
+    }
+    
+    ByteReader schemaSizeReader(buffer.data(), buffer.size());
+    uint32_t schemaBytes = schemaSizeReader.getU32();
+    if (schemaBytes > schemaSizeReader.remaining()) {
+        throw DatabaseException("Corrupt table schema block");
+    }
+    schema.assign(buffer.begin() + 4, buffer.begin() + 4 + schemaBytes);
+    return true;
+}
 void Storage::saveTableToFile(const Table& table, const std::string& tableName) {
+    saveTableToPath(table, tableName + ".tbl");
+}
+uint64_t Storage::saveTableToPath(const Table& table, const std::string& filePath, uint64_t firstRow) {
     try {
-        std::ofstream tableFile(tableName + ".tbl");
-        if (!tableFile) {
-            throw DatabaseException("Failed to open file for writing: " + tableName + ".tbl");
-        }
+        // Pages are written asynchronously while later ones are encoded
+        AsyncFileWriter tableFile(filePath, ioQueueDepth);
         
-        // Write table schema
-        const auto& columns = table.getColumns();
-        const auto& columnTypes = table.getColumnTypes();
-        const auto& notNullConstraints = table.getNotNullConstraints();
-        const auto& constraints = table.getConstraints();
+        const uint32_t pageSize = PageFormat::PAGE_SIZE;
         
-        // Write column definitions
-        tableFile << columns.size() << std::endl;
-        for (size_t i = 0; i < columns.size(); ++i) {
-            tableFile << columns[i] << "," << columnTypes[i] << "," << (notNullConstraints[i] ? "1" : "0") << std::endl;
+        // Serialize the schema first so we know how many header pages to reserve
+        std::vector<char> schema;
+        ByteWriter schemaWriter(schema);
+        writeSchema(schemaWriter, table);
+        
+        // A first pass over the rows picks an encoding for every column
+        std::vector<ColumnCodec> codecs;
+        std::vector<char> codecBlock;
+        bool columnar = false;
+        if (compression && !table.getColumns().empty()) {
+            EncodingPlanner planner(table.getColumnTypes());
+            uint64_t plannedRow = 0;
+            table.forEachRow([&](const RowView& row) {
+                if (plannedRow++ >= firstRow) {
+                    planner.addRow(row);
+                }
+            });
+            if (planner.isUsable()) {
+                codecs = planner.choose();
+                ByteWriter codecWriter(codecBlock);
+                ColumnCodecs::write(codecWriter, codecs);
+                columnar = true;
+            }
         }
         
-        // Write constraints
-        tableFile << constraints.size() << std::endl;
-        for (const auto& constraint : constraints) {
-            // Write constraint type
-            int type = 0;
-            switch (constraint.type) {
-                case Constraint::Type::PRIMARY_KEY: type = 1; break;
-                case Constraint::Type::FOREIGN_KEY: type = 2; break;
-                case Constraint::Type::UNIQUE: type = 3; break;
-                case Constraint::Type::CHECK: type = 4; break;
-                case Constraint::Type::NOT_NULL: type = 5; break;
+        size_t headerBytes = PageFormat::FILE_HEADER_SIZE + 4 + schema.size() +
+                             (columnar ? 4 + codecBlock.size() : 0);
+        uint32_t headerPages = static_cast<uint32_t>((headerBytes + pageSize - 1) / pageSize);
+        
+        // Placeholder header; rewritten once page and row counts are known
+        std::vector<char> header(static_cast<size_t>(headerPages) * pageSize, 0);
+        tableFile.write(header.data(), header.size());
+        
+        // Write data pages
+        uint32_t dataPages = 0;
+        uint64_t rowCount = 0;
+        std::vector<char> payload;
+        uint32_t pageRows = 0;
+        std::vector<char> page;
+        std::vector<BlockZone> zones;
+        std::vector<size_t> keyColumns = table.getKeyColumnIndexes();
+        BlockZone pageZone;
+        pageZone.trackKeys(keyColumns);
+        
+        auto flushPage = [&]() {
+            if (pageRows == 0) {
+                return;
             }
+            pageZone.firstPage = dataPages;
+            pageZone.finish();
+            zones.push_back(std::move(pageZone));
+            pageZone = BlockZone();
+            pageZone.trackKeys(keyColumns);
+            size_t pageBytes = PageFormat::PAGE_HEADER_SIZE + payload.size();
+            uint32_t spanPages = static_cast<uint32_t>((pageBytes + pageSize - 1) / pageSize);
             
-            tableFile << constraint.name << "," << type << ",";
+            page.clear();
+            ByteWriter pageWriter(page);
+            pageWriter.putU32(pageRows);
+            pageWriter.putU32(static_cast<uint32_t>(payload.size()));
+            pageWriter.putU32(spanPages);
+            pageWriter.putU32(PageFormat::checksum(payload.data(), payload.size()));
+            pageWriter.putBytes(payload.data(), payload.size());
+            page.resize(static_cast<size_t>(spanPages) * pageSize, 0);
             
-            // Write constraint columns
-            tableFile << constraint.columns.size();
-            for (const auto& col : constraint.columns) {
-                tableFile << "," << col;
+            tableFile.write(page.data(), page.size());
+            dataPages += spanPages;
+            payload.clear();
+            pageRows = 0;
+        };
+        
+        PageEncoder encoder(codecs);
+        auto flushColumnarPage = [&]() {
+            pageRows = encoder.rowCount();
+            encoder.finish(payload);
+            flushPage();
+        };
+        
+        // Mapped tables are streamed from their segment without materializing
+        uint64_t rowIndex = 0;
+        table.forEachRow([&](const RowView& row) {
+            if (rowIndex++ < firstRow) {
+                return;
             }
-            
-            // Write additional info for foreign keys
-            if (constraint.type == Constraint::Type::FOREIGN_KEY) {
-                tableFile << "," << constraint.referencedTable;
-                tableFile << "," << constraint.referencedColumns.size();
-                for (const auto& col : constraint.referencedColumns) {
-                    tableFile << "," << col;
+            if (columnar) {
+                if (encoder.rowCount() > 0 &&
+                    PageFormat::PAGE_HEADER_SIZE + encoder.sizeWithRow(row) > pageSize) {
+                    flushColumnarPage();
                 }
-                tableFile << "," << (constraint.cascadeDelete ? "1" : "0");
-                tableFile << "," << (constraint.cascadeUpdate ? "1" : "0");
-            } else if (constraint.type == Constraint::Type::CHECK) {
-                tableFile << "," << constraint.checkExpression;
+                encoder.addRow(row);
+                pageZone.add(row);
+                rowCount++;
+                return;
+            }
+            size_t rowBytes = PageFormat::encodedRowSize(row);
+            if (pageRows > 0 && PageFormat::PAGE_HEADER_SIZE + payload.size() + rowBytes > pageSize) {
+                flushPage();
             }
             
-            tableFile << std::endl;
-        }
-        
-        // Write rows
-        const auto& rows = table.getRows();
-        tableFile << rows.size() << std::endl;
-        for (const auto& row : rows) {
-            tableFile << row.size();
-            for (const auto& cell : row) {
-                // Escape commas in cell values
-                std::string escapedCell = cell;
-                size_t pos = 0;
-                while ((pos = escapedCell.find(",", pos)) != std::string::npos) {
-                    escapedCell.replace(pos, 1, "\\,");
-                    pos += 2;
-                }
-                tableFile << "," << escapedCell;
+            ByteWriter rowWriter(payload);
+            rowWriter.putU32(static_cast<uint32_t>(row.size()));
+            for (size_t i = 0; i < row.size(); ++i) {
+                rowWriter.putString(row[i]);
+            }
+            pageZone.add(row);
+            pageRows++;
+            rowCount++;
+        });
+        if (columnar) {
+            if (encoder.rowCount() > 0) {
+                flushColumnarPage();
             }
-            tableFile << std::endl;
+        } else {
+            flushPage();
         }
         
+        // Zone trailer after the last data page
+        std::vector<char> trailer;
+        ByteWriter trailerWriter(trailer);
+        ZoneMaps::writeTrailer(trailerWriter, zones);
+        tableFile.write(trailer.data(), trailer.size());
+        
+        // Fill in the file header
+        header.clear();
+        ByteWriter headerWriter(header);
+        headerWriter.putBytes(PageFormat::MAGIC, sizeof(PageFormat::MAGIC));
+        headerWriter.putU32(columnar ? PageFormat::COLUMNAR_VERSION : PageFormat::ROW_VERSION);
+        headerWriter.putU32(pageSize);
+        headerWriter.putU32(headerPages);
+        headerWriter.putU32(dataPages);
+        headerWriter.putU64(rowCount);
+        headerWriter.putU32(static_cast<uint32_t>(schema.size()));
+        headerWriter.putBytes(schema.data(), schema.size());
+        if (columnar) {
+            headerWriter.putU32(static_cast<uint32_t>(codecBlock.size()));
+            headerWriter.putBytes(codecBlock.data(), codecBlock.size());
+        }
+        
+        tableFile.writeAt(0, header.data(), header.size());
         tableFile.close();
+        return rowCount;
     } catch (const std::exception& e) {
         throw DatabaseException("Error saving table: " + std::string(e.what()));
     }
 }
+Storage::Storage() {
+    bufferPool->setPrefetchDepth(ioQueueDepth);
+}
+void Storage::setIoQueueDepth(unsigned depth) {
+    ioQueueDepth = depth;
+    bufferPool->setPrefetchDepth(depth);
+}
+void Storage::setBufferPoolSize(size_t bytes) {
+    if (bytes > 0) {
+        bufferPool->setCapacity(bytes);
+    }
+    bufferPoolEnabled = bytes > 0;
+}
+size_t Storage::getBufferPoolSize() const {
+    return bufferPoolEnabled ? bufferPool->getCapacity() : 0;
+}
+// Parallel loading
+// ----------------
+static size_t effectiveThreads(size_t configured) {
+    return configured > 0 ? configured : std::max(1u, std::thread::hardware_concurrency());
+}
+void Storage::setLoadThreads(size_t threads) {
+    std::lock_guard<std::mutex> lock(poolMutex);
+    if (threads != loadThreads) {
+        loadThreads = threads;
+        // Loads still running keep their reference to the old pool
+        pool.reset();
+    }
+}
+size_t Storage::getLoadThreads() const {
+    std::lock_guard<std::mutex> lock(poolMutex);
+    return effectiveThreads(loadThreads);
+}
+void Storage::runParallel(size_t count, const std::function<void(size_t)>& body) {
+    std::shared_ptr<ThreadPool> workers;
+    {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        size_t threads = effectiveThreads(loadThreads);
+        if (threads > 1 && count > 1) {
+            if (!pool) {
+                pool = std::make_shared<ThreadPool>(threads);
+            }
+            workers = pool;
+        }
+    }
+    
+    if (!workers) {
+        for (size_t i = 0; i < count; ++i) {
+            body(i);
+        }
+        return;
+    }
+    workers->parallelFor(count, body);
+}
+// Decodes the data pages of a binary table file in independent page ranges.
+// Rows are handed to the table in file order once every range is decoded.
+void Storage::loadPagesInParallel(const std::string& filePath, Table* table, uint64_t rowCount, bool verify) {
+    // Every page is decoded once, so mapping beats caching them in the pool
+    TableSegment segment(filePath);
+    std::vector<uint32_t> pageStarts = segment.getPageStarts();
+    
+    size_t rangeCount = std::min(pageStarts.size(), getLoadThreads() * RANGES_PER_THREAD);
+    std::vector<RowArena> rangeRows(rangeCount);
+    runParallel(rangeCount, [&](size_t range) {
+        uint32_t firstPage = pageStarts[range * pageStarts.size() / rangeCount];
+        size_t endIndex = (range + 1) * pageStarts.size() / rangeCount;
+        uint32_t endPage = endIndex < pageStarts.size() ? pageStarts[endIndex] : UINT32_MAX;
+        
+        TableSegment::Cursor cursor(segment, firstPage, endPage);
+        std::vector<std::string_view> row;
+        while (cursor.next(row)) {
+            rangeRows[range].append(row);
+        }
+    });
+    
+    // The ranges' slabs are chained together, so no row is copied twice
+    RowArena loadedRows;
+    for (auto& rows : rangeRows) {
+        loadedRows.appendArena(std::move(rows));
+    }
+    if (loadedRows.getRowCount() != rowCount) {
+        throw DatabaseException("Row count mismatch in table file");
+    }
+    table->bulkLoadRows(std::move(loadedRows), verify);
+}
 Table* Storage::loadTableFromFile(const std::string& tableName) {
+    return loadTableFromPath(tableName + ".tbl", tableName);
+}
+Table* Storage::loadTableFromPath(const std::string& filePath, const std::string& tableName, bool verifyRows) {
+    bool verify = verifyRows && verifyOnLoad;
+    std::error_code error;
+    uintmax_t fileSize = std::filesystem::file_size(filePath, error);
+    if (!error && mappingThreshold > 0 && fileSize >= mappingThreshold) {
+        std::ifstream probe(filePath, std::ios::binary);
+        char magic[sizeof(PageFormat::MAGIC)];
+        probe.read(magic, sizeof(magic));
+        if (PageFormat::hasMagic(magic, probe.gcount())) {
+            return mapTableFromPath(filePath, tableName);
+        }
+    }
+    
+    try {
+        std::ifstream tableFile(filePath, std::ios::binary);
+        if (!tableFile) {
+            throw DatabaseException("Failed to open file for reading: " + filePath);
+        }
+        
+        TableFileHeader header;
+        std::vector<char> schema;
+        if (!readTableHeader(tableFile, header, schema)) {
+            // Files written before the binary format are still readable
+            tableFile.close();
+            return loadLegacyTableFile(filePath, tableName, verify);
+        }
+        uint32_t pageSize = header.pageSize;
+        uint32_t dataPages = header.dataPages;
+        uint64_t rowCount = header.rowCount;
+        ByteReader schemaReader(schema.data(), schema.size());
+        
+        std::unique_ptr<Table> table = std::make_unique<Table>(tableName);
+        readSchema(schemaReader, table.get());
+        
+        // Columnar pages are decoded by TableSegment, in parallel when large
+        if (header.version == PageFormat::COLUMNAR_VERSION ||
+            (dataPages >= PARALLEL_LOAD_MIN_PAGES && getLoadThreads() > 1)) {
+            tableFile.close();
+            loadPagesInParallel(filePath, table.get(), rowCount, verify);
+            return table.release();
+        }
+        
+        // Read data pages in large batches, several batches ahead of decoding.
+        // Stored rows were validated when written, so they are collected and
+        // handed over in one trusted step.
+        tableFile.close();
+        uint64_t dataStart = static_cast<uint64_t>(header.headerPages) * pageSize;
+        AsyncFileReader pageReader(filePath, dataStart, dataStart + static_cast<uint64_t>(dataPages) * pageSize,
+                                   PageFormat::PAGES_PER_READ * pageSize, ioQueueDepth);
+        std::vector<char> buffer;
+        std::vector<char> batch;
+        size_t offset = 0;
+        uint32_t pagesConsumed = 0;
+        RowArena loadedRows;
+        std::vector<std::string_view> rowData;
+        
+        while (pagesConsumed < dataPages) {
+            if (offset == buffer.size()) {
+                if (!pageReader.next(buffer)) {
+                    throw DatabaseException("Failed to read data pages");
+                }
+                offset = 0;
+            }
+            
+            ByteReader pageHeader(buffer.data() + offset, PageFormat::PAGE_HEADER_SIZE);
+            uint32_t pageRows = pageHeader.getU32();
+            uint32_t payloadBytes = pageHeader.getU32();
+            uint32_t spanPages = pageHeader.getU32();
+            uint32_t expectedChecksum = pageHeader.getU32();
+            
+            if (spanPages == 0 || pagesConsumed + spanPages > dataPages ||
+                PageFormat::PAGE_HEADER_SIZE + payloadBytes > static_cast<size_t>(spanPages) * pageSize) {
+                throw DatabaseException("Corrupt data page header");
+            }
+            size_t spanBytes = static_cast<size_t>(spanPages) * pageSize;
+            while (offset + spanBytes > buffer.size()) {
+                // An oversized row run crosses the batch boundary: pull in the next batch
+                buffer.erase(buffer.begin(), buffer.begin() + offset);
+                offset = 0;
+                if (!pageReader.next(batch)) {
+                    throw DatabaseException("Failed to read data pages");
+                }
+                buffer.insert(buffer.end(), batch.begin(), batch.end());
+            }
+            
+            const char* payload = buffer.data() + offset + PageFormat::PAGE_HEADER_SIZE;
+            if (PageFormat::checksum(payload, payloadBytes) != expectedChecksum) {
+                throw DatabaseException("Checksum mismatch in data page");
+            }
+            
+            // Cells are copied straight from the page into the arena
+            ByteReader rowReader(payload, payloadBytes);
+            for (uint32_t r = 0; r < pageRows; ++r) {
+                uint32_t cellCount = rowReader.getU32();
+                rowData.clear();
+                for (uint32_t c = 0; c < cellCount; ++c) {
+                    rowData.push_back(rowReader.getStringView());
+                }
+                loadedRows.append(rowData);
+            }
+            
+            offset += spanBytes;
+            pagesConsumed += spanPages;
+        }
+        
+        if (loadedRows.getRowCount() != rowCount) {
+            throw DatabaseException("Row count mismatch in table file");
+        }
+        table->bulkLoadRows(std::move(loadedRows), verify);
+        return table.release();
+    } catch (const std::exception& e) {
+        throw DatabaseException("Error loading table: " + std::string(e.what()));
+    }
+}
+// Loads the base file of a checkpointed table and appends its delta files
+Table* Storage::loadCheckpointTable(const std::string& directory, const std::string& tableName,
+                                    const CheckpointTable& files, bool verifyRows) {
+    auto pathOf = [&](const std::string& fileName) {
+        return (std::filesystem::path(directory) / fileName).string();
+    };
+    
+    // With deltas the rows are verified once, after the last one is appended;
+    // a mapped base stays mapped and takes the deltas after its own rows
+    std::unique_ptr<Table> table(loadTableFromPath(pathOf(files.baseFile), tableName,
+                                                   verifyRows && files.deltaFiles.empty()));
+    for (size_t i = 0; i < files.deltaFiles.size(); ++i) {
+        std::unique_ptr<Table> delta(loadTableFromPath(pathOf(files.deltaFiles[i]), tableName, false));
+        bool last = i + 1 == files.deltaFiles.size();
+        table->appendDelta(*delta, verifyRows && verifyOnLoad && last);
+    }
+    return table.release();
+}
+// Reads only the schema; the rows follow on first access to the table
+Table* Storage::openTableLazily(const std::string& directory, const std::string& tableName,
+                                const CheckpointTable& files) {
+    std::string filePath = (std::filesystem::path(directory) / files.baseFile).string();
+    try {
+        std::ifstream tableFile(filePath, std::ios::binary);
+        if (!tableFile) {
+            throw DatabaseException("Failed to open file for reading: " + filePath);
+        }
+        
+        TableFileHeader header;
+        std::vector<char> schema;
+        if (!readTableHeader(tableFile, header, schema)) {
+            // Legacy text files have no separate schema; load them in full
+            tableFile.close();
+            return loadCheckpointTable(directory, tableName, files, true);
+        }
+        
+        std::unique_ptr<Table> table = std::make_unique<Table>(tableName);
+        ByteReader schemaReader(schema.data(), schema.size());
+        readSchema(schemaReader, table.get());
+        
+        table->deferRows(filePath, [this, directory, tableName, files](Table& target) {
+            std::unique_ptr<Table> loaded(loadCheckpointTable(directory, tableName, files, true));
+            target.adoptRows(*loaded);
+        });
+        
+        return table.release();
+    } catch (const std::exception& e) {
+        throw DatabaseException("Error opening table: " + std::string(e.what()));
+    }
+}
+// Large tables are scanned in place instead of decoded; their pages live in
+// the buffer pool (or the page cache when the pool is off)
+Table* Storage::mapTableFromPath(const std::string& filePath, const std::string& tableName) {
+    try {
+        auto segment = std::make_shared<const TableSegment>(filePath,
+                                                            bufferPoolEnabled ? bufferPool : nullptr);
+        
+        std::unique_ptr<Table> table = std::make_unique<Table>(tableName);
+        ByteReader schemaReader(segment->getSchemaData(), segment->getSchemaSize());
+        readSchema(schemaReader, table.get());
+        table->attachSegment(segment);
+        
+        return table.release();
+    } catch (const std::exception& e) {
+        throw DatabaseException("Error mapping table: " + std::string(e.what()));
+    }
+}
+// The file is unlinked as soon as it is open: the mapping or the buffer
+// pool's descriptor keeps it readable, and the disk space returns once the
+// segment is dropped
+std::shared_ptr<const TableSegment> Storage::spillTable(const Table& table, const std::string& filePath) {
+    saveTableToPath(table, filePath);
+    try {
+        auto segment = std::make_shared<const TableSegment>(filePath,
+                                                            bufferPoolEnabled ? bufferPool : nullptr);
+        std::remove(filePath.c_str());
+        return segment;
+    } catch (const std::exception& e) {
+        std::remove(filePath.c_str());
+        throw DatabaseException("Error spilling table: " + std::string(e.what()));
+    }
+}
+// Reads the comma-separated text format used before binary table files
+Table* Storage::loadLegacyTableFile(const std::string& filePath, const std::string& tableName, bool verify) {
     try {
-        std::ifstream tableFile(tableName + ".tbl");
+        std::ifstream tableFile(filePath);
         if (!tableFile) {
-            throw DatabaseException("Failed to open file for reading: " + tableName + ".tbl");
+            throw DatabaseException("Failed to open file for reading: " + filePath);
         }
         
         std::string line;
@@ -196,6 +798,7 @@ Table* Storage::loadTableFromFile(const std::string& tableName) {
         }
         int rowCount = std::stoi(line);
         
+        std::vector<std::vector<std::string>> loadedRows;
         for (int i = 0; i < rowCount; ++i) {
             if (!std::getline(tableFile, line)) {
                 throw DatabaseException("Failed to read row data");
@@ -239,9 +842,9 @@ Table* Storage::loadTableFromFile(const std::string& tableName) {
                 throw DatabaseException("Invalid cell count in row");
             }
             
-            std::vector<std::string> rowData(cellValues.begin() + 1, cellValues.end());
-            table->addRow(rowData);
+            loadedRows.emplace_back(cellValues.begin() + 1, cellValues.end());
         }
+        table->bulkLoadRows(std::move(loadedRows), verify);
         
         tableFile.close();
         return table;
@@ -293,14 +896,20 @@ void Storage::loadDatabase(const std::string& dbName,
         }
         int tableCount = std::stoi(line);
         
+        std::vector<std::string> tableNames;
         for (int i = 0; i < tableCount; ++i) {
             if (!std::getline(dbFile, line)) {
                 throw DatabaseException("Failed to read table name");
             }
-            
-            std::string tableName = line;
-            Table* table = loadTableFromFile(tableName);
-            tables[toLowerCase(tableName)] = table;
+            tableNames.push_back(line);
+        }
+        
+        std::vector<std::unique_ptr<Table>> loaded(tableNames.size());
+        runParallel(tableNames.size(), [&](size_t i) {
+            loaded[i].reset(loadTableFromFile(tableNames[i]));
+        });
+        for (size_t i = 0; i < tableNames.size(); ++i) {
+            tables[toLowerCase(tableNames[i])] = loaded[i].release();
         }
         
         // Read views
@@ -329,4 +938,422 @@ void Storage::loadDatabase(const std::string& dbName,
     } catch (const std::exception& e) {
         throw DatabaseException("Error loading database: " + std::string(e.what()));
     }
-}
\ No newline at end of file
+}
+// Checkpoints
+// -----------
+// Forces a file or directory to stable storage
+static void syncPath(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw DatabaseException("Failed to open for sync: " + path);
+    }
+    int result = ::fsync(fd);
+    ::close(fd);
+    if (result != 0) {
+        throw DatabaseException("Failed to sync: " + path);
+    }
+}
+static std::filesystem::path databaseDirectory(const std::string& dbName) {
+    std::filesystem::path directory = std::filesystem::path(dbName).parent_path();
+    return directory.empty() ? std::filesystem::path(".") : directory;
+}
+static std::string databaseBaseName(const std::string& dbName) {
+    return std::filesystem::path(dbName).filename().string();
+}
+// The schema goes through its file encoding, so the copy carries the
+// constraints, Bloom filter columns and cold policy the file stores
+static std::unique_ptr<Table> checkpointCopy(const Table& table) {
+    std::vector<char> schema;
+    ByteWriter schemaWriter(schema);
+    writeSchema(schemaWriter, table);
+    
+    auto copy = std::make_unique<Table>(table.getName());
+    ByteReader schemaReader(schema.data(), schema.size());
+    readSchema(schemaReader, copy.get());
+    copy->copyRowsFrom(table);
+    return copy;
+}
+PendingCheckpoint Storage::prepareCheckpoint(const std::string& dbName,
+                                             const std::map<std::string, Table*>& tables,
+                                             const std::map<std::string, std::string>& views,
+                                             uint64_t lsn,
+                                             const std::set<std::string>* onlyTables) {
+    PendingCheckpoint checkpoint;
+    checkpoint.dbName = dbName;
+    checkpoint.lsn = lsn;
+    checkpoint.views = views;
+    for (const auto& [tableKey, table] : tables) {
+        PendingCheckpoint::TableCopy& entry = checkpoint.tables[tableKey];
+        entry.name = table->getName();
+        
+        // Untouched tables (this includes tables whose rows were never
+        // loaded) keep their files and need no copy
+        auto last = persisted.find(tableKey);
+        bool changed = last == persisted.end() || last->second.version != table->getVersion();
+        if (changed && last != persisted.end() && onlyTables != nullptr &&
+            onlyTables->find(tableKey) == onlyTables->end()) {
+            // Left to a later checkpoint; the log still holds its changes
+            entry.version = last->second.version;
+            entry.rewriteVersion = last->second.rewriteVersion;
+            entry.lsn = last->second.files.lsn;
+            continue;
+        }
+        entry.version = table->getVersion();
+        entry.rewriteVersion = table->getRewriteVersion();
+        entry.lsn = lsn;
+        if (changed) {
+            entry.rows = checkpointCopy(*table);
+        }
+    }
+    return checkpoint;
+}
+void Storage::saveCheckpoint(const PendingCheckpoint& checkpoint) {
+    const std::string& dbName = checkpoint.dbName;
+    try {
+        CheckpointManifest previous;
+        readManifest(dbName, previous);
+        
+        CheckpointManifest manifest;
+        manifest.lsn = checkpoint.lsn;
+        manifest.generation = previous.generation + 1;
+        manifest.views = checkpoint.views;
+        
+        std::filesystem::path directory = databaseDirectory(dbName);
+        std::string generation = std::to_string(manifest.generation);
+        
+        // Table files of a new generation are invisible until the manifest
+        // points at them, so they can be written in place
+        std::map<std::string, PersistedTable> written;
+        for (const auto& [tableKey, entry] : checkpoint.tables) {
+            PersistedTable state;
+            state.version = entry.version;
+            state.rewriteVersion = entry.rewriteVersion;
+            
+            auto last = persisted.find(tableKey);
+            bool known = last != persisted.end() &&
+                         last->second.files.rowCount != CheckpointTable::UNKNOWN_ROW_COUNT;
+            std::string fileName = databaseBaseName(dbName) + "." + tableKey + "." + generation + ".tbl";
+            std::string filePath = (directory / fileName).string();
+            
+            if (!entry.rows) {
+                state.files = last->second.files;
+            } else if (known && last->second.rewriteVersion == state.rewriteVersion &&
+                       last->second.files.deltaFiles.size() < MAX_DELTA_FILES) {
+                // Only appends: write the new rows as a delta
+                state.files = last->second.files;
+                if (static_cast<uint64_t>(entry.rows->getRowCount()) != state.files.rowCount) {
+                    state.files.rowCount += saveTableToPath(*entry.rows, filePath, state.files.rowCount);
+                    syncPath(filePath);
+                    state.files.deltaFiles.push_back(fileName);
+                }
+            } else {
+                // Rewrites a long delta chain into a single file too
+                state.files.baseFile = fileName;
+                state.files.rowCount = saveTableToPath(*entry.rows, filePath);
+                syncPath(filePath);
+            }
+            state.files.lsn = entry.lsn;
+            
+            manifest.tableFiles[entry.name] = state.files;
+            written[tableKey] = std::move(state);
+        }
+        
+        // Publishing the manifest is the commit point of the checkpoint
+        std::string manifestPath = dbName + ".db";
+        std::string tempPath = manifestPath + ".tmp";
+        writeManifest(tempPath, manifest);
+        syncPath(tempPath);
+        if (std::rename(tempPath.c_str(), manifestPath.c_str()) != 0) {
+            throw DatabaseException("Failed to replace " + manifestPath);
+        }
+        syncPath(directory.string());
+        
+        persisted = std::move(written);
+        persistedLsn = manifest.lsn;
+        
+        removeObsoleteFiles(dbName, manifest);
+    } catch (const std::exception& e) {
+        throw DatabaseException("Error writing checkpoint: " + std::string(e.what()));
+    }
+}
+uint64_t Storage::loadCheckpoint(const std::string& dbName,
+                                 std::map<std::string, Table*>& tables,
+                                 std::map<std::string, std::string>& views) {
+    CheckpointManifest manifest;
+    if (!readManifest(dbName, manifest)) {
+        return 0;
+    }
+    
+    try {
+        std::filesystem::path directory = databaseDirectory(dbName);
+        std::vector<std::pair<std::string, CheckpointTable>> entries(manifest.tableFiles.begin(),
+                                                                     manifest.tableFiles.end());
+        std::vector<std::unique_ptr<Table>> loaded(entries.size());
+        
+        if (lazyLoading) {
+            for (size_t i = 0; i < entries.size(); ++i) {
+                loaded[i].reset(openTableLazily(directory.string(), entries[i].first, entries[i].second));
+            }
+        } else {
+            // Tables are independent, so they load concurrently
+            runParallel(entries.size(), [&](size_t i) {
+                loaded[i].reset(loadCheckpointTable(directory.string(), entries[i].first, entries[i].second, true));
+            });
+        }
+        
+        persisted.clear();
+        persistedLsn = manifest.lsn;
+        for (size_t i = 0; i < entries.size(); ++i) {
+            std::string tableKey = toLowerCase(entries[i].first);
+            PersistedTable& state = persisted[tableKey];
+            state.files = entries[i].second;
+            state.version = loaded[i]->getVersion();
+            state.rewriteVersion = loaded[i]->getRewriteVersion();
+            tables[tableKey] = loaded[i].release();
+        }
+    } catch (const std::exception& e) {
+        throw DatabaseException("Error loading checkpoint: " + std::string(e.what()));
+    }
+    views = manifest.views;
+    
+    uint64_t lsn = manifest.lsn;
+    for (const auto& entry : manifest.tableFiles) {
+        lsn = std::min(lsn, entry.second.lsn);
+    }
+    return lsn;
+}
+uint64_t Storage::getCheckpointedLsn(const std::string& tableKey) const {
+    auto entry = persisted.find(tableKey);
+    return entry != persisted.end() ? entry->second.files.lsn : persistedLsn;
+}
+bool Storage::readManifest(const std::string& dbName, CheckpointManifest& manifest) {
+    std::ifstream dbFile(dbName + ".db");
+    if (!dbFile) {
+        return false;
+    }
+    
+    try {
+        std::string line;
+        if (!std::getline(dbFile, line)) {
+            throw DatabaseException("Empty database file");
+        }
+        
+        std::string magic = trim(line);
+        bool legacy = magic != MANIFEST_MAGIC && magic != MANIFEST_MAGIC_V2 && magic != MANIFEST_MAGIC_V1;
+        bool singleFile = magic == MANIFEST_MAGIC_V1;
+        bool tableLsns = magic == MANIFEST_MAGIC;
+        if (!legacy) {
+            // LSN and generation, then the table count
+            if (!std::getline(dbFile, line)) {
+                throw DatabaseException("Failed to read checkpoint position");
+            }
+            std::istringstream position(line);
+            if (!(position >> manifest.lsn >> manifest.generation)) {
+                throw DatabaseException("Invalid checkpoint position");
+            }
+            if (!std::getline(dbFile, line)) {
+                throw DatabaseException("Failed to read table count");
+            }
+        }
+        
+        // Legacy files list bare table names stored as <table>.tbl
+        int tableCount = std::stoi(line);
+        for (int i = 0; i < tableCount; ++i) {
+            if (!std::getline(dbFile, line)) {
+                throw DatabaseException("Failed to read table entry");
+            }
+            if (legacy) {
+                manifest.tableFiles[line].baseFile = line + ".tbl";
+                continue;
+            }
+            
+            // name, LSN, row count, base file, delta files (tab-separated);
+            // earlier manifests have no LSN, as their tables share one
+            std::vector<std::string> fields;
+            std::istringstream entry(line);
+            std::string field;
+            while (std::getline(entry, field, '\t')) {
+                fields.push_back(field);
+            }
+            if (fields.size() < 2 || (!singleFile && fields.size() < (tableLsns ? 4u : 3u))) {
+                throw DatabaseException("Invalid table entry");
+            }
+            CheckpointTable& files = manifest.tableFiles[fields[0]];
+            files.lsn = manifest.lsn;
+            if (tableLsns) {
+                files.lsn = std::stoull(fields[1]);
+                fields.erase(fields.begin() + 1);
+            }
+            if (singleFile) {
+                files.baseFile = fields[1];
+                continue;
+            }
+            files.rowCount = std::stoull(fields[1]);
+            files.baseFile = fields[2];
+            files.deltaFiles.assign(fields.begin() + 3, fields.end());
+        }
+        
+        if (!std::getline(dbFile, line)) {
+            throw DatabaseException("Failed to read view count");
+        }
+        int viewCount = std::stoi(line);
+        for (int i = 0; i < viewCount; ++i) {
+            if (!std::getline(dbFile, line)) {
+                throw DatabaseException("Failed to read view definition");
+            }
+            size_t commaPos = line.find(',');
+            if (commaPos == std::string::npos) {
+                throw DatabaseException("Invalid view definition format");
+            }
+            manifest.views[toLowerCase(line.substr(0, commaPos))] = line.substr(commaPos + 1);
+        }
+    } catch (const std::exception& e) {
+        throw DatabaseException("Error reading " + dbName + ".db: " + std::string(e.what()));
+    }
+    
+    return true;
+}
+void Storage::writeManifest(const std::string& path, const CheckpointManifest& manifest) {
+    std::ofstream dbFile(path, std::ios::trunc);
+    if (!dbFile) {
+        throw DatabaseException("Failed to open database file for writing: " + path);
+    }
+    
+    dbFile << MANIFEST_MAGIC << "\n";
+    dbFile << manifest.lsn << " " << manifest.generation << "\n";
+    dbFile << manifest.tableFiles.size() << "\n";
+    for (const auto& [tableName, files] : manifest.tableFiles) {
+        dbFile << tableName << "\t" << files.lsn << "\t" << files.rowCount << "\t" << files.baseFile;
+        for (const auto& deltaFile : files.deltaFiles) {
+            dbFile << "\t" << deltaFile;
+        }
+        dbFile << "\n";
+    }
+    dbFile << manifest.views.size() << "\n";
+    for (const auto& [viewName, viewDef] : manifest.views) {
+        dbFile << viewName << "," << viewDef << "\n";
+    }
+    
+    dbFile.close();
+    if (!dbFile) {
+        throw DatabaseException("Failed to write database file: " + path);
+    }
+}
+// Backups
+// -------
+BackupSnapshot::~BackupSnapshot() {
+    for (const auto& file : files) {
+        ::close(file.fd);
+    }
+}
+std::unique_ptr<BackupSnapshot> Storage::captureBackup(const std::string& dbName, const std::string& logPath,
+                                                       uint64_t logBytes) {
+    auto snapshot = std::make_unique<BackupSnapshot>();
+    readManifest(dbName, snapshot->manifest);
+    std::filesystem::path directory = databaseDirectory(dbName);
+    
+    auto addFile = [&](const std::string& filePath, const std::string& name, bool wholeFile, uint64_t bytes) {
+        int fd = ::open(filePath.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            throw DatabaseException("Failed to open file for reading: " + filePath);
+        }
+        snapshot->files.push_back(BackupSnapshot::File{name, fd, bytes});
+        if (wholeFile) {
+            struct stat info;
+            if (::fstat(fd, &info) != 0) {
+                throw DatabaseException("Failed to stat " + filePath);
+            }
+            snapshot->files.back().bytes = static_cast<uint64_t>(info.st_size);
+        }
+    };
+    for (const auto& entry : snapshot->manifest.tableFiles) {
+        addFile((directory / entry.second.baseFile).string(), entry.second.baseFile, true, 0);
+        for (const auto& deltaFile : entry.second.deltaFiles) {
+            addFile((directory / deltaFile).string(), deltaFile, true, 0);
+        }
+    }
+    addFile(logPath, std::filesystem::path(logPath).filename().string(), false, logBytes);
+    return snapshot;
+}
+uint64_t Storage::writeBackup(const BackupSnapshot& snapshot, const std::string& dbName,
+                              const std::string& directory) {
+    try {
+        std::filesystem::path target(directory);
+        std::filesystem::create_directories(target);
+        std::string manifestPath = (target / (databaseBaseName(dbName) + ".db")).string();
+        if (std::filesystem::exists(manifestPath)) {
+            throw DatabaseException("Backup directory already holds database " + databaseBaseName(dbName));
+        }
+        
+        // Checkpoint files are immutable, so copying them needs no lock
+        uint64_t copiedBytes = 0;
+        std::vector<char> buffer(AsyncFileWriter::CHUNK_BYTES);
+        for (const auto& file : snapshot.files) {
+            std::string copyPath = (target / file.name).string();
+            AsyncFileWriter copy(copyPath, ioQueueDepth);
+            uint64_t offset = 0;
+            while (offset < file.bytes) {
+                size_t want = static_cast<size_t>(std::min<uint64_t>(buffer.size(), file.bytes - offset));
+                ssize_t got = ::pread(file.fd, buffer.data(), want, static_cast<off_t>(offset));
+                if (got < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (got <= 0) {
+                    throw DatabaseException("Failed to read " + file.name);
+                }
+                copy.write(buffer.data(), static_cast<size_t>(got));
+                offset += static_cast<uint64_t>(got);
+            }
+            copy.close();
+            syncPath(copyPath);
+            copiedBytes += file.bytes;
+        }
+        
+        // The manifest makes the copy openable, so it comes last
+        std::string tempPath = manifestPath + ".tmp";
+        writeManifest(tempPath, snapshot.manifest);
+        syncPath(tempPath);
+        if (std::rename(tempPath.c_str(), manifestPath.c_str()) != 0) {
+            throw DatabaseException("Failed to replace " + manifestPath);
+        }
+        syncPath(target.string());
+        return copiedBytes;
+    } catch (const std::exception& e) {
+        throw DatabaseException("Error writing backup: " + std::string(e.what()));
+    }
+}
+// Deletes table files of earlier generations, leftovers of checkpoints that
+// crashed before their manifest was published and spills of a crashed process
+void Storage::removeObsoleteFiles(const std::string& dbName, const CheckpointManifest& manifest) {
+    std::string prefix = databaseBaseName(dbName) + ".";
+    std::set<std::string> live;
+    for (const auto& entry : manifest.tableFiles) {
+        live.insert(entry.second.baseFile);
+        live.insert(entry.second.deltaFiles.begin(), entry.second.deltaFiles.end());
+    }
+    
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(databaseDirectory(dbName), error)) {
+        // Checkpoint files are named <db>.<table>.<generation>.tbl; spilled
+        // partitions (<db>.<table>.<partition>.<n>.cold) outlive no process
+        std::string fileName = entry.path().filename().string();
+        if (fileName.size() <= prefix.size() + 5 ||
+            fileName.compare(0, prefix.size(), prefix) != 0) {
+            continue;
+        }
+        if (fileName.compare(fileName.size() - 5, 5, ".cold") == 0) {
+            std::filesystem::remove(entry.path(), error);
+            continue;
+        }
+        if (fileName.compare(fileName.size() - 4, 4, ".tbl") != 0) {
+            continue;
+        }
+        std::string stem = fileName.substr(0, fileName.size() - 4);
+        std::string generation = stem.substr(stem.rfind('.') + 1);
+        bool numbered = !generation.empty() &&
+                        std::all_of(generation.begin(), generation.end(), ::isdigit);
+        if (numbered && live.find(fileName) == live.end()) {
+            std::filesystem::remove(entry.path(), error);
+        }
+    }
+}
@@ -2,14 +2,116 @@
 #define STORAGE_H
 
 #include "Table.h"
+#include "ThreadPool.h"
+#include "BufferPool.h"
 #include <string>
 #include <map>
+#include <set>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <cstdint>
+
+// Files holding one table in a checkpoint: a full base file plus delta files
+// with the rows appended since, oldest first
+struct CheckpointTable {
+    std::string baseFile;
+    std::vector<std::string> deltaFiles;
+    uint64_t rowCount = UNKNOWN_ROW_COUNT;   // rows across all the files
+    uint64_t lsn = 0;   // last log record reflected in the files
+    
+    static const uint64_t UNKNOWN_ROW_COUNT = UINT64_MAX;
+};
+
+// Contents of a checkpoint manifest (<db>.db)
+struct CheckpointManifest {
+    uint64_t lsn = 0;          // last log record reflected in the table list and views
+    uint64_t generation = 0;   // bumped by every checkpoint, part of the file names
+    std::map<std::string, CheckpointTable> tableFiles;  // keyed by table name
+    std::map<std::string, std::string> views;
+};
+
+// A checkpoint between taking its copy of the tables and writing it. Copies
+// share the row chunks of the tables they come from.
+struct PendingCheckpoint {
+    struct TableCopy {
+        std::string name;   // as the manifest lists it
+        uint64_t version = 0;   // of the table the copy was taken from
+        uint64_t rewriteVersion = 0;
+        uint64_t lsn = 0;   // last log record the table's files reflect
+        std::unique_ptr<Table> rows;   // null when the table's files are kept
+    };
+    std::string dbName;
+    uint64_t lsn = 0;
+    std::map<std::string, TableCopy> tables;   // keyed by table key
+    std::map<std::string, std::string> views;
+};
+
+// Files making up a point-in-time copy of a database: the last checkpoint
+// and the log up to the backup position. They are held open, so a checkpoint
+// that deletes or replaces them meanwhile does not affect the copy.
+struct BackupSnapshot {
+    struct File {
+        std::string name;   // file name inside the database directory
+        int fd = -1;
+        uint64_t bytes = 0;   // length to copy
+    };
+    CheckpointManifest manifest;
+    std::vector<File> files;
+    
+    BackupSnapshot() = default;
+    ~BackupSnapshot();
+    BackupSnapshot(const BackupSnapshot&) = delete;
+    BackupSnapshot& operator=(const BackupSnapshot&) = delete;
+};
 
 class Storage {
 public:
-    // Table persistence
+    Storage();
+    
+    // Binary table files at least this large are scanned in place rather than
+    // decoded into memory (0 disables this)
+    static const uint64_t DEFAULT_MAPPING_THRESHOLD = 64 * 1024 * 1024;
+    void setMappingThreshold(uint64_t bytes) { mappingThreshold = bytes; }
+    uint64_t getMappingThreshold() const { return mappingThreshold; }
+    // Memory budget for the pages of tables scanned in place. 0 switches new
+    // segments to plain memory mapping with no budget of our own.
+    void setBufferPoolSize(size_t bytes);
+    size_t getBufferPoolSize() const;
+    BufferPool::Stats getBufferPoolStats() const { return bufferPool->getStats(); }
+    // Lazy loading: opening a checkpoint reads only table schemas, and each
+    // table's rows are loaded on first access
+    void setLazyLoading(bool enabled) { lazyLoading = enabled; }
+    bool isLazyLoading() const { return lazyLoading; }
+    // Threads used to load tables, and the page ranges of one large table,
+    // in parallel (0 uses every hardware thread, 1 loads serially)
+    void setLoadThreads(size_t threads);
+    size_t getLoadThreads() const;
+    // Loaded rows skip per-row validation; this controls the single hashing
+    // pass that re-checks NOT NULL, PRIMARY KEY and UNIQUE afterwards
+    void setVerifyOnLoad(bool enabled) { verifyOnLoad = enabled; }
+    bool isVerifyingOnLoad() const { return verifyOnLoad; }
+    // Columnar pages with per-column encodings (dictionary, run-length,
+    // frame-of-reference); off writes the row page format
+    void setCompression(bool enabled) { compression = enabled; }
+    bool isCompressing() const { return compression; }
+    // Reads and writes kept in flight by the io_uring paths: checkpoint
+    // writes, streamed table loads and buffer pool read-ahead (0 uses
+    // blocking I/O)
+    static const unsigned DEFAULT_IO_QUEUE_DEPTH = 32;
+    void setIoQueueDepth(unsigned depth);
+    unsigned getIoQueueDepth() const { return ioQueueDepth; }
+    
+    // Table persistence. saveTableToPath writes the rows from firstRow on and
+    // returns how many it wrote.
     void saveTableToFile(const Table& table, const std::string& tableName);
     Table* loadTableFromFile(const std::string& tableName);
+    uint64_t saveTableToPath(const Table& table, const std::string& filePath, uint64_t firstRow = 0);
+    Table* loadTableFromPath(const std::string& filePath, const std::string& tableName, bool verifyRows = true);
+    // Writes the table's rows to a file that is read in place and removed
+    // once the returned segment is gone; cold partitions live there
+    std::shared_ptr<const TableSegment> spillTable(const Table& table, const std::string& filePath);
     
     // Database persistence
     void saveDatabase(const std::string& dbName, 
@@ -18,6 +120,76 @@ public:
     void loadDatabase(const std::string& dbName, 
                      std::map<std::string, Table*>& tables,
                      std::map<std::string, std::string>& views);
+    
+    // Checkpoints: changed tables are written to a fresh generation of files
+    // and the manifest is swapped in atomically, so a crash leaves either the
+    // old or the new checkpoint intact. Tables untouched since the previous
+    // checkpoint keep their files; tables that only had rows appended get a
+    // delta file with just those rows.
+    // prepareCheckpoint runs with the database locked and copies the changed
+    // tables; saveCheckpoint encodes and writes the copies without the lock,
+    // so statements keep running meanwhile. Checkpoints must not overlap.
+    // Given onlyTables, the other tables keep their files even if changed, and
+    // the log position of those files.
+    PendingCheckpoint prepareCheckpoint(const std::string& dbName,
+                                        const std::map<std::string, Table*>& tables,
+                                        const std::map<std::string, std::string>& views,
+                                        uint64_t lsn,
+                                        const std::set<std::string>* onlyTables = nullptr);
+    void saveCheckpoint(const PendingCheckpoint& checkpoint);
+    // Returns the LSN every table of the checkpoint is current to, where log
+    // replay starts (0 when there is no checkpoint yet)
+    uint64_t loadCheckpoint(const std::string& dbName,
+                            std::map<std::string, Table*>& tables,
+                            std::map<std::string, std::string>& views);
+    // Log records of a table up to this LSN are in its checkpoint files. For
+    // tables the checkpoint does not list, it is where the table list was
+    // written.
+    uint64_t getCheckpointedLsn(const std::string& tableKey) const;
+    bool readManifest(const std::string& dbName, CheckpointManifest& manifest);
+    
+    // Online backup. captureBackup opens the current checkpoint and the first
+    // logBytes of the log; it must not overlap a checkpoint. writeBackup then
+    // copies them into directory, manifest last, while the database keeps
+    // running, and returns the bytes copied.
+    std::unique_ptr<BackupSnapshot> captureBackup(const std::string& dbName, const std::string& logPath,
+                                                  uint64_t logBytes);
+    uint64_t writeBackup(const BackupSnapshot& snapshot, const std::string& dbName,
+                         const std::string& directory);
+
+private:
+    uint64_t mappingThreshold = DEFAULT_MAPPING_THRESHOLD;
+    std::shared_ptr<BufferPool> bufferPool = std::make_shared<BufferPool>();
+    std::atomic<bool> bufferPoolEnabled{true};
+    bool lazyLoading = true;
+    size_t loadThreads = 0;
+    std::atomic<bool> verifyOnLoad{true};
+    std::atomic<bool> compression{true};
+    std::atomic<unsigned> ioQueueDepth{DEFAULT_IO_QUEUE_DEPTH};
+    std::shared_ptr<ThreadPool> pool;   // created on first parallel load
+    mutable std::mutex poolMutex;
+    
+    // Runs body(0) .. body(count - 1) on the load pool
+    void runParallel(size_t count, const std::function<void(size_t)>& body);
+    void loadPagesInParallel(const std::string& filePath, Table* table, uint64_t rowCount, bool verify);
+    // What the last checkpoint wrote or loaded for each table, keyed by table
+    // key, with the table versions it corresponds to
+    struct PersistedTable {
+        CheckpointTable files;
+        uint64_t version = 0;
+        uint64_t rewriteVersion = 0;
+    };
+    std::map<std::string, PersistedTable> persisted;
+    uint64_t persistedLsn = 0;   // of the table list
+    
+    Table* loadCheckpointTable(const std::string& directory, const std::string& tableName,
+                               const CheckpointTable& files, bool verifyRows);
+    Table* openTableLazily(const std::string& directory, const std::string& tableName,
+                           const CheckpointTable& files);
+    Table* mapTableFromPath(const std::string& filePath, const std::string& tableName);
+    Table* loadLegacyTableFile(const std::string& filePath, const std::string& tableName, bool verify);
+    void writeManifest(const std::string& path, const CheckpointManifest& manifest);
+    void removeObsoleteFiles(const std::string& dbName, const CheckpointManifest& manifest);
 };
 
 #endif // STORAGE_H
\ No newline at end of file
@@ -1,4 +1,8 @@
 #include "Table.h"
+#include "TableSegment.h"
+#include "ColumnStore.h"
+#include "RowArena.h"
+#include "TypedValue.h"
 #include "Utils.h"
 #include "ConditionParser.h"
 #include "Aggregation.h"
@@ -8,21 +12,39 @@
 #include <unordered_map>
 #include <stdexcept>
 #include <regex>
+#include <queue>
+#include <chrono>
+#include <ctime>
 #include "Database.h"
 #include "ForeignKeyValidator.h" 
 extern Database* _g_db;
 // Table Class Implementation
 // -------------------------
+// Source of table versions; see getVersion()
+static std::atomic<uint64_t> versionClock{0};
+// Sort keys compare as numbers when both read as numbers; dates and times
+// compare as text, so their leading year or hour is not taken for the value
+static bool compareAsNumbers(const std::string& a, const std::string& b, double& aVal, double& bVal) {
+    return !TypedValues::isTemporal(a) && !TypedValues::isTemporal(b) &&
+           ZoneMaps::parseNumber(a, aVal) && ZoneMaps::parseNumber(b, bVal);
+}
+// Clock of partition accesses for the IDLE cold policy
+static int64_t steadySeconds() {
+    return std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
 Table::Table(const std::string& name) : 
     tableName(name), 
     nextRowId(1) 
     {
-        
+        noteRewrite();
         
     }
+Table::~Table() = default;
 // Set Operations
 // --------------
 std::vector<std::vector<std::string>> Table::setUnion(const std::vector<std::vector<std::string>>& otherResult) {
+    materializeSegment();
     std::shared_lock<std::shared_mutex> lock(mutex);
     
     std::vector<std::vector<std::string>> result = rows;
@@ -36,6 +58,7 @@ std::vector<std::vector<std::string>> Table::setUnion(const std::vector<std::vec
     return result;
 }
 std::vector<std::vector<std::string>> Table::setIntersect(const std::vector<std::vector<std::string>>& otherResult) {
+    materializeSegment();
     std::shared_lock<std::shared_mutex> lock(mutex);
     
     std::vector<std::vector<std::string>> result;
@@ -49,6 +72,7 @@ std::vector<std::vector<std::string>> Table::setIntersect(const std::vector<std:
     return result;
 }
 std::vector<std::vector<std::string>> Table::setExcept(const std::vector<std::vector<std::string>>& otherResult) {
+    materializeSegment();
     std::shared_lock<std::shared_mutex> lock(mutex);
     
     std::vector<std::vector<std::string>> result;
@@ -78,6 +102,11 @@ std::string Table::applyAggregateFunction(const std::string& function, const std
     if (values.empty()) {
         return "NULL";
     }
+    // Only COUNT has a value for a group of NULLs
+    if (function != "COUNT" &&
+        std::all_of(values.begin(), values.end(), [](const std::string& value) { return value.empty(); })) {
+        return "NULL";
+    }
     
     if (function == "AVG") {
         return std::to_string(Aggregation::computeMean(values));
@@ -129,7 +158,9 @@ void Table::unlock() {
 // Utility Functions
 // -----------------
 void Table::sortRows(const std::string& columnName, bool ascending) {
+    materializeSegment();
     std::unique_lock<std::shared_mutex> lock(mutex);
+    noteRewrite();
     
     auto it = std::find(columns.begin(), columns.end(), columnName);
     if (it == columns.end()) {
@@ -137,20 +168,30 @@ void Table::sortRows(const std::string& columnName, bool ascending) {
     }
     
     int idx = std::distance(columns.begin(), it);
+    rowIds.clear();
     std::sort(rows.begin(), rows.end(), 
         [idx, ascending](const auto& a, const auto& b) {
-            try {
-                double aVal = std::stod(a[idx]);
-                double bVal = std::stod(b[idx]);
+            double aVal, bVal;
+            if (compareAsNumbers(a[idx], b[idx], aVal, bVal)) {
                 return ascending ? (aVal < bVal) : (aVal > bVal);
-            } catch (...) {
-                return ascending ? (a[idx] < b[idx]) : (a[idx] > b[idx]);
             }
+            return ascending ? (a[idx] < b[idx]) : (a[idx] > b[idx]);
         });
+    packRows();
 }
 int Table::getRowCount() const {
+    ensureRowsLoaded();
     std::shared_lock<std::shared_mutex> lock(mutex);
-    return rows.size();
+    size_t count = (rowArena ? rowArena->getRowCount() : 0) + rows.size() +
+                   (columnStore ? columnStore->getRowCount() : 0);
+    forEachSegment([&](const TableSegment& mappedSegment) {
+        count += mappedSegment.getRowCount();
+    });
+    for (const auto& child : partitionTables) {
+        count += (child->rowArena ? child->rowArena->getRowCount() : 0) +
+                 (child->segment ? child->segment->getRowCount() : 0);
+    }
+    return count;
 }
 bool Table::hasColumn(const std::string& columnName) const {
     
@@ -169,6 +210,8 @@ std::vector<std::vector<std::string>> Table::innerJoin(
     const std::string& condition,
     const std::vector<std::string>& selectColumns
 ) {
+    materializeSegment();
+    rightTable.materializeSegment();
     std::shared_lock<std::shared_mutex> lockLeft(mutex);
     std::shared_lock<std::shared_mutex> lockRight(rightTable.mutex);
     
@@ -255,6 +298,8 @@ std::vector<std::vector<std::string>> Table::leftOuterJoin(
     const std::string& condition,
     const std::vector<std::string>& selectColumns
 ) {
+    materializeSegment();
+    rightTable.materializeSegment();
     std::shared_lock<std::shared_mutex> lockLeft(mutex);
     std::shared_lock<std::shared_mutex> lockRight(rightTable.mutex);
     
@@ -398,6 +443,8 @@ std::vector<std::vector<std::string>> Table::naturalJoin(
     Table& rightTable,
     const std::vector<std::string>& selectColumns
 ) {
+    materializeSegment();
+    rightTable.materializeSegment();
     std::shared_lock<std::shared_mutex> lockLeft(mutex);
     std::shared_lock<std::shared_mutex> lockRight(rightTable.mutex);
     
@@ -571,6 +618,8 @@ std::vector<std::vector<std::string>> Table::fullOuterJoin(
     const std::string& condition,
     const std::vector<std::string>& selectColumns
 ) {
+    materializeSegment();
+    rightTable.materializeSegment();
     std::shared_lock<std::shared_mutex> lockLeft(mutex);
     std::shared_lock<std::shared_mutex> lockRight(rightTable.mutex);
     
@@ -660,16 +709,87 @@ std::vector<std::vector<std::string>> Table::fullOuterJoin(
 // Data Manipulation
 // -----------------
 void Table::deleteRows(const std::string& condition) {
+    materializeSegmentOnly();
     std::unique_lock<std::shared_mutex> lock(mutex);
+    uint64_t previousRewrite = rewriteVersion;
+    noteRewrite();
     
     if (condition.empty()) {
         rows.clear();
+        rowIds.clear();
+        rowArena.reset();
+        clusteredSlots = 0;
+        columnStore.reset();
+        resetPartitions();
+        packed = false;
+        packRows();
         return;
     }
     
     ConditionParser cp(condition);
     auto expr = cp.parse();
+    packRows();
+    
+    if (isPartitioned() && rows.empty()) {
+        for (size_t p = 0; p < partitionTables.size(); ++p) {
+            if (partitionCanMatch(p, *expr) && coldPartitionMatches(p, *expr)) {
+                warmPartition(p);
+                partitionTables[p]->deleteRows(condition);
+            }
+        }
+        return;
+    }
+    
+    if (rowArena && rows.empty()) {
+        // Tombstones: no row moves, so row IDs and the zone map stay valid
+        // and blocks the zone map rules out are never read
+        size_t slotCount = rowArena->getSlotCount();
+        bool zoned = slotCount > ZoneMaps::ROWS_PER_ZONE;
+        if (zoned) {
+            refreshRowZones();
+        }
+        std::vector<std::string_view> row;
+        for (size_t first = 0; first < slotCount; first += ZoneMaps::ROWS_PER_ZONE) {
+            if (zoned && !expr->canMatchBlock(rowZones[first / ZoneMaps::ROWS_PER_ZONE], columns)) {
+                continue;
+            }
+            size_t end = std::min(first + ZoneMaps::ROWS_PER_ZONE, slotCount);
+            for (size_t slot = first; slot < end; ++slot) {
+                if (!rowArena->isLive(slot)) {
+                    continue;
+                }
+                rowArena->readRow(slot, row);
+                if (expr->evaluate(row, columns)) {
+                    rowArena->erase(slot);
+                }
+            }
+        }
+        if (rowArena->getRowCount() == 0) {
+            rowArena->clear();
+            clusteredSlots = 0;
+        }
+        std::lock_guard<std::mutex> zoneLock(zoneMutex);
+        if (zonedRewriteVersion == previousRewrite) {
+            zonedRewriteVersion = rewriteVersion;
+        }
+        if (rowArena->getSlotCount() == 0) {
+            rowZones.clear();
+            zonedRows = 0;
+        }
+        return;
+    }
     
+    if (packed && rows.empty()) {
+        std::vector<uint8_t> keep;
+        selectPackedRows(*expr, keep);
+        for (auto& flag : keep) {
+            flag = !flag;
+        }
+        columnStore->retain(keep);
+        return;
+    }
+    
+    rowIds.clear();
     rows.erase(
         std::remove_if(rows.begin(), rows.end(), 
             [&](const std::vector<std::string>& row) {
@@ -677,127 +797,293 @@ void Table::deleteRows(const std::string& condition) {
             }), 
         rows.end()
     );
+    packRows();
 }
 void Table::updateRows(const std::vector<std::pair<std::string, std::string>>& updates, const std::string& condition) {
-    std::unique_lock<std::shared_mutex> lock(mutex);
-    
     ConditionExprPtr expr = nullptr;
     if (!condition.empty()) {
         ConditionParser cp(condition);
         expr = cp.parse();
     }
     
-    for (auto& row : rows) {
-        if (!expr || expr->evaluate(row, columns)) {
-            bool rowChanged = false;
-            std::vector<std::string> newRow = row;
+    std::vector<std::string> row;
+    RowRewrite rewrite = [&](const RowView& cells, std::vector<std::string>& newRow) {
+        if (expr && !expr->evaluate(cells, columns)) {
+            return false;
+        }
+        row.clear();
+        for (size_t i = 0; i < cells.size(); ++i) {
+            row.emplace_back(cells[i]);
+        }
+        return updatedRow(row, updates, newRow);
+    };
+    
+    materializeSegmentOnly();
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    noteRewrite();
+    packRows();
+    if (isPartitioned() && updateKeepsPartitions(updates)) {
+        // Only the partitions the condition can match are read
+        for (size_t p = 0; p < partitionTables.size(); ++p) {
+            if (expr && (!partitionCanMatch(p, *expr) || !coldPartitionMatches(p, *expr))) {
+                continue;
+            }
+            warmPartition(p);
+            Table& child = *partitionTables[p];
+            child.noteRewrite();
+            child.packRows();
+            if (child.rowArena) {
+                rewriteArenaRows(child, rewrite, p, nullptr);
+            }
+        }
+        return;
+    }
+    if (rowArena && rows.empty()) {
+        rewriteArenaRows(*this, rewrite, SIZE_MAX, nullptr);
+        return;
+    }
+    
+    // A column store, or a partitioned table whose rows may change
+    // partition, is updated as row vectors and packed again
+    unpackRows();
+    updateMatchingRows(rows, updates, expr.get());
+    packRows();
+}
+void Table::updateMatchingRows(std::vector<std::vector<std::string>>& target,
+                               const std::vector<std::pair<std::string, std::string>>& updates,
+                               const ConditionExpression* expr) {
+    std::vector<std::string> newRow;
+    for (auto& row : target) {
+        if ((!expr || expr->evaluate(row, columns)) && updatedRow(row, updates, newRow)) {
+            row = newRow;
+        }
+    }
+}
+void Table::rewriteRows(const RowRewrite& rewrite) {
+    materializeSegmentOnly();
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    packRows();
+    size_t changed = 0;
+    if (isPartitioned()) {
+        // Rows that leave their partition go to their new one under fresh
+        // IDs, after every partition was read
+        std::vector<std::vector<std::string>> leaving;
+        for (size_t p = 0; p < partitionTables.size(); ++p) {
+            Table& child = *partitionTables[p];
+            warmPartition(p);
+            child.packRows();
+            if (child.rowArena) {
+                size_t childChanged = rewriteArenaRows(child, rewrite, p, &leaving);
+                if (childChanged > 0) {
+                    child.noteRewrite();
+                }
+                changed += childChanged;
+            }
+        }
+        for (const auto& row : leaving) {
+            appendToPartition(row, nextRowId++);
+        }
+    } else if (rowArena && rows.empty()) {
+        changed = rewriteArenaRows(*this, rewrite, SIZE_MAX, nullptr);
+    } else {
+        unpackRows();
+        std::vector<std::string> newRow;
+        for (auto& row : rows) {
+            if (rewrite(row, newRow)) {
+                row = newRow;
+                changed++;
+            }
+        }
+        packRows();
+    }
+    if (changed > 0) {
+        noteRewrite();
+    }
+}
+size_t Table::rewriteArenaRows(Table& owner, const RowRewrite& rewrite, size_t partition,
+                               std::vector<std::vector<std::string>>* leaving) {
+    RowArena& arena = *owner.rowArena;
+    size_t slotCount = arena.getSlotCount();
+    std::vector<size_t> clusterKey;
+    for (const auto& column : owner.clusterColumns) {
+        clusterKey.push_back(std::distance(columns.begin(), std::find(columns.begin(), columns.end(), column)));
+    }
+    size_t changed = 0;
+    bool movedRows = false;
+    std::vector<std::string_view> cells;
+    std::vector<std::string> newRow;
+    for (size_t slot = 0; slot < slotCount; ++slot) {
+        if (!arena.isLive(slot)) {
+            continue;
+        }
+        arena.readRow(slot, cells);
+        if (!rewrite(cells, newRow)) {
+            continue;
+        }
+        changed++;
+        if (partition != SIZE_MAX) {
+            if (leaving && partitionOf(newRow) != partition) {
+                arena.erase(slot);
+                leaving->push_back(std::move(newRow));
+                continue;
+            }
+            partitionZones[partition].columns[0].add(newRow[partitionKeyIndex()]);
+        }
+        // A row whose cluster key changes leaves the ordered run: it is
+        // erased and appended again under its ID, and sorted in like an
+        // inserted row
+        bool keyChanged = false;
+        for (size_t column : clusterKey) {
+            keyChanged = keyChanged || column >= cells.size() || column >= newRow.size() ||
+                         cells[column] != newRow[column];
+        }
+        if (keyChanged) {
+            uint64_t id = arena.rowId(slot);
+            arena.erase(slot);
+            arena.append(newRow, id);
+            movedRows = true;
+        } else {
+            arena.replace(slot, newRow);
+        }
+    }
+    if (movedRows) {
+        owner.clusterRows(false);
+        if (owner.clusterTailFull()) {
+            owner.clusterRows(true);
+        }
+    }
+    return changed;
+}
+bool Table::updatedRow(const std::vector<std::string>& row,
+                       const std::vector<std::pair<std::string, std::string>>& updates,
+                       std::vector<std::string>& newRow) {
+    bool rowChanged = false;
+    newRow = row;
+    
+    for (const auto& update : updates) {
+        auto it = std::find(columns.begin(), columns.end(), update.first);
+        if (it != columns.end()) {
+            int idx = std::distance(columns.begin(), it);
+            std::string newValue = update.second;
+            bool quoted = newValue.size() >= 2 && newValue.front() == '\'' && newValue.back() == '\'';
             
-            for (const auto& update : updates) {
-                auto it = std::find(columns.begin(), columns.end(), update.first);
-                if (it != columns.end()) {
-                    int idx = std::distance(columns.begin(), it);
-                    std::string newValue = update.second;
-                    
-                    // Check if this is an expression that needs evaluation
-                    if (newValue.find(update.first) != std::string::npos) {
-                        // This is an expression involving the column itself
-                        // Simple parser for basic arithmetic operations
-                        try {
-                            if (newValue.find('*') != std::string::npos) {
-                                // Handle multiplication: column * factor
-                                size_t opPos = newValue.find('*');
-                                std::string leftPart = trim(newValue.substr(0, opPos));
-                                std::string rightPart = trim(newValue.substr(opPos + 1));
-                                
-                                if (toLowerCase(leftPart) == toLowerCase(update.first)) {
-                                    // Format: column * factor
-                                    double currentVal = std::stod(row[idx]);
-                                    double factor = std::stod(rightPart);
-                                    newValue = std::to_string(currentVal * factor);
-                                } else if (toLowerCase(rightPart) == toLowerCase(update.first)) {
-                                    // Format: factor * column
-                                    double currentVal = std::stod(row[idx]);
-                                    double factor = std::stod(leftPart);
-                                    newValue = std::to_string(currentVal * factor);
-                                }
-                            } else if (newValue.find('+') != std::string::npos) {
-                                // Handle addition: column + amount
-                                size_t opPos = newValue.find('+');
-                                std::string leftPart = trim(newValue.substr(0, opPos));
-                                std::string rightPart = trim(newValue.substr(opPos + 1));
-                                
-                                if (toLowerCase(leftPart) == toLowerCase(update.first)) {
-                                    // Format: column + amount
-                                    double currentVal = std::stod(row[idx]);
-                                    double amount = std::stod(rightPart);
-                                    newValue = std::to_string(currentVal + amount);
-                                } else if (toLowerCase(rightPart) == toLowerCase(update.first)) {
-                                    // Format: amount + column
-                                    double currentVal = std::stod(row[idx]);
-                                    double amount = std::stod(leftPart);
-                                    newValue = std::to_string(currentVal + amount);
-                                }
-                            } else if (newValue.find('-') != std::string::npos) {
-                                // Handle subtraction: column - amount
-                                size_t opPos = newValue.find('-');
-                                std::string leftPart = trim(newValue.substr(0, opPos));
-                                std::string rightPart = trim(newValue.substr(opPos + 1));
-                                
-                                if (toLowerCase(leftPart) == toLowerCase(update.first)) {
-                                    // Format: column - amount
-                                    double currentVal = std::stod(row[idx]);
-                                    double amount = std::stod(rightPart);
-                                    newValue = std::to_string(currentVal - amount);
-                                }
-                            } else if (newValue.find('/') != std::string::npos) {
-                                // Handle division: column / divisor
-                                size_t opPos = newValue.find('/');
-                                std::string leftPart = trim(newValue.substr(0, opPos));
-                                std::string rightPart = trim(newValue.substr(opPos + 1));
-                                
-                                if (toLowerCase(leftPart) == toLowerCase(update.first)) {
-                                    // Format: column / divisor
-                                    double currentVal = std::stod(row[idx]);
-                                    double divisor = std::stod(rightPart);
-                                    if (std::abs(divisor) < 1e-10) {
-                                        throw DatabaseException("Division by zero");
-                                    }
-                                    newValue = std::to_string(currentVal / divisor);
-                                }
+            // Check if this is an expression that needs evaluation
+            if (quoted || toUpperCase(newValue) == "NULL") {
+                newValue = literalCell(newValue);
+            } else if (newValue.find(update.first) != std::string::npos && row[idx].empty()) {
+                // Arithmetic on NULL gives NULL
+                newValue.clear();
+            } else if (newValue.find(update.first) != std::string::npos) {
+                // This is an expression involving the column itself
+                // Simple parser for basic arithmetic operations
+                try {
+                    if (newValue.find('*') != std::string::npos) {
+                        // Handle multiplication: column * factor
+                        size_t opPos = newValue.find('*');
+                        std::string leftPart = trim(newValue.substr(0, opPos));
+                        std::string rightPart = trim(newValue.substr(opPos + 1));
+                        
+                        if (toLowerCase(leftPart) == toLowerCase(update.first)) {
+                            // Format: column * factor
+                            double currentVal = std::stod(row[idx]);
+                            double factor = std::stod(rightPart);
+                            newValue = std::to_string(currentVal * factor);
+                        } else if (toLowerCase(rightPart) == toLowerCase(update.first)) {
+                            // Format: factor * column
+                            double currentVal = std::stod(row[idx]);
+                            double factor = std::stod(leftPart);
+                            newValue = std::to_string(currentVal * factor);
+                        }
+                    } else if (newValue.find('+') != std::string::npos) {
+                        // Handle addition: column + amount
+                        size_t opPos = newValue.find('+');
+                        std::string leftPart = trim(newValue.substr(0, opPos));
+                        std::string rightPart = trim(newValue.substr(opPos + 1));
+                        
+                        if (toLowerCase(leftPart) == toLowerCase(update.first)) {
+                            // Format: column + amount
+                            double currentVal = std::stod(row[idx]);
+                            double amount = std::stod(rightPart);
+                            newValue = std::to_string(currentVal + amount);
+                        } else if (toLowerCase(rightPart) == toLowerCase(update.first)) {
+                            // Format: amount + column
+                            double currentVal = std::stod(row[idx]);
+                            double amount = std::stod(leftPart);
+                            newValue = std::to_string(currentVal + amount);
+                        }
+                    } else if (newValue.find('-') != std::string::npos) {
+                        // Handle subtraction: column - amount
+                        size_t opPos = newValue.find('-');
+                        std::string leftPart = trim(newValue.substr(0, opPos));
+                        std::string rightPart = trim(newValue.substr(opPos + 1));
+                        
+                        if (toLowerCase(leftPart) == toLowerCase(update.first)) {
+                            // Format: column - amount
+                            double currentVal = std::stod(row[idx]);
+                            double amount = std::stod(rightPart);
+                            newValue = std::to_string(currentVal - amount);
+                        }
+                    } else if (newValue.find('/') != std::string::npos) {
+                        // Handle division: column / divisor
+                        size_t opPos = newValue.find('/');
+                        std::string leftPart = trim(newValue.substr(0, opPos));
+                        std::string rightPart = trim(newValue.substr(opPos + 1));
+                        
+                        if (toLowerCase(leftPart) == toLowerCase(update.first)) {
+                            // Format: column / divisor
+                            double currentVal = std::stod(row[idx]);
+                            double divisor = std::stod(rightPart);
+                            if (std::abs(divisor) < 1e-10) {
+                                throw DatabaseException("Division by zero");
                             }
-                        } catch (const std::exception& e) {
-                            throw DatabaseException("Error evaluating expression: " + newValue + " - " + e.what());
+                            newValue = std::to_string(currentVal / divisor);
                         }
                     }
-                    
-                    // Apply the data type enforcement
-                    enforceDataType(idx, newValue);
-                    
-                    if (newRow[idx] != newValue) {
-                        newRow[idx] = newValue;
-                        rowChanged = true;
-                    }
+                } catch (const std::exception& e) {
+                    throw DatabaseException("Error evaluating expression: " + newValue + " - " + e.what());
                 }
             }
             
-            if (rowChanged) {
-                validateConstraintsForUpdate(row, newRow);
-                row = newRow;
+            // Apply the data type enforcement
+            enforceDataType(idx, newValue);
+            
+            if (newRow[idx] != newValue) {
+                newRow[idx] = newValue;
+                rowChanged = true;
             }
         }
     }
+    
+    if (rowChanged) {
+        validateConstraintsForUpdate(row, newRow);
+    }
+    return rowChanged;
 }
 void Table::clearRows() {
     std::unique_lock<std::shared_mutex> lock(mutex);
+    noteRewrite();
     rows.clear();
+    rowIds.clear();
+    segment.reset();
+    segmentIds.clear();
+    deltaSegments.clear();
+    mapped = false;
+    rowArena.reset();
+    clusteredSlots = 0;
+    columnStore.reset();
+    resetPartitions();
+    packed = false;
+    packRows();
 }
 // Schema Modification
 // -------------------
 void Table::addColumn(const std::string& columnName, const std::string& type, bool isNotNull) {
+    materializeSegment();
     
     
     
     std::unique_lock<std::shared_mutex> lock(mutex);
+    noteRewrite();
     
     
     
@@ -813,30 +1099,43 @@ void Table::addColumn(const std::string& columnName, const std::string& type, bo
     for (auto& row : rows) {
         row.push_back("");
     }
+    packRows();
 }
 bool Table::dropColumn(const std::string& columnName) {
+    materializeSegment();
     std::unique_lock<std::shared_mutex> lock(mutex);
+    noteRewrite();
     
     auto it = std::find(columns.begin(), columns.end(), columnName);
     if (it == columns.end()) {
         return false;
     }
     
+    if (isPartitioned() && columnName == partitionColumn) {
+        throw DatabaseException("Cannot drop partition column '" + columnName + "'");
+    }
+    if (std::find(clusterColumns.begin(), clusterColumns.end(), columnName) != clusterColumns.end()) {
+        throw DatabaseException("Cannot drop cluster column '" + columnName + "'");
+    }
     int idx = std::distance(columns.begin(), it);
     columns.erase(it);
     columnTypes.erase(columnTypes.begin() + idx);
     notNullConstraints.erase(notNullConstraints.begin() + idx);
+    bloomColumns.erase(std::remove(bloomColumns.begin(), bloomColumns.end(), columnName), bloomColumns.end());
     
     for (auto& row : rows) {
         if (idx < row.size()) {
             row.erase(row.begin() + idx);
         }
     }
+    packRows();
     
     return true;
 }
 void Table::renameColumn(const std::string& oldName, const std::string& newName) {
+    ensureRowsLoaded();
     std::unique_lock<std::shared_mutex> lock(mutex);
+    noteRewrite();
     
     auto it = std::find(columns.begin(), columns.end(), oldName);
     if (it == columns.end()) {
@@ -848,11 +1147,21 @@ void Table::renameColumn(const std::string& oldName, const std::string& newName)
     }
     
     *it = newName;
+    std::replace(bloomColumns.begin(), bloomColumns.end(), oldName, newName);
+    if (partitionColumn == oldName) {
+        partitionColumn = newName;
+    }
+    std::replace(clusterColumns.begin(), clusterColumns.end(), oldName, newName);
+    for (const auto& child : partitionTables) {
+        child->columns = columns;
+    }
 }
 // Constraint Management
 // ---------------------
 void Table::addConstraint(const Constraint& constraint) {
+    ensureRowsLoaded();
     std::unique_lock<std::shared_mutex> lock(mutex);
+    noteRewrite();
     
     for (const auto& col : constraint.columns) {
         if (!hasColumn(col)) {
@@ -869,7 +1178,9 @@ void Table::addConstraint(const Constraint& constraint) {
     constraints.push_back(constraint);
 }
 bool Table::dropConstraint(const std::string& constraintName) {
+    ensureRowsLoaded();
     std::unique_lock<std::shared_mutex> lock(mutex);
+    noteRewrite();
     
     auto it = std::find_if(constraints.begin(), constraints.end(),
         [&](const Constraint& c) { return c.name == constraintName; });
@@ -881,6 +1192,50 @@ bool Table::dropConstraint(const std::string& constraintName) {
     constraints.erase(it);
     return true;
 }
+void Table::addBloomFilter(const std::string& columnName) {
+    ensureRowsLoaded();
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    if (!hasColumn(columnName)) {
+        throw DatabaseException("Column '" + columnName + "' does not exist");
+    }
+    if (std::find(bloomColumns.begin(), bloomColumns.end(), columnName) == bloomColumns.end()) {
+        noteRewrite();
+        bloomColumns.push_back(columnName);
+    }
+}
+bool Table::dropBloomFilter(const std::string& columnName) {
+    ensureRowsLoaded();
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    auto it = std::find(bloomColumns.begin(), bloomColumns.end(), columnName);
+    if (it == bloomColumns.end()) {
+        return false;
+    }
+    noteRewrite();
+    bloomColumns.erase(it);
+    return true;
+}
+std::vector<size_t> Table::getKeyColumnIndexes() const {
+    std::vector<size_t> keyColumns;
+    auto addColumn = [&](const std::string& columnName) {
+        auto it = std::find(columns.begin(), columns.end(), columnName);
+        size_t index = std::distance(columns.begin(), it);
+        if (it != columns.end() &&
+            std::find(keyColumns.begin(), keyColumns.end(), index) == keyColumns.end()) {
+            keyColumns.push_back(index);
+        }
+    };
+    for (const auto& constraint : constraints) {
+        if (constraint.type == Constraint::Type::PRIMARY_KEY) {
+            for (const auto& columnName : constraint.columns) {
+                addColumn(columnName);
+            }
+        }
+    }
+    for (const auto& columnName : bloomColumns) {
+        addColumn(columnName);
+    }
+    return keyColumns;
+}
 // Data Validation
 // ---------------
 bool Table::validateConstraints(const std::vector<std::string>& row) {
@@ -922,6 +1277,7 @@ bool Table::validateConstraints(const std::vector<std::string>& row) {
 // In Table.cpp, make sure addRow calls validateConstraints before adding the row:
 // Enhanced version with more debugging
 int Table::addRow(const std::vector<std::string>& values) {
+    materializeSegmentOnly();
     
     
     
@@ -997,10 +1353,13 @@ int Table::addRow(const std::vector<std::string>& values) {
     // All constraints passed, add the row
     
     
-    rows.push_back(rowValues);
-    return nextRowId++;
+    int rowId = static_cast<int>(nextRowId);
+    appendRow(rowValues);
+    noteAppend();
+    return rowId;
 }
 int Table::addRowWithId(int rowId, const std::vector<std::string>& values) {
+    materializeSegment();
     if (values.size() != columns.size()) {
         throw DatabaseException("Incorrect number of values for row");
     }
@@ -1013,11 +1372,217 @@ int Table::addRowWithId(int rowId, const std::vector<std::string>& values) {
     
     validateConstraints(rowValues);
     rows.push_back(rowValues);
+    noteAppend();
     
     return rowId;
 }
+void Table::bulkLoadRows(std::vector<std::vector<std::string>>&& newRows, bool verify) {
+    materializeSegment();
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    
+    // A partitioned table verifies and routes the load as a whole
+    if (isPartitioned()) {
+        unpackRows();
+    }
+    size_t firstNew = memoryRowCount();
+    if (rows.empty()) {
+        rows = std::move(newRows);
+    } else {
+        rows.reserve(rows.size() + newRows.size());
+        std::move(newRows.begin(), newRows.end(), std::back_inserter(rows));
+    }
+    newRows.clear();
+    finishBulkLoad(firstNew, verify);
+}
+void Table::bulkLoadRows(RowArena&& newRows, bool verify) {
+    materializeSegment();
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    
+    if (isPartitioned()) {
+        unpackRows();
+    }
+    size_t firstNew = memoryRowCount();
+    if (storageMode != StorageMode::COLUMN && rows.empty() && !isPartitioned()) {
+        newRows.numberRows(0, nextRowId);
+        nextRowId += newRows.getSlotCount();
+        if (!rowArena) {
+            rowArena = std::make_unique<RowArena>();
+        }
+        rowArena->appendArena(std::move(newRows));
+        packed = true;
+    } else {
+        newRows.appendRowsTo(rows);
+    }
+    newRows.clear();
+    finishBulkLoad(firstNew, verify);
+}
+void Table::finishBulkLoad(size_t firstNew, bool verify) {
+    // Loaded rows sort in among a clustered table's rows, moving them
+    if (storageMode == StorageMode::CLUSTERED && firstNew > 0) {
+        noteRewrite();
+    } else {
+        noteAppend();
+    }
+    // Loaded rows take the next IDs when the unpacked rows kept theirs
+    size_t oldRows = firstNew - std::min(firstNew, rowArena ? rowArena->getSlotCount() : 0);
+    if (!rowIds.empty() && rowIds.size() == oldRows) {
+        while (rowIds.size() < rows.size()) {
+            rowIds.push_back(nextRowId++);
+        }
+    }
+    
+    if (verify) {
+        try {
+            verifyLoadedRows(firstNew);
+        } catch (...) {
+            size_t arenaSlots = rowArena ? rowArena->getSlotCount() : 0;
+            if (firstNew < arenaSlots) {
+                rowArena->truncate(firstNew);
+                clusteredSlots = std::min(clusteredSlots, firstNew);
+                rows.clear();
+            } else {
+                rows.resize(firstNew - arenaSlots);
+            }
+            if (rowIds.size() > rows.size()) {
+                rowIds.resize(rows.size());
+            }
+            packRows();
+            throw;
+        }
+    }
+    packRows();
+    if (storageMode == StorageMode::CLUSTERED) {
+        clusterRows(true);
+    }
+}
+// Caller holds the table lock. The rows before firstNew were checked when
+// they arrived, so only the new ones are; for PRIMARY KEY and UNIQUE the keys
+// of the new rows are hashed and the earlier rows probed against them, which
+// keeps the check linear where addRow compares every new row against all
+// existing ones.
+void Table::verifyLoadedRows(size_t firstNew) const {
+    size_t rowCount = memoryRowCount();
+    size_t r = firstNew;
+    visitMemoryRows(firstNew, rowCount, [&](const RowView& row) {
+        r++;
+        if (row.size() != columns.size()) {
+            throw DatabaseException("Row " + std::to_string(r) + " of table '" + tableName +
+                                    "' has " + std::to_string(row.size()) + " values, expected " +
+                                    std::to_string(columns.size()));
+        }
+        for (size_t i = 0; i < notNullConstraints.size(); ++i) {
+            if (notNullConstraints[i] && row[i].empty()) {
+                throw ConstraintViolationException("NOT NULL constraint violated for column '" + columns[i] + "'");
+            }
+        }
+        if (isPartitioned()) {
+            partitionOf(row);
+        }
+    });
+    
+    for (const auto& constraint : constraints) {
+        if (constraint.type != Constraint::Type::PRIMARY_KEY && constraint.type != Constraint::Type::UNIQUE) {
+            continue;
+        }
+        
+        std::vector<size_t> colIndices;
+        for (const auto& colName : constraint.columns) {
+            auto it = std::find(columns.begin(), columns.end(), colName);
+            if (it == columns.end()) {
+                throw DatabaseException("Column '" + colName + "' not found in unique constraint");
+            }
+            colIndices.push_back(std::distance(columns.begin(), it));
+        }
+        auto violated = [&]() {
+            return ConstraintViolationException(
+                std::string(constraint.type == Constraint::Type::PRIMARY_KEY ? "PRIMARY KEY" : "UNIQUE") +
+                " constraint '" + constraint.name + "' violated");
+        };
+        
+        // Length-prefixed parts keep ("ab", "c") and ("a", "bc") apart
+        std::string key;
+        auto makeKey = [&](const RowView& row) {
+            key.clear();
+            for (size_t idx : colIndices) {
+                key += std::to_string(row[idx].size());
+                key += ':';
+                key += row[idx];
+            }
+        };
+        std::unordered_set<std::string> loaded;
+        loaded.reserve(rowCount - firstNew);
+        visitMemoryRows(firstNew, rowCount, [&](const RowView& row) {
+            makeKey(row);
+            if (!loaded.insert(key).second) {
+                throw violated();
+            }
+        });
+        visitMemoryRows(0, firstNew, [&](const RowView& row) {
+            makeKey(row);
+            if (loaded.count(key) > 0) {
+                throw violated();
+            }
+        });
+    }
+}
 // Data Querying
 // -------------
+// ORDER BY over selected rows: numeric where both cells parse, text otherwise
+static void sortSelectResult(std::vector<std::vector<std::string>>& result,
+                             const std::vector<std::string>& displayColumns,
+                             const std::vector<std::string>& orderByColumns) {
+    // Sort columns and directions are resolved once, not per comparison
+    std::vector<std::pair<size_t, bool>> sortKeys;
+    for (const auto& token : orderByColumns) {
+        std::string colName = token;
+        bool desc = false;
+        size_t pos = toUpperCase(token).find(" DESC");
+        if (pos != std::string::npos) {
+            desc = true;
+            colName = trim(token.substr(0, pos));
+        }
+        auto it = std::find(displayColumns.begin(), displayColumns.end(), colName);
+        if (it != displayColumns.end()) {
+            sortKeys.emplace_back(std::distance(displayColumns.begin(), it), desc);
+        }
+    }
+    if (sortKeys.empty()) {
+        return;
+    }
+    auto less = [&](const std::vector<std::string>& a, const std::vector<std::string>& b) {
+        for (const auto& [idx, desc] : sortKeys) {
+            if (idx < a.size() && idx < b.size()) {
+                // Try numeric comparison first
+                double aVal, bVal;
+                if (compareAsNumbers(a[idx], b[idx], aVal, bVal)) {
+                    if (aVal != bVal) {
+                        return desc ? (aVal > bVal) : (aVal < bVal);
+                    }
+                } else if (a[idx] != b[idx]) {
+                    // Fall back to string comparison
+                    return desc ? (a[idx] > b[idx]) : (a[idx] < b[idx]);
+                }
+            }
+        }
+        return false;
+    };
+    
+    // Rows often arrive with a long ordered run in front, all of them when a
+    // clustered table is read in key order: only the rest is sorted and then
+    // merged with the run. A run in the opposite direction is reversed first.
+    auto runEnd = std::is_sorted_until(result.begin(), result.end(), less);
+    if (runEnd != result.end()) {
+        auto reverseEnd = std::is_sorted_until(result.begin(), result.end(), [&](const auto& a, const auto& b) {
+            return less(b, a);
+        });
+        if (reverseEnd > runEnd) {
+            std::reverse(result.begin(), reverseEnd);
+            runEnd = reverseEnd;
+        }
+    }
+    std::sort(runEnd, result.end(), less);
+    std::inplace_merge(result.begin(), runEnd, result.end(), less);
+}
 // In Table.cpp, improve the selectRows method for GROUP BY
 std::vector<std::vector<std::string>> Table::selectRows(
     const std::vector<std::string>& selectColumns,
@@ -1026,6 +1591,7 @@ std::vector<std::vector<std::string>> Table::selectRows(
     const std::vector<std::string>& groupByColumns,
     const std::string& havingCondition
 ) {
+    ensureRowsLoaded();
     std::shared_lock<std::shared_mutex> lock(mutex);
     
     // Determine which columns to display
@@ -1039,6 +1605,12 @@ std::vector<std::vector<std::string>> Table::selectRows(
         displayColumns = selectColumns;
     }
     
+    if (columnStore) {
+        auto result = selectFromColumns(displayColumns, useAllColumns, condition, groupByColumns, havingCondition);
+        sortSelectResult(result, displayColumns, orderByColumns);
+        return result;
+    }
+    
     // Apply condition to filter rows
     std::vector<std::vector<std::string>> filteredRows;
     if (!condition.empty()) {
@@ -1046,21 +1618,76 @@ std::vector<std::vector<std::string>> Table::selectRows(
             ConditionParser cp(condition);
             auto expr = cp.parse();
             
-            for (const auto& row : rows) {
+            // Mapped rows are evaluated in place; only matching rows are copied
+            forEachCandidateRow(*expr, [&](const RowView& row) {
                 if (expr->evaluate(row, columns)) {
-                    filteredRows.push_back(row);
+                    std::vector<std::string> match;
+                    match.reserve(row.size());
+                    for (size_t i = 0; i < row.size(); ++i) {
+                        match.emplace_back(row[i]);
+                    }
+                    filteredRows.push_back(std::move(match));
                 }
-            }
+            });
         } catch (const std::exception& e) {
             throw DatabaseException("Error evaluating condition: " + std::string(e.what()));
         }
     } else {
-        filteredRows = rows;
+        forEachSegment([&](const TableSegment& mappedSegment) {
+            mappedSegment.appendRowsTo(filteredRows);
+        });
+        if (rowArena) {
+            rowArena->appendRowsTo(filteredRows);
+        }
+        forEachPartitionRow([&](uint64_t, const RowView& row) {
+            std::vector<std::string>& copy = filteredRows.emplace_back();
+            copy.reserve(row.size());
+            for (size_t i = 0; i < row.size(); ++i) {
+                copy.emplace_back(row[i]);
+            }
+        });
+        filteredRows.insert(filteredRows.end(), rows.begin(), rows.end());
     }
     
     // Handle GROUP BY clause
     if (!groupByColumns.empty()) {
-        // ... existing group by code ...
+        std::vector<size_t> groupIndexes = groupColumnIndexes(groupByColumns);
+        // Rows group on the text of their group columns, length-prefixed so
+        // that no two distinct tuples share a key
+        std::unordered_map<std::string, uint32_t> groupOfKey;
+        std::vector<uint32_t> groupOf;
+        std::vector<size_t> firstRows;
+        GroupedRows groups;
+        std::string key;
+        for (size_t r = 0; r < filteredRows.size(); ++r) {
+            key.clear();
+            for (size_t c : groupIndexes) {
+                const std::string& cell = filteredRows[r][c];
+                key += std::to_string(cell.size());
+                key += ':';
+                key += cell;
+            }
+            auto inserted = groupOfKey.emplace(key, static_cast<uint32_t>(firstRows.size()));
+            if (inserted.second) {
+                firstRows.push_back(r);
+                groups.sizes.push_back(0);
+            }
+            groupOf.push_back(inserted.first->second);
+            groups.sizes[inserted.first->second]++;
+        }
+        groups.groupCount = firstRows.size();
+        groups.firstCell = [&](size_t group, size_t column) {
+            return filteredRows[firstRows[group]][column];
+        };
+        groups.memberCells = [&](size_t column, std::vector<std::vector<std::string>>& cells) {
+            cells.assign(groups.groupCount, {});
+            for (size_t r = 0; r < filteredRows.size(); ++r) {
+                cells[groupOf[r]].push_back(filteredRows[r][column]);
+            }
+        };
+        auto result = groupResult(displayColumns, havingCondition, groups);
+        sortSelectResult(result, displayColumns, orderByColumns);
+        return result;
     }
     
     // If no GROUP BY, handle simple queries
@@ -1156,50 +1783,154 @@ std::vector<std::vector<std::string>> Table::selectRows(
         }
     }
     
-    // Handle ORDER BY
-    if (!orderByColumns.empty()) {
-        std::sort(result.begin(), result.end(), 
-            [&](const auto& a, const auto& b) {
-                for (const auto& token : orderByColumns) {
-                    std::string colName = token;
-                    bool desc = false;
-                    
-                    size_t pos = toUpperCase(token).find(" DESC");
-                    if (pos != std::string::npos) {
-                        desc = true;
-                        colName = trim(token.substr(0, pos));
-                    }
-                    
-                    auto it = std::find(displayColumns.begin(), displayColumns.end(), colName);
-                    if (it != displayColumns.end()) {
-                        int idx = std::distance(displayColumns.begin(), it);
-                        
-                        if (idx < a.size() && idx < b.size()) {
-                            // Try numeric comparison first
-                            try {
-                                double aVal = std::stod(a[idx]);
-                                double bVal = std::stod(b[idx]);
-                                if (aVal != bVal) {
-                                    return desc ? (aVal > bVal) : (aVal < bVal);
-                                }
-                            } catch (...) {
-                                // Fall back to string comparison
-                                if (a[idx] != b[idx]) {
-                                    return desc ? (a[idx] > b[idx]) : (a[idx] < b[idx]);
-                                }
-                            }
-                        }
-                    }
-                }
-                return false;
-            });
+    sortSelectResult(result, displayColumns, orderByColumns);
+    
+    return result;
+}
+// GROUP BY
+// --------
+// Replaces the aggregate calls in a HAVING condition with the names
+// __having0, __having1, ... and collects the calls in order
+static std::string extractHavingAggregates(const std::string& having, std::vector<std::string>& calls) {
+    auto isWordChar = [](char ch) { return std::isalnum(static_cast<unsigned char>(ch)) || ch == '_'; };
+    std::string rewritten;
+    bool inQuotes = false;
+    size_t i = 0;
+    while (i < having.size()) {
+        char ch = having[i];
+        if (ch == '\'' || inQuotes || !isWordChar(ch)) {
+            inQuotes = inQuotes != (ch == '\'');
+            rewritten.push_back(ch);
+            i++;
+            continue;
+        }
+        size_t wordEnd = i;
+        while (wordEnd < having.size() && isWordChar(having[wordEnd])) {
+            wordEnd++;
+        }
+        std::string word = having.substr(i, wordEnd - i);
+        size_t open = wordEnd;
+        while (open < having.size() && std::isspace(static_cast<unsigned char>(having[open]))) {
+            open++;
+        }
+        size_t close = open < having.size() && having[open] == '(' ? having.find_first_of("()", open + 1)
+                                                                   : std::string::npos;
+        std::string upper = toUpperCase(word);
+        if (close == std::string::npos || having[close] != ')' || upper == "IN" || upper == "NOT") {
+            rewritten += word;
+            i = wordEnd;
+            continue;
+        }
+        rewritten += "__having" + std::to_string(calls.size());
+        calls.push_back(word + "(" + trim(having.substr(open + 1, close - open - 1)) + ")");
+        i = close + 1;
+    }
+    return rewritten;
+}
+std::vector<size_t> Table::groupColumnIndexes(const std::vector<std::string>& groupByColumns) const {
+    std::vector<size_t> indexes;
+    for (const auto& name : groupByColumns) {
+        auto colIt = std::find(columns.begin(), columns.end(), name);
+        if (colIt == columns.end()) {
+            throw DatabaseException("Column '" + name + "' does not exist");
+        }
+        indexes.push_back(std::distance(columns.begin(), colIt));
+    }
+    return indexes;
+}
+std::vector<std::vector<std::string>> Table::groupResult(const std::vector<std::string>& displayColumns,
+                                                         const std::string& havingCondition,
+                                                         const GroupedRows& groups) {
+    std::vector<std::string> havingCalls;
+    std::string having = extractHavingAggregates(havingCondition, havingCalls);
+    
+    // One value per group for every displayed column and HAVING aggregate;
+    // a plain column shows its cell in the group's first row
+    std::vector<std::string> expressions = displayColumns;
+    expressions.insert(expressions.end(), havingCalls.begin(), havingCalls.end());
+    std::vector<std::vector<std::string>> values(expressions.size());
+    std::vector<std::vector<std::string>> cells;
+    for (size_t e = 0; e < expressions.size(); ++e) {
+        const std::string& col = expressions[e];
+        std::vector<std::string>& out = values[e];
+        size_t pos1 = col.find('(');
+        size_t pos2 = col.find(')');
+        std::string colName = col;
+        std::string func;
+        if (pos1 != std::string::npos && pos2 != std::string::npos) {
+            func = toUpperCase(trim(col.substr(0, pos1)));
+            colName = trim(col.substr(pos1 + 1, pos2 - pos1 - 1));
+        }
+        if (colName == "*" && func == "COUNT") {
+            for (size_t size : groups.sizes) {
+                out.push_back(std::to_string(size));
+            }
+            continue;
+        }
+        auto colIt = std::find(columns.begin(), columns.end(), colName);
+        if (colIt == columns.end()) {
+            out.assign(groups.groupCount, ""); // Column not found
+            continue;
+        }
+        size_t colIdx = std::distance(columns.begin(), colIt);
+        if (func.empty()) {
+            for (size_t g = 0; g < groups.groupCount; ++g) {
+                out.push_back(groups.firstCell(g, colIdx));
+            }
+        } else if (!groups.aggregate || !groups.aggregate(func, colIdx, out)) {
+            groups.memberCells(colIdx, cells);
+            for (const auto& groupCells : cells) {
+                out.push_back(applyAggregateFunction(func, groupCells));
+            }
+        }
+    }
+    
+    // HAVING sees the table's columns as in the group's first row, followed
+    // by its aggregates
+    ConditionExprPtr havingExpr;
+    std::vector<std::string> havingColumns;
+    if (!trim(having).empty()) {
+        try {
+            ConditionParser cp(having);
+            havingExpr = cp.parse();
+        } catch (const std::exception& e) {
+            throw DatabaseException("Error evaluating HAVING condition: " + std::string(e.what()));
+        }
+        havingColumns = columns;
+        for (size_t i = 0; i < havingCalls.size(); ++i) {
+            havingColumns.push_back("__having" + std::to_string(i));
+        }
     }
     
+    std::vector<std::vector<std::string>> result;
+    std::vector<std::string> havingRow;
+    for (size_t g = 0; g < groups.groupCount; ++g) {
+        if (havingExpr) {
+            havingRow.clear();
+            for (size_t c = 0; c < columns.size(); ++c) {
+                havingRow.push_back(groups.firstCell(g, c));
+            }
+            // An aggregate over NULLs reads "NULL"; as a NULL cell no
+            // comparison holds for it
+            for (size_t i = 0; i < havingCalls.size(); ++i) {
+                const std::string& value = values[displayColumns.size() + i][g];
+                havingRow.push_back(value == "NULL" ? std::string() : value);
+            }
+            if (!havingExpr->evaluate(havingRow, havingColumns)) {
+                continue;
+            }
+        }
+        std::vector<std::string>& row = result.emplace_back();
+        for (size_t e = 0; e < displayColumns.size(); ++e) {
+            row.push_back(std::move(values[e][g]));
+        }
+    }
     return result;
 }
 // Debugging
 // ---------
 void Table::printTable() {
+    ensureRowsLoaded();
     std::shared_lock<std::shared_mutex> lock(mutex);
     
     for (const auto& col : columns) {
@@ -1217,11 +1948,22 @@ void Table::printTable() {
     }
     std::cout << std::endl;
     
-    for (const auto& row : rows) {
+    auto printRow = [this](const RowView& row) {
         for (size_t i = 0; i < columns.size(); ++i) {
-            std::cout << (i < row.size() ? row[i] : "NULL") << "\t";
+            std::cout << (i < row.size() ? displayCell(row[i]) : std::string_view("NULL")) << "\t";
         }
         std::cout << std::endl;
+    };
+    forEachSegment([&](const TableSegment& mappedSegment) {
+        TableSegment::Cursor cursor(mappedSegment);
+        std::vector<std::string_view> row;
+        while (cursor.next(row)) {
+            printRow(row);
+        }
+    });
+    forEachPackedRow(printRow);
+    for (const auto& row : rows) {
+        printRow(row);
     }
 }
 // Add these implementations to Table.cpp
@@ -1230,35 +1972,62 @@ void Table::enforceDataType(int columnIndex, std::string& value) {
         throw DataTypeException("Column index out of range");
     }
     
+    std::string type = columnTypes[columnIndex];
+    DataType dataType = getDataType(type);
+    
+    if (value == EMPTY_TEXT_CELL && dataType != DataType::CHAR && dataType != DataType::VARCHAR &&
+        dataType != DataType::TEXT) {
+        // Only text has an empty value; '' elsewhere means NULL
+        value.clear();
+    }
     if (value.empty()) {
-        // Empty strings are allowed (NULL values)
+        // NULL values
         return;
     }
     
-    std::string type = columnTypes[columnIndex];
-    DataType dataType = getDataType(type);
-    
     switch (dataType) {
         case DataType::INT:
         case DataType::SMALLINT: {
-            try {
-                int val = std::stoi(value);
-                value = std::to_string(val);
-            } catch (const std::exception& e) {
+            int val;
+            if (!TypedValues::parseIntegerPrefix(value, val)) {
                 throw DataTypeException("Invalid integer value: " + value);
             }
+            value = std::to_string(val);
             break;
         }
         case DataType::NUMERIC:
         case DataType::REAL:
         case DataType::DOUBLE_PRECISION:
         case DataType::FLOAT: {
-            try {
-                double val = std::stod(value);
-                value = std::to_string(val);
-            } catch (const std::exception& e) {
+            // NUMERIC(p,d) keeps exactly d decimals and at most p digits
+            auto params = extractTypeParameters(type);
+            int64_t scaled;
+            if (dataType == DataType::NUMERIC && params.first > 0 &&
+                params.first <= TypedValues::MAX_DECIMAL_DIGITS && params.second <= params.first) {
+                double val;
+                if (!TypedValues::parseDecimal(value, params.second, scaled)) {
+                    if (!TypedValues::parseRealPrefix(value, val)) {
+                        throw DataTypeException("Invalid numeric value: " + value);
+                    }
+                    if (!TypedValues::parseDecimal(TypedValues::formatReal(val), params.second, scaled)) {
+                        throw DataTypeException("Numeric value out of range for " + type + ": " + value);
+                    }
+                }
+                int64_t limit = 1;
+                for (int i = 0; i < params.first; ++i) {
+                    limit *= 10;
+                }
+                if (scaled >= limit || scaled <= -limit) {
+                    throw DataTypeException("Numeric value out of range for " + type + ": " + value);
+                }
+                value = TypedValues::formatDecimal(scaled, params.second);
+                break;
+            }
+            double val;
+            if (!TypedValues::parseRealPrefix(value, val)) {
                 throw DataTypeException("Invalid numeric value: " + value);
             }
+            value = TypedValues::formatReal(val);
             break;
         }
         case DataType::CHAR:
@@ -1269,7 +2038,7 @@ void Table::enforceDataType(int columnIndex, std::string& value) {
             
             // Remove quotes if present
             if (value.size() >= 2 && value.front() == '\'' && value.back() == '\'') {
-                value = value.substr(1, value.size() - 2);
+                value = literalCell(value);
             }
             
             if (maxSize > 0 && value.size() > static_cast<size_t>(maxSize)) {
@@ -1284,39 +2053,45 @@ void Table::enforceDataType(int columnIndex, std::string& value) {
             break;
         }
         case DataType::DATE: {
-            // Simple date validation: YYYY-MM-DD
-            std::regex dateRegex("^\\d{4}-\\d{2}-\\d{2}$");
-            if (!std::regex_match(value, dateRegex)) {
+            int32_t days;
+            if (!TypedValues::parseDate(value, days)) {
+                if (TypedValues::isDateShaped(value)) {
+                    throw DataTypeException("Date out of range: " + value);
+                }
                 throw DataTypeException("Invalid date format: " + value + ". Expected YYYY-MM-DD");
             }
             break;
         }
         case DataType::TIME: {
-            // Simple time validation: HH:MM:SS
-            std::regex timeRegex("^\\d{2}:\\d{2}:\\d{2}$");
-            if (!std::regex_match(value, timeRegex)) {
+            // Stored canonically, so that times compare in order as text
+            int64_t micros;
+            if (!TypedValues::parseTime(value, micros)) {
+                if (TypedValues::isTimeShaped(value)) {
+                    throw DataTypeException("Time out of range: " + value);
+                }
                 throw DataTypeException("Invalid time format: " + value + ". Expected HH:MM:SS");
             }
+            value = TypedValues::formatTime(micros);
             break;
         }
         case DataType::TIMESTAMP: {
-            // Simple timestamp validation: YYYY-MM-DD HH:MM:SS
-            std::regex timestampRegex("^\\d{4}-\\d{2}-\\d{2} \\d{2}:\\d{2}:\\d{2}$");
-            if (!std::regex_match(value, timestampRegex)) {
+            int64_t micros;
+            if (!TypedValues::parseTimestamp(value, micros)) {
+                if (TypedValues::isTimestampShaped(value)) {
+                    throw DataTypeException("Timestamp out of range: " + value);
+                }
                 throw DataTypeException("Invalid timestamp format: " + value + ". Expected YYYY-MM-DD HH:MM:SS");
             }
+            value = TypedValues::formatTimestamp(micros);
             break;
         }
         case DataType::BOOLEAN: {
             // Normalize boolean values
-            std::string upperVal = toUpperCase(value);
-            if (upperVal == "TRUE" || upperVal == "1" || upperVal == "T" || upperVal == "YES" || upperVal == "Y") {
-                value = "TRUE";
-            } else if (upperVal == "FALSE" || upperVal == "0" || upperVal == "F" || upperVal == "NO" || upperVal == "N") {
-                value = "FALSE";
-            } else {
+            bool flag;
+            if (!TypedValues::parseBoolean(value, flag)) {
                 throw DataTypeException("Invalid boolean value: " + value);
             }
+            value = TypedValues::formatBoolean(flag);
             break;
         }
         case DataType::USER_DEFINED: {
@@ -1334,6 +2109,19 @@ void Table::enforceDataType(int columnIndex, std::string& value) {
             break;
     }
 }
+// True if some row of a cold partition's segment holds key's values in all
+// of keyColumns
+static bool segmentContainsKey(const TableSegment& segment, const std::vector<int>& keyColumns,
+                               const std::vector<std::string>& key) {
+    TableSegment::Cursor cursor(segment);
+    std::vector<std::string_view> row;
+    while (cursor.next(row)) {
+        if (RowArena::holdsKey(row, keyColumns, key)) {
+            return true;
+        }
+    }
+    return false;
+}
 // In Table.cpp, update the validateUniqueConstraint method:
 // Modified version of validateUniqueConstraint without additional mutex lock
 bool Table::validateUniqueConstraint(const Constraint& constraint, const std::vector<std::string>& newRow) {
@@ -1350,11 +2138,35 @@ bool Table::validateUniqueConstraint(const Constraint& constraint, const std::ve
         colIndices.push_back(std::distance(columns.begin(), it));
     }
     
-    // Check if any existing row has the same values for the constrained columns
-    for (const auto& row : rows) {
-        bool allMatch = true;
-        for (int idx : colIndices) {
-            if (idx >= row.size() || idx >= newRow.size()) {
+    // A key that includes the partition column can only repeat within the
+    // new row's own partition
+    bool inPartitions = false;
+    if (isPartitioned()) {
+        bool keyed = std::find(colIndices.begin(), colIndices.end(), static_cast<int>(partitionKeyIndex())) !=
+                     colIndices.end();
+        size_t home = keyed ? partitionOf(newRow) : 0;
+        for (size_t p = 0; p < partitionTables.size() && !inPartitions; ++p) {
+            const Table& child = *partitionTables[p];
+            if (keyed && p != home) {
+                continue;
+            }
+            inPartitions = child.segment ? segmentContainsKey(*child.segment, colIndices, newRow)
+                                         : child.rowArena && child.rowArena->containsKey(colIndices, newRow);
+        }
+    }
+    if (inPartitions || (columnStore && columnStore->containsKey(colIndices, newRow)) ||
+        (rowArena && rowArena->containsKey(colIndices, newRow))) {
+        if (constraint.type == Constraint::Type::PRIMARY_KEY) {
+            throw ConstraintViolationException("PRIMARY KEY constraint violated");
+        }
+        throw ConstraintViolationException("UNIQUE constraint violated");
+    }
+    
+    // Check if any existing row has the same values for the constrained columns
+    for (const auto& row : rows) {
+        bool allMatch = true;
+        for (int idx : colIndices) {
+            if (idx >= row.size() || idx >= newRow.size()) {
                 allMatch = false;
                 break;
             }
@@ -1427,24 +2239,38 @@ bool Table::validateConstraintsForUpdate(const std::vector<std::string>& oldRow,
                 
                 if (changed) {
                     // Only check if the constrained columns were changed
-                    for (const auto& row : rows) {
-                        if (row == oldRow) {
-                            continue; // Skip the row being updated
+                    auto clashes = [&](const RowView& row) {
+                        bool updated = row.size() == oldRow.size();
+                        for (size_t i = 0; i < row.size() && updated; ++i) {
+                            updated = row[i] == oldRow[i];
+                        }
+                        if (updated) {
+                            return false; // Skip the row being updated
                         }
-                        
-                        bool allMatch = true;
                         for (int idx : colIndices) {
-                            if (idx >= row.size() || idx >= newRow.size() || row[idx] != newRow[idx]) {
-                                allMatch = false;
-                                break;
+                            size_t column = static_cast<size_t>(idx);
+                            if (column >= row.size() || column >= newRow.size() || row[column] != newRow[column]) {
+                                return false;
                             }
                         }
-                        if (allMatch) {
-                            throw ConstraintViolationException(
-                                std::string(constraint.type == Constraint::Type::PRIMARY_KEY ? "PRIMARY KEY" : "UNIQUE") +
-                                " constraint '" + constraint.name + "' violated");
+                        return true;
+                    };
+                    bool clash = false;
+                    std::vector<std::string_view> cells;
+                    for (size_t slot = 0; rowArena && slot < rowArena->getSlotCount() && !clash; ++slot) {
+                        if (rowArena->isLive(slot)) {
+                            rowArena->readRow(slot, cells);
+                            clash = clashes(cells);
                         }
                     }
+                    for (size_t r = 0; r < rows.size() && !clash; ++r) {
+                        clash = clashes(rows[r]);
+                    }
+                    if (clash) {
+                        throw ConstraintViolationException(
+                            std::string(constraint.type == Constraint::Type::PRIMARY_KEY ? "PRIMARY KEY" : "UNIQUE") +
+                            " constraint '" + constraint.name + "' violated");
+                    }
                 }
                 break;
             }
@@ -1465,4 +2291,1299 @@ bool Table::validateConstraintsForUpdate(const std::vector<std::string>& oldRow,
     }
     
     return true;
-}
\ No newline at end of file
+}
+// Mapped Segments
+// ---------------
+void Table::attachSegment(std::shared_ptr<const TableSegment> mappedSegment) {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    noteRewrite();
+    if (!rows.empty() || (rowArena && rowArena->getRowCount() > 0) ||
+        (columnStore && columnStore->getRowCount() > 0)) {
+        throw DatabaseException("Cannot map a segment into a table that already has rows");
+    }
+    segment = std::move(mappedSegment);
+    segmentIds.clear();
+    deltaSegments.clear();
+    mapped = true;
+    nextRowId = static_cast<int>(segment->getRowCount()) + 1;
+    if (storageMode != StorageMode::ROW || isPartitioned()) {
+        segment->appendRowsTo(rows);
+        segment.reset();
+        mapped = false;
+        packRows();
+    }
+}
+bool Table::isMapped() const {
+    ensureRowsLoaded();
+    return mapped;
+}
+void Table::appendDelta(Table& delta, bool verifyRows) {
+    // Mapped files are not verified, as a mapped base is not either
+    if (isMapped()) {
+        bool mappedDelta = delta.isMapped();
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        if (mappedDelta && rows.empty()) {
+            deltaSegments.push_back(delta.segment);
+            nextRowId += static_cast<int>(delta.segment->getRowCount());
+            return;
+        }
+        lock.unlock();
+        delta.materializeSegment();
+        auto& tail = delta.rows;
+        lock.lock();
+        noteAppend();
+        nextRowId += static_cast<int>(tail.size());
+        rowIds.clear();
+        rows.insert(rows.end(), std::make_move_iterator(tail.begin()), std::make_move_iterator(tail.end()));
+        return;
+    }
+    if (getRowCount() == 0 && delta.isMapped() && storageMode == StorageMode::ROW && !isPartitioned()) {
+        attachSegment(delta.segment);
+        return;
+    }
+    delta.materializeSegment();
+    delta.rowIds.clear();
+    bulkLoadRows(std::move(delta.rows), verifyRows);
+}
+void Table::forEachSegment(const std::function<void(const TableSegment&)>& visitor) const {
+    if (segment) {
+        visitor(*segment);
+    }
+    for (const auto& deltaSegment : deltaSegments) {
+        visitor(*deltaSegment);
+    }
+}
+void Table::materializeSegment() const {
+    ensureRowsLoaded();
+    if (!mapped && !packed) {
+        return;
+    }
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    unpackRows();
+    if (!segment) {
+        return;
+    }
+    std::vector<std::vector<std::string>> loaded;
+    forEachSegment([&](const TableSegment& mappedSegment) {
+        mappedSegment.appendRowsTo(loaded);
+    });
+    bool keepIds = segmentIds.size() == loaded.size() && rowIds.size() == rows.size();
+    loaded.insert(loaded.end(), std::make_move_iterator(rows.begin()), std::make_move_iterator(rows.end()));
+    rows = std::move(loaded);
+    if (keepIds) {
+        segmentIds.insert(segmentIds.end(), rowIds.begin(), rowIds.end());
+        rowIds = std::move(segmentIds);
+    } else {
+        rowIds.clear();
+    }
+    segmentIds.clear();
+    segment.reset();
+    deltaSegments.clear();
+    mapped = false;
+}
+const std::vector<std::vector<std::string>>& Table::getRows() const {
+    materializeSegment();
+    return rows;
+}
+void Table::forEachRow(const std::function<void(const RowView&)>& visitor) const {
+    ensureRowsLoaded();
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    forEachSegment([&](const TableSegment& mappedSegment) {
+        TableSegment::Cursor cursor(mappedSegment);
+        std::vector<std::string_view> row;
+        while (cursor.next(row)) {
+            visitor(row);
+        }
+    });
+    forEachPackedRow(visitor);
+    for (const auto& row : rows) {
+        visitor(row);
+    }
+}
+// Zone Maps
+// ---------
+void Table::refreshRowZones() const {
+    std::lock_guard<std::mutex> lock(zoneMutex);
+    size_t rowCount = memoryRowCount();
+    if (zonedRewriteVersion != rewriteVersion || rowCount < zonedRows) {
+        rowZones.clear();
+        zonedRows = 0;
+        zonedRewriteVersion = rewriteVersion;
+    }
+    if (zonedRows == rowCount) {
+        return;
+    }
+    
+    // Appended rows first fill up the last, partial block. Blocks span slots,
+    // so dead ones count toward a block without adding to its zone.
+    if (zonedRows % ZoneMaps::ROWS_PER_ZONE != 0) {
+        rowZones.pop_back();
+        zonedRows = rowZones.size() * ZoneMaps::ROWS_PER_ZONE;
+    }
+    std::vector<size_t> keyColumns = getKeyColumnIndexes();
+    while (zonedRows < rowCount) {
+        size_t end = std::min(zonedRows + ZoneMaps::ROWS_PER_ZONE, rowCount);
+        BlockZone zone;
+        zone.trackKeys(keyColumns);
+        visitMemoryRows(zonedRows, end, [&](const RowView& row) {
+            zone.add(row);
+        });
+        zone.finish();
+        rowZones.push_back(std::move(zone));
+        zonedRows = end;
+    }
+}
+void Table::forEachCandidateRow(const ConditionExpression& condition,
+                                const std::function<void(const RowView&)>& visitor) const {
+    forEachSegment([&](const TableSegment& mappedSegment) {
+        auto scanPages = [&](uint32_t firstPage, uint32_t endPage) {
+            TableSegment::Cursor cursor(mappedSegment, firstPage, endPage);
+            std::vector<std::string_view> row;
+            while (cursor.next(row)) {
+                visitor(row);
+            }
+        };
+        const auto& zones = mappedSegment.getZones();
+        if (zones.empty()) {
+            scanPages(0, UINT32_MAX);
+        }
+        // Each run of page zones that may match is read with one cursor
+        for (size_t zone = 0; zone < zones.size();) {
+            if (!condition.canMatchBlock(zones[zone], columns)) {
+                zone++;
+                continue;
+            }
+            size_t end = zone + 1;
+            while (end < zones.size() && condition.canMatchBlock(zones[end], columns)) {
+                end++;
+            }
+            scanPages(zones[zone].firstPage, end < zones.size() ? zones[end].firstPage : UINT32_MAX);
+            zone = end;
+        }
+    });
+    
+    // Partitions the condition rules out are never opened
+    for (size_t p = 0; p < partitionTables.size(); ++p) {
+        if (partitionCanMatch(p, condition)) {
+            touchPartition(p);
+            partitionTables[p]->forEachCandidateRow(condition, visitor);
+        }
+    }
+    
+    // Small tables are cheaper to scan than to summarize
+    size_t rowCount = memoryRowCount();
+    if (rowCount <= ZoneMaps::ROWS_PER_ZONE) {
+        visitMemoryRows(0, rowCount, visitor);
+        return;
+    }
+    refreshRowZones();
+    for (size_t zone = 0; zone < rowZones.size(); ++zone) {
+        if (!condition.canMatchBlock(rowZones[zone], columns)) {
+            continue;
+        }
+        size_t first = zone * ZoneMaps::ROWS_PER_ZONE;
+        visitMemoryRows(first, std::min(first + ZoneMaps::ROWS_PER_ZONE, rowCount), visitor);
+    }
+}
+size_t Table::memoryRowCount() const {
+    return (rowArena ? rowArena->getSlotCount() : 0) + rows.size();
+}
+void Table::visitMemoryRows(size_t first, size_t end, const std::function<void(const RowView&)>& visitor) const {
+    size_t arenaRows = rowArena ? rowArena->getSlotCount() : 0;
+    std::vector<std::string_view> row;
+    for (size_t i = first; i < std::min(end, arenaRows); ++i) {
+        if (rowArena->isLive(i)) {
+            rowArena->readRow(i, row);
+            visitor(row);
+        }
+    }
+    for (size_t i = std::max(first, arenaRows); i < end; ++i) {
+        visitor(rows[i - arenaRows]);
+    }
+}
+// Packed Storage
+// --------------
+std::string Table::storageModeName(StorageMode mode) {
+    return mode == StorageMode::COLUMN ? "column" : mode == StorageMode::CLUSTERED ? "clustered" : "row";
+}
+void Table::setStorageMode(StorageMode mode, const std::vector<std::string>& clusterKey) {
+    materializeSegmentOnly();
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    std::vector<std::string> key;
+    if (mode == StorageMode::CLUSTERED) {
+        key = clusterKey;
+        for (const auto& constraint : constraints) {
+            if (key.empty() && constraint.type == Constraint::Type::PRIMARY_KEY) {
+                key = constraint.columns;
+            }
+        }
+        if (key.empty()) {
+            throw DatabaseException("Clustered table '" + tableName + "' needs a PRIMARY KEY");
+        }
+        for (const auto& column : key) {
+            if (std::find(columns.begin(), columns.end(), column) == columns.end()) {
+                throw DatabaseException("Cluster column '" + column + "' does not exist");
+            }
+        }
+    }
+    if (mode == storageMode && key == clusterColumns) {
+        return;
+    }
+    if (isPartitioned()) {
+        throw DatabaseException("Partitioned tables use row storage");
+    }
+    noteRewrite();
+    unpackRows();
+    storageMode = mode;
+    clusterColumns = std::move(key);
+    packRows();
+}
+size_t Table::getPackedBytes() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    size_t bytes = rowArena ? rowArena->memoryBytes() : columnStore ? columnStore->memoryBytes() : 0;
+    for (const auto& child : partitionTables) {
+        bytes += child->rowArena ? child->rowArena->memoryBytes() : 0;
+    }
+    return bytes;
+}
+Table::MemoryStats Table::getMemoryStats() const {
+    MemoryStats stats;
+    if (rowsPending) {
+        return stats;
+    }
+    forEachRow([&](const RowView& row) {
+        stats.rowCount++;
+        for (size_t c = 0; c < row.size(); ++c) {
+            stats.payloadBytes += row[c].size();
+        }
+    });
+    auto stringBytes = [](const std::string& text) {
+        return text.capacity() > 15 ? text.capacity() + 1 : 0;
+    };
+    auto zoneBytes = [](const std::vector<BlockZone>& zones) {
+        size_t bytes = zones.capacity() * sizeof(BlockZone);
+        for (const auto& zone : zones) {
+            bytes += zone.memoryBytes() - sizeof(BlockZone);
+        }
+        return bytes;
+    };
+    // Partitions are tables of their own; their rows were counted above
+    auto addHeld = [&](const Table& table) {
+        stats.storeBytes += table.rowArena ? table.rowArena->memoryBytes() : 0;
+        stats.sharedBytes += table.rowArena ? table.rowArena->sharedBytes() : 0;
+        stats.storeBytes += table.columnStore ? table.columnStore->memoryBytes() : 0;
+        stats.heapBytes += table.rows.capacity() * sizeof(std::vector<std::string>);
+        for (const auto& row : table.rows) {
+            stats.heapBytes += row.capacity() * sizeof(std::string);
+            for (const auto& cell : row) {
+                stats.heapBytes += stringBytes(cell);
+            }
+        }
+        stats.indexBytes += (table.rowIds.capacity() + table.segmentIds.capacity()) * sizeof(uint64_t);
+        table.forEachSegment([&](const TableSegment& mappedSegment) {
+            stats.indexBytes += zoneBytes(mappedSegment.getZones());
+        });
+        std::lock_guard<std::mutex> zoneLock(table.zoneMutex);
+        stats.indexBytes += zoneBytes(table.rowZones);
+    };
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    addHeld(*this);
+    for (const auto& child : partitionTables) {
+        addHeld(*child);
+    }
+    stats.indexBytes += zoneBytes(partitionZones);
+    for (const auto& [value, partition] : listPartitionOf) {
+        stats.indexBytes += sizeof(std::string) + sizeof(size_t) + 2 * sizeof(void*) + stringBytes(value);
+    }
+    stats.indexBytes += listPartitionOf.bucket_count() * sizeof(void*);
+    return stats;
+}
+void Table::materializeSegmentOnly() const {
+    ensureRowsLoaded();
+    if (mapped) {
+        materializeSegment();
+    }
+}
+void Table::packRows() const {
+    if (segment || (packed && rows.empty())) {
+        return;
+    }
+    if (isPartitioned()) {
+        for (const auto& child : partitionTables) {
+            child->columns = columns;
+            child->columnTypes = columnTypes;
+            child->notNullConstraints = notNullConstraints;
+        }
+        // Every row finds its partition before any of them moves
+        for (const auto& row : rows) {
+            partitionOf(row);
+        }
+        bool keepIds = rowIds.size() == rows.size();
+        for (size_t r = 0; r < rows.size(); ++r) {
+            appendToPartition(rows[r], keepIds ? rowIds[r] : nextRowId++);
+        }
+        std::vector<std::vector<std::string>>().swap(rows);
+        std::vector<uint64_t>().swap(rowIds);
+        packed = true;
+        return;
+    }
+    if (storageMode != StorageMode::COLUMN) {
+        if (!rowArena) {
+            rowArena = std::make_unique<RowArena>();
+        }
+        size_t firstSlot = rowArena->getSlotCount();
+        bool keepIds = rowIds.size() == rows.size();
+        for (size_t r = 0; r < rows.size(); ++r) {
+            rowArena->append(rows[r], keepIds ? rowIds[r] : nextRowId++);
+        }
+        std::vector<std::vector<std::string>>().swap(rows);
+        std::vector<uint64_t>().swap(rowIds);
+        packed = true;
+        // Same rows in the same order, so the zone map still holds. New rows
+        // of a clustered table are sorted in when a rewrite is due anyway,
+        // or when they are all the rows there are.
+        if (storageMode == StorageMode::CLUSTERED) {
+            clusterRows(version == rewriteVersion || firstSlot == 0);
+        }
+        return;
+    }
+    // Rows of the wrong width (possible only through trusted loads) stay
+    // unpacked, as the store could not give them back unchanged
+    for (const auto& row : rows) {
+        if (row.size() != columns.size()) {
+            unpackRows();
+            return;
+        }
+    }
+    if (!columnStore) {
+        columnStore = std::make_unique<ColumnStore>(columnTypes);
+    }
+    for (const auto& row : rows) {
+        columnStore->append(row);
+    }
+    std::vector<std::vector<std::string>>().swap(rows);
+    rowIds.clear();
+    packed = true;
+    
+    std::lock_guard<std::mutex> zoneLock(zoneMutex);
+    rowZones.clear();
+    zonedRows = 0;
+}
+void Table::unpackRows() const {
+    if (!packed) {
+        return;
+    }
+    std::vector<std::vector<std::string>> unpacked;
+    std::vector<uint64_t> ids;
+    if (isPartitioned()) {
+        forEachPartitionRow([&](uint64_t id, const RowView& row) {
+            std::vector<std::string>& copy = unpacked.emplace_back();
+            copy.reserve(row.size());
+            for (size_t i = 0; i < row.size(); ++i) {
+                copy.emplace_back(row[i]);
+            }
+            ids.push_back(id);
+        });
+        resetPartitions();
+    } else if (rowArena) {
+        rowArena->appendRowsTo(unpacked, &ids);
+    } else {
+        columnStore->appendRowsTo(unpacked);
+    }
+    if (rowIds.size() == rows.size() && ids.size() == unpacked.size()) {
+        ids.insert(ids.end(), rowIds.begin(), rowIds.end());
+    } else {
+        ids.clear();
+    }
+    unpacked.insert(unpacked.end(), std::make_move_iterator(rows.begin()), std::make_move_iterator(rows.end()));
+    rows = std::move(unpacked);
+    rowIds = std::move(ids);
+    rowArena.reset();
+    clusteredSlots = 0;
+    columnStore.reset();
+    packed = false;
+}
+void Table::appendRow(const std::vector<std::string>& row) {
+    uint64_t id = nextRowId++;
+    if (isPartitioned()) {
+        appendToPartition(row, id);
+        return;
+    }
+    if (rowArena) {
+        rowArena->append(row, id);
+        if (storageMode == StorageMode::CLUSTERED) {
+            clusterRows(false);
+            if (clusterTailFull()) {
+                noteRewrite();
+                clusterRows(true);
+            }
+        }
+        return;
+    }
+    if (columnStore && row.size() == columns.size()) {
+        columnStore->append(row);
+        return;
+    }
+    unpackRows();
+    if (rowIds.size() == rows.size()) {
+        rowIds.push_back(id);
+    }
+    rows.push_back(row);
+    packRows();
+}
+void Table::forEachPackedRow(const std::function<void(const RowView&)>& visitor) const {
+    forEachPartitionRow([&](uint64_t, const RowView& row) {
+        visitor(row);
+    });
+    std::vector<std::string_view> row;
+    if (rowArena) {
+        for (size_t slot = 0; slot < rowArena->getSlotCount(); ++slot) {
+            if (rowArena->isLive(slot)) {
+                rowArena->readRow(slot, row);
+                visitor(row);
+            }
+        }
+    }
+    if (columnStore) {
+        std::vector<char> scratch;
+        for (size_t r = 0; r < columnStore->getRowCount(); ++r) {
+            columnStore->readRow(r, row, scratch);
+            visitor(row);
+        }
+    }
+}
+void Table::selectPackedRows(const ConditionExpression& condition, std::vector<uint8_t>& matches) const {
+    if (columnStore && condition.selectColumnar(*columnStore, columns, matches)) {
+        return;
+    }
+    // Row by row for an arena, or a condition with no columnar form (e.g.
+    // column against column)
+    matches.clear();
+    forEachPackedRow([&](const RowView& row) {
+        matches.push_back(condition.evaluate(row, columns) ? 1 : 0);
+    });
+}
+// Partitioning
+// ------------
+std::string Table::partitionKindName(PartitionKind kind) {
+    switch (kind) {
+        case PartitionKind::RANGE: return "RANGE";
+        case PartitionKind::LIST: return "LIST";
+        case PartitionKind::HASH: return "HASH";
+        default: return "NONE";
+    }
+}
+// A cell below a RANGE bound, compared the way conditions compare them
+static bool belowBound(std::string_view cell, const std::string& bound) {
+    double cellNumber, boundNumber;
+    if (!TypedValues::isTemporal(bound) && ZoneMaps::parseNumber(cell, cellNumber) &&
+        ZoneMaps::parseNumber(bound, boundNumber)) {
+        return cellNumber < boundNumber;
+    }
+    return cell < bound;
+}
+// Zone over one partition's partition column cells
+static BlockZone partitionZone() {
+    BlockZone zone;
+    zone.columns.resize(1);
+    return zone;
+}
+void Table::setPartitioning(PartitionKind kind, const std::string& columnName,
+                            const std::vector<Partition>& newPartitions) {
+    materializeSegment();
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    auto it = std::find(columns.begin(), columns.end(), columnName);
+    if (it == columns.end()) {
+        throw DatabaseException("Partition column '" + columnName + "' does not exist");
+    }
+    if (storageMode != StorageMode::ROW) {
+        throw DatabaseException("Partitioned tables use row storage");
+    }
+    if (newPartitions.empty()) {
+        throw DatabaseException("Table '" + tableName + "' needs at least one partition");
+    }
+    
+    // Bounds and values take the column's canonical spelling, as cells do
+    std::vector<Partition> canonical = newPartitions;
+    int keyIndex = static_cast<int>(std::distance(columns.begin(), it));
+    for (auto& partition : canonical) {
+        for (auto& value : partition.values) {
+            enforceDataType(keyIndex, value);
+        }
+    }
+    checkPartitions(kind, canonical);
+    
+    noteRewrite();
+    partitionKind = kind;
+    partitionColumn = columnName;
+    partitions = std::move(canonical);
+    rebuildListPartitions();
+    resetPartitions();
+    packRows();
+}
+void Table::addPartition(const Partition& partition) {
+    materializeSegmentOnly();
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    if (partitionKind != PartitionKind::RANGE && partitionKind != PartitionKind::LIST) {
+        throw DatabaseException("ADD PARTITION needs a table partitioned by RANGE or LIST");
+    }
+    Partition added = partition;
+    for (auto& value : added.values) {
+        enforceDataType(static_cast<int>(partitionKeyIndex()), value);
+    }
+    std::vector<Partition> candidate = partitions;
+    candidate.push_back(added);
+    checkPartitions(partitionKind, candidate);
+    
+    // The schema lives in the table file, so the next checkpoint rewrites it
+    noteRewrite();
+    packRows();
+    partitions.push_back(std::move(added));
+    partitionTables.push_back(makePartitionTable(partitions.back().name));
+    partitionZones.push_back(partitionZone());
+    rebuildListPartitions();
+}
+size_t Table::dropPartition(const std::string& partitionName) {
+    materializeSegmentOnly();
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    if (partitionKind != PartitionKind::RANGE && partitionKind != PartitionKind::LIST) {
+        throw DatabaseException("DROP PARTITION needs a table partitioned by RANGE or LIST");
+    }
+    auto it = std::find_if(partitions.begin(), partitions.end(), [&](const Partition& partition) {
+        return toLowerCase(partition.name) == toLowerCase(partitionName);
+    });
+    if (it == partitions.end()) {
+        throw DatabaseException("Partition '" + partitionName + "' does not exist in table '" + tableName + "'");
+    }
+    if (partitions.size() == 1) {
+        throw DatabaseException("Cannot drop the only partition of table '" + tableName + "'");
+    }
+    
+    // The partition's rows go with its child table; no other row is read
+    noteRewrite();
+    packRows();
+    size_t index = std::distance(partitions.begin(), it);
+    const Table& child = *partitionTables[index];
+    size_t dropped = (child.rowArena ? child.rowArena->getRowCount() : 0) +
+                     (child.segment ? child.segment->getRowCount() : 0);
+    partitions.erase(it);
+    partitionTables.erase(partitionTables.begin() + index);
+    partitionZones.erase(partitionZones.begin() + index);
+    rebuildListPartitions();
+    return dropped;
+}
+std::unique_ptr<Table> Table::makePartitionTable(const std::string& partitionName) const {
+    auto child = std::make_unique<Table>(tableName + "#" + partitionName);
+    child->columns = columns;
+    child->columnTypes = columnTypes;
+    child->notNullConstraints = notNullConstraints;
+    child->lastAccess = steadySeconds();
+    return child;
+}
+void Table::resetPartitions() const {
+    partitionTables.clear();
+    partitionZones.clear();
+    for (const auto& partition : partitions) {
+        partitionTables.push_back(makePartitionTable(partition.name));
+        partitionZones.push_back(partitionZone());
+    }
+}
+void Table::rebuildListPartitions() {
+    listPartitionOf.clear();
+    if (partitionKind != PartitionKind::LIST) {
+        return;
+    }
+    for (size_t p = 0; p < partitions.size(); ++p) {
+        for (const auto& value : partitions[p].values) {
+            listPartitionOf[value] = p;
+        }
+    }
+}
+void Table::checkPartitions(PartitionKind kind, const std::vector<Partition>& candidate) const {
+    std::unordered_set<std::string> names;
+    std::unordered_set<std::string> listed;
+    for (size_t p = 0; p < candidate.size(); ++p) {
+        const Partition& partition = candidate[p];
+        if (!names.insert(toLowerCase(partition.name)).second) {
+            throw DatabaseException("Duplicate partition name '" + partition.name + "'");
+        }
+        if (kind == PartitionKind::RANGE) {
+            if (partition.values.size() > 1) {
+                throw DatabaseException("RANGE partition '" + partition.name + "' takes a single bound");
+            }
+            if (partition.values.empty() && p + 1 < candidate.size()) {
+                throw DatabaseException("Only the last RANGE partition can be bounded by MAXVALUE");
+            }
+            if (p > 0 && !partition.values.empty() &&
+                !belowBound(candidate[p - 1].values[0], partition.values[0])) {
+                throw DatabaseException("RANGE partition bounds must increase, but '" + partition.name + "' does not");
+            }
+        } else if (kind == PartitionKind::LIST) {
+            if (partition.values.empty()) {
+                throw DatabaseException("LIST partition '" + partition.name + "' has no values");
+            }
+            for (const auto& value : partition.values) {
+                if (!listed.insert(value).second) {
+                    throw DatabaseException("Value " + std::string(displayCell(value)) +
+                                            " appears in more than one LIST partition");
+                }
+            }
+        } else if (!partition.values.empty()) {
+            throw DatabaseException("HASH partition '" + partition.name + "' takes no values");
+        }
+    }
+}
+size_t Table::partitionKeyIndex() const {
+    return std::distance(columns.begin(), std::find(columns.begin(), columns.end(), partitionColumn));
+}
+size_t Table::partitionOf(const RowView& row) const {
+    size_t keyIndex = partitionKeyIndex();
+    std::string_view key = keyIndex < row.size() ? row[keyIndex] : std::string_view();
+    if (partitionKind == PartitionKind::HASH) {
+        return BloomFilter::textKey(key) % partitions.size();
+    }
+    if (partitionKind == PartitionKind::LIST) {
+        auto it = listPartitionOf.find(std::string(key));
+        if (it != listPartitionOf.end()) {
+            return it->second;
+        }
+    } else {
+        // First partition whose bound lies above the key; NULL sorts first
+        size_t low = 0;
+        size_t high = partitions.size();
+        while (low < high) {
+            size_t middle = (low + high) / 2;
+            if (partitions[middle].values.empty() || belowBound(key, partitions[middle].values[0])) {
+                high = middle;
+            } else {
+                low = middle + 1;
+            }
+        }
+        if (low < partitions.size()) {
+            return low;
+        }
+    }
+    throw DatabaseException("No partition of table '" + tableName + "' holds " + partitionColumn + " = " +
+                            std::string(displayCell(key)));
+}
+void Table::appendToPartition(const std::vector<std::string>& row, uint64_t id) const {
+    size_t partition = partitionOf(row);
+    warmPartition(partition);
+    Table& child = *partitionTables[partition];
+    child.nextRowId = id;
+    child.appendRow(row);
+    BlockZone& zone = partitionZones[partition];
+    zone.columns[0].add(row[partitionKeyIndex()]);
+    zone.rowCount++;
+}
+bool Table::partitionCanMatch(size_t partition, const ConditionExpression& condition) const {
+    // The zone covers the partition column alone; a condition on any other
+    // column finds no zone for it and cannot rule the partition out
+    const BlockZone& zone = partitionZones[partition];
+    return zone.rowCount > 0 && condition.canMatchBlock(zone, {partitionColumn});
+}
+void Table::forEachPartitionRow(const std::function<void(uint64_t id, const RowView&)>& visitor) const {
+    // Every partition holds its rows in ID order, so merging on the ID of
+    // each partition's next row gives them back in insertion order. A cold
+    // partition is read from its segment, one row ahead.
+    struct Cursor {
+        const RowArena* arena;
+        size_t slot;
+        std::unique_ptr<TableSegment::Cursor> cold;
+        const std::vector<uint64_t>* coldIds;
+        std::vector<std::string_view> coldRow;
+    };
+    std::vector<Cursor> cursors;
+    cursors.reserve(partitionTables.size());
+    using Head = std::pair<uint64_t, size_t>;
+    std::priority_queue<Head, std::vector<Head>, std::greater<Head>> heads;
+    auto advance = [&](size_t c) {
+        Cursor& cursor = cursors[c];
+        if (cursor.cold) {
+            if (cursor.slot < cursor.coldIds->size() && cursor.cold->next(cursor.coldRow)) {
+                heads.push({(*cursor.coldIds)[cursor.slot], c});
+            }
+            return;
+        }
+        while (cursor.slot < cursor.arena->getSlotCount() && !cursor.arena->isLive(cursor.slot)) {
+            cursor.slot++;
+        }
+        if (cursor.slot < cursor.arena->getSlotCount()) {
+            heads.push({cursor.arena->rowId(cursor.slot), c});
+        }
+    };
+    for (const auto& child : partitionTables) {
+        if (child->rowArena) {
+            cursors.push_back({child->rowArena.get(), 0, nullptr, nullptr, {}});
+            advance(cursors.size() - 1);
+        } else if (child->segment) {
+            cursors.push_back({nullptr, 0, std::make_unique<TableSegment::Cursor>(*child->segment),
+                               &child->segmentIds, {}});
+            advance(cursors.size() - 1);
+        }
+    }
+    std::vector<std::string_view> row;
+    while (!heads.empty()) {
+        auto [id, c] = heads.top();
+        heads.pop();
+        Cursor& cursor = cursors[c];
+        if (cursor.cold) {
+            visitor(id, cursor.coldRow);
+        } else {
+            cursor.arena->readRow(cursor.slot, row);
+            visitor(id, row);
+        }
+        cursor.slot++;
+        advance(c);
+    }
+}
+bool Table::updateKeepsPartitions(const std::vector<std::pair<std::string, std::string>>& updates) const {
+    for (const auto& update : updates) {
+        if (update.first == partitionColumn) {
+            return false;
+        }
+        for (const auto& constraint : constraints) {
+            if ((constraint.type == Constraint::Type::PRIMARY_KEY || constraint.type == Constraint::Type::UNIQUE) &&
+                std::find(constraint.columns.begin(), constraint.columns.end(), update.first) !=
+                    constraint.columns.end()) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+// Tiering
+// -------
+void Table::setColdPolicy(ColdPolicy policy, uint32_t after) {
+    materializeSegmentOnly();
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    if (policy != ColdPolicy::NONE) {
+        if (!isPartitioned()) {
+            throw DatabaseException("Table '" + tableName + "' is not partitioned; only partitions turn cold");
+        }
+        if (after == 0) {
+            throw DatabaseException("A cold policy needs a positive age");
+        }
+    }
+    if (policy == ColdPolicy::AGE) {
+        DataType type = getDataType(columnTypes[partitionKeyIndex()]);
+        if (partitionKind != PartitionKind::RANGE || (type != DataType::DATE && type != DataType::TIMESTAMP)) {
+            throw DatabaseException("Partitions turn cold by age only under RANGE on a DATE or TIMESTAMP column");
+        }
+    }
+    noteRewrite();
+    packRows();
+    coldPolicy = policy;
+    coldAfter = policy == ColdPolicy::NONE ? 0 : after;
+    if (policy == ColdPolicy::NONE) {
+        for (size_t p = 0; p < partitionTables.size(); ++p) {
+            warmPartition(p);
+        }
+    }
+}
+std::vector<size_t> Table::findColdPartitions() const {
+    std::vector<size_t> cold;
+    if (!isLoaded()) {
+        return cold;
+    }
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    if (coldPolicy == ColdPolicy::NONE || !packed || !rows.empty()) {
+        return cold;
+    }
+    // Range bounds are exclusive, so a partition whose bound is the cutoff
+    // or earlier holds nothing newer than it
+    int64_t cutoff = (static_cast<int64_t>(std::time(nullptr)) / 86400 - coldAfter) * TypedValues::MICROS_PER_DAY;
+    bool dates = coldPolicy == ColdPolicy::AGE && getDataType(columnTypes[partitionKeyIndex()]) == DataType::DATE;
+    int64_t now = steadySeconds();
+    for (size_t p = 0; p < partitionTables.size(); ++p) {
+        const Table& child = *partitionTables[p];
+        if (child.segment || !child.rowArena || child.rowArena->getRowCount() == 0) {
+            continue;
+        }
+        if (coldPolicy == ColdPolicy::IDLE) {
+            if (now - child.lastAccess >= coldAfter) {
+                cold.push_back(p);
+            }
+            continue;
+        }
+        if (partitions[p].values.empty()) {
+            continue;   // MAXVALUE
+        }
+        const std::string& bound = partitions[p].values[0];
+        int32_t days = 0;
+        int64_t micros = 0;
+        bool parsed = dates ? TypedValues::parseDate(bound, days) : TypedValues::parseTimestamp(bound, micros);
+        if (parsed && (dates ? days * TypedValues::MICROS_PER_DAY : micros) <= cutoff) {
+            cold.push_back(p);
+        }
+    }
+    return cold;
+}
+void Table::coolPartition(size_t partition,
+                          const std::function<std::shared_ptr<const TableSegment>(const Table&)>& spill) {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    if (partition >= partitionTables.size()) {
+        return;
+    }
+    Table& child = *partitionTables[partition];
+    {
+        std::unique_lock<std::shared_mutex> childLock(child.mutex);
+        child.packRows();
+        if (child.segment || !child.rowArena || !child.rows.empty()) {
+            return;
+        }
+    }
+    std::shared_ptr<const TableSegment> cold = spill(child);
+    
+    std::unique_lock<std::shared_mutex> childLock(child.mutex);
+    std::vector<uint64_t> ids;
+    ids.reserve(child.rowArena->getRowCount());
+    for (size_t slot = 0; slot < child.rowArena->getSlotCount(); ++slot) {
+        if (child.rowArena->isLive(slot)) {
+            ids.push_back(child.rowArena->rowId(slot));
+        }
+    }
+    if (!cold || cold->getRowCount() != ids.size()) {
+        throw DatabaseException("Partition '" + partitions[partition].name + "' of table '" + tableName +
+                                "' did not spill whole");
+    }
+    // The rows, and so the parent's partition zone, stay the same
+    child.rowArena.reset();
+    child.clusteredSlots = 0;
+    child.packed = false;
+    child.segment = std::move(cold);
+    child.segmentIds = std::move(ids);
+    child.mapped = true;
+    std::lock_guard<std::mutex> zoneLock(child.zoneMutex);
+    child.rowZones.clear();
+    child.zonedRows = 0;
+}
+bool Table::isPartitionCold(size_t partition) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return partition < partitionTables.size() && partitionTables[partition]->segment != nullptr;
+}
+void Table::touchPartition(size_t partition) const {
+    partitionTables[partition]->lastAccess = steadySeconds();
+}
+void Table::warmPartition(size_t partition) const {
+    touchPartition(partition);
+    Table& child = *partitionTables[partition];
+    if (!child.segment) {
+        return;
+    }
+    child.materializeSegment();
+    std::unique_lock<std::shared_mutex> childLock(child.mutex);
+    child.packRows();
+}
+bool Table::coldPartitionMatches(size_t partition, const ConditionExpression& condition) const {
+    const Table& child = *partitionTables[partition];
+    if (!child.segment) {
+        return true;
+    }
+    bool matched = false;
+    child.forEachCandidateRow(condition, [&](const RowView& row) {
+        matched = matched || condition.evaluate(row, columns);
+    });
+    return matched;
+}
+// Clustered Storage
+// -----------------
+// Rows past the ordered run that make a clustered table sort them in; the
+// run must have grown by an eighth first, so sorting stays amortized
+static const size_t CLUSTER_TAIL_ROWS = 4096;
+// A cluster key cell, compared as a number when both cells read as numbers
+// (dates and times stay text), as ORDER BY compares them
+struct ClusterKeyCell {
+    std::string_view text;
+    double number = 0;
+    bool numeric = false;
+};
+static void readClusterKey(const RowArena& arena, size_t slot, const std::vector<size_t>& keyColumns,
+                           ClusterKeyCell* key) {
+    for (size_t i = 0; i < keyColumns.size(); ++i) {
+        key[i].text = arena.cell(slot, keyColumns[i]);
+        key[i].numeric = !TypedValues::isTemporal(key[i].text) && ZoneMaps::parseNumber(key[i].text, key[i].number);
+    }
+}
+static bool clusterKeyLess(const ClusterKeyCell* a, const ClusterKeyCell* b, size_t length) {
+    for (size_t i = 0; i < length; ++i) {
+        if (a[i].numeric && b[i].numeric) {
+            if (a[i].number != b[i].number) {
+                return a[i].number < b[i].number;
+            }
+        } else if (a[i].text != b[i].text) {
+            return a[i].text < b[i].text;
+        }
+    }
+    return false;
+}
+bool Table::clusterTailFull() const {
+    size_t slotCount = rowArena ? rowArena->getSlotCount() : 0;
+    return slotCount - clusteredSlots > std::max(CLUSTER_TAIL_ROWS, clusteredSlots / 8);
+}
+void Table::clusterRows(bool mayReorder) const {
+    size_t slotCount = rowArena ? rowArena->getSlotCount() : 0;
+    clusteredSlots = std::min(clusteredSlots, slotCount);
+    std::vector<size_t> keyColumns;
+    for (const auto& column : clusterColumns) {
+        keyColumns.push_back(std::distance(columns.begin(), std::find(columns.begin(), columns.end(), column)));
+    }
+    size_t width = keyColumns.size();
+    
+    // Appended rows that continue the order just join the run. Dead rows in
+    // the run still hold ordered keys, but the cell-less slots padding a
+    // chunk have none and are passed over.
+    std::vector<ClusterKeyCell> previous(width), next(width);
+    bool havePrevious = false;
+    for (size_t slot = clusteredSlots; slot > 0 && clusteredSlots < slotCount; --slot) {
+        if (rowArena->cellCount(slot - 1) != 0) {
+            readClusterKey(*rowArena, slot - 1, keyColumns, previous.data());
+            havePrevious = true;
+            break;
+        }
+    }
+    for (; clusteredSlots < slotCount; ++clusteredSlots) {
+        if (!rowArena->isLive(clusteredSlots)) {
+            continue;
+        }
+        readClusterKey(*rowArena, clusteredSlots, keyColumns, next.data());
+        if (havePrevious && clusterKeyLess(next.data(), previous.data(), width)) {
+            break;
+        }
+        std::swap(previous, next);
+        havePrevious = true;
+    }
+    if (!mayReorder || clusteredSlots == slotCount) {
+        return;
+    }
+    
+    // Sort the live rows after the run and merge them with the run's live rows
+    std::vector<ClusterKeyCell> keys(slotCount * width);
+    std::vector<size_t> run, tail;
+    for (size_t slot = 0; slot < slotCount; ++slot) {
+        if (rowArena->isLive(slot)) {
+            readClusterKey(*rowArena, slot, keyColumns, &keys[slot * width]);
+            (slot < clusteredSlots ? run : tail).push_back(slot);
+        }
+    }
+    auto less = [&](size_t a, size_t b) {
+        return clusterKeyLess(&keys[a * width], &keys[b * width], width);
+    };
+    std::stable_sort(tail.begin(), tail.end(), less);
+    std::vector<size_t> order;
+    order.reserve(run.size() + tail.size());
+    std::merge(run.begin(), run.end(), tail.begin(), tail.end(), std::back_inserter(order), less);
+    rowArena->reorder(order);
+    clusteredSlots = rowArena->getSlotCount();
+    
+    std::lock_guard<std::mutex> zoneLock(zoneMutex);
+    rowZones.clear();
+    zonedRows = 0;
+}
+// Row IDs and Compaction
+// ----------------------
+bool Table::needsCompaction() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    for (const auto& child : partitionTables) {
+        if (child->needsCompaction()) {
+            return true;
+        }
+    }
+    return rowArena && rowArena->needsCompaction();
+}
+void Table::compactRows(bool anyDeleted) {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    for (const auto& child : partitionTables) {
+        child->compactRows(anyDeleted);
+    }
+    if (!rowArena || !(anyDeleted || rowArena->needsCompaction())) {
+        return;
+    }
+    // Compaction keeps the slot order, so the ordered run keeps its live rows
+    size_t orderedLive = 0;
+    for (size_t slot = 0; slot < clusteredSlots; ++slot) {
+        orderedLive += rowArena->isLive(slot);
+    }
+    rowArena->compact();
+    clusteredSlots = orderedLive;
+    // Same rows and IDs, but in new slots
+    std::lock_guard<std::mutex> zoneLock(zoneMutex);
+    rowZones.clear();
+    zonedRows = 0;
+}
+// selectRows() over a packed store: only the selected cells of the displayed
+// columns are ever turned into text
+std::vector<std::vector<std::string>> Table::selectFromColumns(const std::vector<std::string>& displayColumns,
+                                                               bool useAllColumns,
+                                                               const std::string& condition,
+                                                               const std::vector<std::string>& groupByColumns,
+                                                               const std::string& havingCondition) {
+    const ColumnStore& store = *columnStore;
+    std::vector<uint8_t> matches;
+    if (!condition.empty()) {
+        try {
+            ConditionParser cp(condition);
+            auto expr = cp.parse();
+            selectPackedRows(*expr, matches);
+        } catch (const std::exception& e) {
+            throw DatabaseException("Error evaluating condition: " + std::string(e.what()));
+        }
+    }
+    std::vector<size_t> selected;
+    for (size_t r = 0; r < store.getRowCount(); ++r) {
+        if (matches.empty() || matches[r]) {
+            selected.push_back(r);
+        }
+    }
+    
+    if (!groupByColumns.empty()) {
+        // Groups form on dictionary codes and typed values; aggregates the
+        // store can compute are computed for all groups in one pass
+        std::vector<uint32_t> groupOf;
+        GroupedRows groups;
+        groups.groupCount = store.groupRows(groupColumnIndexes(groupByColumns), matches, groupOf);
+        groups.sizes.assign(groups.groupCount, 0);
+        std::vector<size_t> firstRows(groups.groupCount);
+        for (size_t r : selected) {
+            if (groups.sizes[groupOf[r]]++ == 0) {
+                firstRows[groupOf[r]] = r;
+            }
+        }
+        char cellBuffer[ColumnStore::CELL_BUFFER_BYTES];
+        groups.firstCell = [&](size_t group, size_t column) {
+            return std::string(store.cell(firstRows[group], column, cellBuffer));
+        };
+        groups.memberCells = [&](size_t column, std::vector<std::vector<std::string>>& cells) {
+            cells.assign(groups.groupCount, {});
+            for (size_t r : selected) {
+                cells[groupOf[r]].emplace_back(store.cell(r, column, cellBuffer));
+            }
+        };
+        groups.aggregate = [&](const std::string& function, size_t column, std::vector<std::string>& results) {
+            return store.aggregateGroups(function, column, groupOf, groups.groupCount, results);
+        };
+        return groupResult(displayColumns, havingCondition, groups);
+    }
+    
+    std::vector<int> displayIndexes;
+    bool hasAggregates = false;
+    for (const auto& col : displayColumns) {
+        auto colIt = std::find(columns.begin(), columns.end(), col);
+        displayIndexes.push_back(colIt != columns.end() ? std::distance(columns.begin(), colIt) : -1);
+        if (col.find('(') != std::string::npos && col.find(')') != std::string::npos) {
+            hasAggregates = true;
+        }
+    }
+    
+    std::vector<std::vector<std::string>> result;
+    char buffer[ColumnStore::CELL_BUFFER_BYTES];
+    if (hasAggregates) {
+        // One row, as selectRows() builds it from row vectors
+        std::vector<std::string> resultRow;
+        for (size_t i = 0; i < displayColumns.size(); ++i) {
+            const std::string& col = displayColumns[i];
+            size_t pos1 = col.find('(');
+            size_t pos2 = col.find(')');
+            if (pos1 == std::string::npos || pos2 == std::string::npos) {
+                resultRow.emplace_back(displayIndexes[i] >= 0 && !selected.empty()
+                                           ? store.cell(selected[0], displayIndexes[i], buffer)
+                                           : std::string_view());
+                continue;
+            }
+            
+            std::string func = toUpperCase(trim(col.substr(0, pos1)));
+            std::string colName = trim(col.substr(pos1 + 1, pos2 - pos1 - 1));
+            if (colName == "*" && func == "COUNT") {
+                resultRow.push_back(std::to_string(selected.size()));
+                continue;
+            }
+            auto colIt = std::find(columns.begin(), columns.end(), colName);
+            if (colIt == columns.end()) {
+                resultRow.push_back("");
+                continue;
+            }
+            size_t colIdx = std::distance(columns.begin(), colIt);
+            std::string value;
+            if (!store.aggregate(func, colIdx, matches, value)) {
+                std::vector<std::string> colValues;
+                colValues.reserve(selected.size());
+                for (size_t r : selected) {
+                    colValues.emplace_back(store.cell(r, colIdx, buffer));
+                }
+                value = applyAggregateFunction(func, colValues);
+            }
+            resultRow.push_back(std::move(value));
+        }
+        result.push_back(std::move(resultRow));
+        return result;
+    }
+    
+    result.reserve(selected.size());
+    for (size_t r : selected) {
+        std::vector<std::string>& resultRow = result.emplace_back();
+        if (useAllColumns) {
+            resultRow.reserve(columns.size());
+            for (size_t c = 0; c < columns.size(); ++c) {
+                resultRow.emplace_back(store.cell(r, c, buffer));
+            }
+            continue;
+        }
+        resultRow.reserve(displayIndexes.size());
+        for (int index : displayIndexes) {
+            resultRow.emplace_back(index >= 0 ? store.cell(r, index, buffer) : std::string_view());
+        }
+    }
+    return result;
+}
+// Change Tracking
+// ---------------
+void Table::noteAppend() {
+    version = ++versionClock;
+}
+void Table::noteRewrite() {
+    uint64_t next = ++versionClock;
+    version = next;
+    rewriteVersion = next;
+}
+void Table::keepVersionsOf(const Table& source) {
+    version = source.version.load();
+    rewriteVersion = source.rewriteVersion.load();
+}
+// Deferred Loading
+// ----------------
+void Table::deferRows(const std::string& sourceFile, std::function<void(Table&)> loader) {
+    std::lock_guard<std::mutex> guard(loadMutex);
+    deferredSource = sourceFile;
+    rowLoader = std::move(loader);
+    rowsPending = true;
+    noteRewrite();
+}
+void Table::ensureRowsLoaded() const {
+    if (!rowsPending) {
+        return;
+    }
+    std::lock_guard<std::mutex> guard(loadMutex);
+    if (!rowsPending) {
+        return;
+    }
+    // Logically const: the rows were part of the table all along
+    Table& self = const_cast<Table&>(*this);
+    self.rowLoader(self);
+    self.rowLoader = nullptr;
+    rowsPending = false;
+}
+void Table::adoptRows(Table& source) {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    std::unique_lock<std::shared_mutex> sourceLock(source.mutex);
+    rows = std::move(source.rows);
+    rowIds = std::move(source.rowIds);
+    segment = std::move(source.segment);
+    segmentIds = std::move(source.segmentIds);
+    deltaSegments = std::move(source.deltaSegments);
+    rowArena = std::move(source.rowArena);
+    clusteredSlots = source.clusteredSlots;
+    source.clusteredSlots = 0;
+    columnStore = std::move(source.columnStore);
+    partitionTables = std::move(source.partitionTables);
+    partitionZones = std::move(source.partitionZones);
+    packed = source.packed.load();
+    source.packed = false;
+    {
+        std::lock_guard<std::mutex> zoneLock(zoneMutex);
+        rowZones.clear();
+        zonedRows = 0;
+    }
+    mapped = segment != nullptr;
+    source.mapped = false;
+    nextRowId = source.nextRowId;
+}
+// Snapshots
+// ---------
+std::unique_ptr<Table> Table::snapshot() const {
+    auto copy = std::make_unique<Table>(tableName);
+    for (size_t i = 0; i < columns.size(); ++i) {
+        copy->addColumn(columns[i], columnTypes[i], notNullConstraints[i]);
+    }
+    copy->setStorageMode(storageMode, clusterColumns);
+    if (isPartitioned()) {
+        copy->setPartitioning(partitionKind, partitionColumn, partitions);
+    }
+    copy->copyRowsFrom(*this);
+    return copy;
+}
+void Table::copyRowsFrom(const Table& source) {
+    clearRows();
+    // Unloaded and mapped rows are backed by immutable files. The loader is
+    // read under the source's load lock, as a concurrent first access may be
+    // running it and clearing it.
+    {
+        std::lock_guard<std::mutex> sourceGuard(source.loadMutex);
+        if (source.rowsPending) {
+            std::lock_guard<std::mutex> guard(loadMutex);
+            deferredSource = source.deferredSource;
+            rowLoader = source.rowLoader;
+            rowsPending = true;
+            keepVersionsOf(source);
+            return;
+        }
+    }
+    if (source.isMapped()) {
+        attachSegment(source.segment);
+        std::shared_lock<std::shared_mutex> sourceLock(source.mutex);
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        deltaSegments = source.deltaSegments;
+        rows = source.rows;
+        rowIds = source.rowIds;
+        nextRowId = source.nextRowId;
+        keepVersionsOf(source);
+        return;
+    }
+    
+    std::shared_lock<std::shared_mutex> sourceLock(source.mutex);
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    bool sameLayout = source.packed && source.rows.empty() && storageMode == source.storageMode &&
+                      clusterColumns == source.clusterColumns && partitionKind == source.partitionKind &&
+                      partitionColumn == source.partitionColumn && partitions.size() == source.partitions.size();
+    for (size_t p = 0; sameLayout && p < partitions.size(); ++p) {
+        sameLayout = partitions[p].name == source.partitions[p].name &&
+                     partitions[p].values == source.partitions[p].values;
+    }
+    if (sameLayout) {
+        if (source.rowArena) {
+            rowArena = std::make_unique<RowArena>(*source.rowArena);
+        }
+        if (source.columnStore) {
+            columnStore = std::make_unique<ColumnStore>(*source.columnStore);
+        }
+        for (size_t p = 0; p < partitionTables.size(); ++p) {
+            const Table& child = *source.partitionTables[p];
+            Table& copy = *partitionTables[p];
+            if (child.rowArena) {
+                copy.rowArena = std::make_unique<RowArena>(*child.rowArena);
+                copy.packed = true;
+            }
+            // A cold partition's file is immutable, so the copy reads it too
+            if (child.segment) {
+                copy.segment = child.segment;
+                copy.segmentIds = child.segmentIds;
+                copy.mapped = true;
+            }
+            copy.nextRowId = child.nextRowId;
+        }
+        partitionZones = source.partitionZones;
+        clusteredSlots = source.clusteredSlots;
+        nextRowId = source.nextRowId;
+        packed = true;
+        keepVersionsOf(source);
+        return;
+    }
+    lock.unlock();
+    sourceLock.unlock();
+    
+    RowArena copied;
+    source.forEachRow([&](const RowView& row) {
+        copied.append(row);
+    });
+    bulkLoadRows(std::move(copied), false);
+    keepVersionsOf(source);
+}
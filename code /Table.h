@@ -6,12 +6,19 @@
 #include <unordered_map>
 #include <unordered_set>
 #include <functional>
+#include <memory>
+#include <atomic>
 #include <mutex>
 #include <shared_mutex>
 #include "Utils.h"
+#include "ConditionParser.h"
+#include "ZoneMap.h"
 
 // Forward declaration
 class ForeignKeyValidator;
+class TableSegment;
+class ColumnStore;
+class RowArena;
 
 // Structure to store table constraints
 struct Constraint {
@@ -39,15 +46,69 @@ class Table {
 public:
     // Direct row addition (bypass validation)
     void addRowDirect(const std::vector<std::string>& values) {
+        materializeSegmentOnly();
         std::unique_lock<std::shared_mutex> lock(mutex);
-        rows.push_back(values);
-        nextRowId++;
+        appendRow(values);
+        noteAppend();
     }
     
     // Add this to the public section of the Table class declaration
     std::string applyAggregateFunction(const std::string& function, const std::vector<std::string>& values);
     Table(const std::string& name);
-    virtual ~Table() = default;
+    virtual ~Table();
+    
+    // In-memory layout of the rows: packed one after another in a row arena,
+    // or typed arrays per column (CREATE TABLE ... WITH (storage = column)).
+    // CLUSTERED keeps the row arena ordered by a key, the PRIMARY KEY unless
+    // clusterKey names other columns, so key range scans read contiguous
+    // blocks and ORDER BY on the key finds its rows already sorted.
+    enum class StorageMode { ROW, COLUMN, CLUSTERED };
+    void setStorageMode(StorageMode mode, const std::vector<std::string>& clusterKey = {});
+    StorageMode getStorageMode() const { return storageMode; }
+    const std::vector<std::string>& getClusterColumns() const { return clusterColumns; }
+    static std::string storageModeName(StorageMode mode);
+    
+    // Partitioning (CREATE TABLE ... PARTITION BY RANGE|LIST|HASH (column)):
+    // the rows live in one child row store per partition, chosen by the
+    // partition column. Scans, DELETE and UPDATE skip partitions whose rows
+    // cannot match the condition, and dropping a partition releases its rows
+    // without touching the others. Partitioned tables use row storage.
+    // RANGE partitioning sorts NULL keys first: their rows live in the lowest
+    // partition and are dropped with it.
+    enum class PartitionKind { NONE, RANGE, LIST, HASH };
+    struct Partition {
+        std::string name;
+        // RANGE: the exclusive upper bound, or none for MAXVALUE; LIST: the
+        // values; HASH: none
+        std::vector<std::string> values;
+    };
+    void setPartitioning(PartitionKind kind, const std::string& columnName, const std::vector<Partition>& partitions);
+    void addPartition(const Partition& partition);
+    // Returns the rows dropped with the partition
+    size_t dropPartition(const std::string& partitionName);
+    PartitionKind getPartitionKind() const { return partitionKind; }
+    bool isPartitioned() const { return partitionKind != PartitionKind::NONE; }
+    const std::string& getPartitionColumn() const { return partitionColumn; }
+    const std::vector<Partition>& getPartitions() const { return partitions; }
+    static std::string partitionKindName(PartitionKind kind);
+    
+    // Tiering (ALTER TABLE ... SET COLD AFTER n DAYS|SECONDS): partitions the
+    // cold policy selects move out of memory into compressed table files and
+    // are scanned there in place. AGE selects RANGE partitions on a DATE or
+    // TIMESTAMP column whose upper bound lies coldAfter days or more in the
+    // past; IDLE selects partitions no statement has read or written for
+    // coldAfter seconds. Writes bring a cold partition back
+    // into memory, keeping its row IDs.
+    enum class ColdPolicy { NONE, AGE, IDLE };
+    void setColdPolicy(ColdPolicy policy, uint32_t after);
+    ColdPolicy getColdPolicy() const { return coldPolicy; }
+    uint32_t getColdAfter() const { return coldAfter; }
+    // In-memory partitions holding rows that the policy selects as of now
+    std::vector<size_t> findColdPartitions() const;
+    // Moves the partition's rows to the segment that spill writes them to
+    void coolPartition(size_t partition,
+                       const std::function<std::shared_ptr<const TableSegment>(const Table&)>& spill);
+    bool isPartitionCold(size_t partition) const;
     
     // Schema operations
     void addColumn(const std::string& columnName, const std::string& type, bool isNotNull = false);
@@ -63,6 +124,16 @@ public:
     // DML operations
     int addRow(const std::vector<std::string>& values);
     int addRowWithId(int rowId, const std::vector<std::string>& values);
+    // Trusted bulk append for rows that were validated when first written
+    // (restoring a table file or a transaction backup). Skips type enforcement
+    // and per-row constraint checks; with verify set, one hashing pass over
+    // the appended rows checks row width, NOT NULL, PRIMARY KEY and UNIQUE.
+    void bulkLoadRows(std::vector<std::vector<std::string>>&& newRows, bool verify = true);
+    // Same for rows already packed into an arena; an empty ROW table takes
+    // the arena over without copying a cell
+    void bulkLoadRows(RowArena&& newRows, bool verify = true);
+    // Checks the rows from firstNew on; caller holds the table lock
+    void verifyLoadedRows(size_t firstNew = 0) const;
     std::vector<std::vector<std::string>> selectRows(
         const std::vector<std::string>& selectColumns,
         const std::string& condition = "",
@@ -70,10 +141,22 @@ public:
         const std::vector<std::string>& groupByColumns = {},
         const std::string& havingCondition = "");
     void printTable();
+    // Rows of a ROW table are only marked deleted; their space comes back
+    // when the checkpointer compacts the table
     void deleteRows(const std::string& condition);
     void updateRows(const std::vector<std::pair<std::string, std::string>>& updates,
                     const std::string& condition);
     void clearRows();
+    // Replaces every row for which rewrite returns true by the newRow it
+    // sets, in place like UPDATE but without constraint checks, for REPLACE
+    // and MERGE. A row that moves to another partition takes a fresh ID.
+    using RowRewrite = std::function<bool(const RowView& row, std::vector<std::string>& newRow)>;
+    void rewriteRows(const RowRewrite& rewrite);
+    
+    // Tombstone compaction, run by the checkpointer once deleted rows pile
+    // up, or for any deleted row when anyDeleted is set
+    bool needsCompaction() const;
+    void compactRows(bool anyDeleted = false);
     
     // Join operations
     std::vector<std::vector<std::string>> innerJoin(
@@ -112,10 +195,86 @@ public:
     const std::vector<std::string>& getColumns() const { return columns; }
     const std::vector<std::string>& getColumnTypes() const { return columnTypes; }
     const std::vector<bool>& getNotNullConstraints() const { return notNullConstraints; }
-    const std::vector<std::vector<std::string>>& getRows() const { return rows; }
-    std::vector<std::vector<std::string>>& getRowsNonConst() { return rows; }
+    const std::vector<std::vector<std::string>>& getRows() const;
     const std::vector<Constraint>& getConstraints() const { return constraints; }
     
+    // Columns that get a Bloom filter in every stored block, in addition to
+    // the primary key columns
+    void addBloomFilter(const std::string& columnName);
+    bool dropBloomFilter(const std::string& columnName);
+    const std::vector<std::string>& getBloomFilterColumns() const { return bloomColumns; }
+    // Indexes of the primary key and Bloom filter columns
+    std::vector<size_t> getKeyColumnIndexes() const;
+    
+    // Memory-mapped storage. While a segment is attached it holds the rows,
+    // followed by those of mapped delta files and then any unmapped tail in
+    // rows, and scans read it in place; any other access copies it into
+    // rows first.
+    void attachSegment(std::shared_ptr<const TableSegment> mappedSegment);
+    // Appends the rows of a checkpoint delta file. A mapped table stays
+    // mapped: a mapped delta joins its segments and an unmapped one becomes
+    // the tail. Otherwise the rows are bulk loaded.
+    void appendDelta(Table& delta, bool verifyRows);
+    bool isMapped() const;
+    void materializeSegment() const;
+    // Visits every row without materializing a mapped segment or unpacking
+    // a column store
+    void forEachRow(const std::function<void(const RowView&)>& visitor) const;
+    
+    // Packed storage. The rows of a ROW table live in a row arena and those
+    // of a COLUMN table in a column store; inserts, deletes, updates of an
+    // arena, scans, filters and aggregates use either directly. Any access
+    // that needs row vectors (getRows(), joins, UPDATE of a column store)
+    // unpacks them into rows; the next write through the table packs them
+    // again.
+    bool isPacked() const { return packed; }
+    // Bytes held by the row arena or column store; 0 while unpacked
+    size_t getPackedBytes() const;
+    
+    // Memory accounting. Payload is the cell bytes of the live rows, wherever
+    // they are kept; the other fields are bytes the table holds in memory.
+    // Rows of a mapped segment stay in the page cache or buffer pool, so only
+    // their zones count here.
+    struct MemoryStats {
+        size_t rowCount = 0;
+        size_t payloadBytes = 0;
+        size_t storeBytes = 0;    // row arena or column store
+        size_t heapBytes = 0;     // unpacked row vectors and their strings
+        size_t indexBytes = 0;    // zone maps, Bloom filters and row ID maps
+        size_t sharedBytes = 0;   // part of storeBytes shared with a snapshot
+        size_t total() const { return storeBytes + heapBytes + indexBytes; }
+    };
+    // Scans the rows for their payload; a table whose rows are not loaded
+    // yet reports nothing rather than loading them
+    MemoryStats getMemoryStats() const;
+    
+    // Deferred loading. A lazily opened table only knows its schema; loader
+    // reads the rows from sourceFile on first access.
+    void deferRows(const std::string& sourceFile, std::function<void(Table&)> loader);
+    bool isLoaded() const { return !rowsPending; }
+    const std::string& getDeferredSource() const { return deferredSource; }
+    void ensureRowsLoaded() const;
+    // Takes over the rows (or mapped segment) of a freshly loaded copy
+    void adoptRows(Table& source);
+    
+    // Snapshots. Copies share the chunks of the row arenas, so taking one
+    // costs a pointer per chunk; a chunk is copied once either table writes
+    // to it. Column stores are copied as they are.
+    // Copy of the columns, storage layout and rows, without constraints
+    std::unique_ptr<Table> snapshot() const;
+    // Replaces the rows with those of source, sharing its chunks when both
+    // tables lay out rows alike and copying them row by row otherwise. The
+    // copy takes over source's versions, so restoring a rollback snapshot
+    // leaves the next checkpoint nothing to write.
+    void copyRowsFrom(const Table& source);
+    
+    // Change tracking for incremental checkpoints. Versions come from one
+    // process-wide clock, so they never repeat across tables; only a copy of
+    // a table's rows shares its versions. Appending rows moves only the
+    // version; every other change moves the rewrite version too.
+    uint64_t getVersion() const { return version; }
+    uint64_t getRewriteVersion() const { return rewriteVersion; }
+    
     // Transaction support
     void lockShared();
     void lockExclusive();
@@ -130,9 +289,159 @@ private:
     std::vector<std::string> columns;
     std::vector<std::string> columnTypes;
     std::vector<bool> notNullConstraints;
-    std::vector<std::vector<std::string>> rows;
+    mutable std::vector<std::vector<std::string>> rows;
+    // IDs of the unpacked rows when they came out of the arena (or were
+    // appended since) in order, so packing them again keeps the IDs; empty
+    // when unknown, and then packing gives the rows fresh IDs
+    mutable std::vector<uint64_t> rowIds;
+    mutable std::shared_ptr<const TableSegment> segment;
+    // IDs of the segment's rows when they are known (those of a cold
+    // partition), so materializing it keeps them; empty otherwise
+    mutable std::vector<uint64_t> segmentIds;
+    // Mapped delta files, whose rows follow the segment's
+    mutable std::vector<std::shared_ptr<const TableSegment>> deltaSegments;
+    void forEachSegment(const std::function<void(const TableSegment&)>& visitor) const;
+    // Lets materializeSegment() return without locking once nothing is mapped,
+    // so callers that already hold the table lock can still reach getRows()
+    mutable std::atomic<bool> mapped{false};
+    StorageMode storageMode = StorageMode::ROW;
+    // Hold every row while packed, the arena for ROW tables and the column
+    // store for COLUMN tables, or the partitions. A COLUMN or partitioned
+    // table is never mapped, since attaching a segment packs it right away.
+    mutable std::unique_ptr<RowArena> rowArena;
+    mutable std::unique_ptr<ColumnStore> columnStore;
+    mutable std::atomic<bool> packed{false};
+    // CLUSTERED tables: the arena's first clusteredSlots slots are in key
+    // order, and rows appended out of order wait after them until
+    // clusterRows() merges them in
+    std::vector<std::string> clusterColumns;
+    mutable size_t clusteredSlots = 0;
+    // Extends the ordered run over appended slots that continue it; with
+    // mayReorder, then sorts the remaining ones into it. Reordering moves
+    // rows, so the caller must have noted a rewrite.
+    void clusterRows(bool mayReorder) const;
+    bool clusterTailFull() const;
+    // Copies a mapped segment into rows but leaves a packed store in place,
+    // for the paths that work on the store directly
+    void materializeSegmentOnly() const;
+    // Caller holds the table lock exclusively
+    void packRows() const;
+    void unpackRows() const;
+    void appendRow(const std::vector<std::string>& row);
+    // Rows of the arena or column store, in order
+    void forEachPackedRow(const std::function<void(const RowView&)>& visitor) const;
+    // In-memory rows, the arena's slots followed by any unpacked rows, and the
+    // live ones in [first, end) of them; the caller holds the table lock
+    size_t memoryRowCount() const;
+    void visitMemoryRows(size_t first, size_t end, const std::function<void(const RowView&)>& visitor) const;
+    // Counts, verifies and packs the in-memory rows from firstNew on after
+    // a bulk load; the caller holds the table lock
+    void finishBulkLoad(size_t firstNew, bool verify);
+    // Partitions, each a ROW child table holding the partition's rows while
+    // the table is packed, with a zone over its partition column cells
+    PartitionKind partitionKind = PartitionKind::NONE;
+    std::string partitionColumn;
+    std::vector<Partition> partitions;
+    mutable std::vector<std::unique_ptr<Table>> partitionTables;
+    mutable std::vector<BlockZone> partitionZones;
+    std::unordered_map<std::string, size_t> listPartitionOf;
+    std::unique_ptr<Table> makePartitionTable(const std::string& partitionName) const;
+    // Empty child tables and zones for every partition
+    void resetPartitions() const;
+    void rebuildListPartitions();
+    // Range bounds ascend with MAXVALUE only last, list values appear once
+    void checkPartitions(PartitionKind kind, const std::vector<Partition>& candidate) const;
+    size_t partitionKeyIndex() const;
+    // Partition a row belongs to; throws if none takes it
+    size_t partitionOf(const RowView& row) const;
+    void appendToPartition(const std::vector<std::string>& row, uint64_t id) const;
+    bool partitionCanMatch(size_t partition, const ConditionExpression& condition) const;
+    // Cold partitions. touchPartition() records an access for the IDLE
+    // policy; warmPartition() reads a cold partition back into its arena and
+    // needs the table lock held exclusively.
+    ColdPolicy coldPolicy = ColdPolicy::NONE;
+    uint32_t coldAfter = 0;
+    mutable std::atomic<int64_t> lastAccess{0};   // steady-clock seconds
+    void touchPartition(size_t partition) const;
+    void warmPartition(size_t partition) const;
+    // False only for a cold partition without a row the condition matches,
+    // which a write can then leave cold
+    bool coldPartitionMatches(size_t partition, const ConditionExpression& condition) const;
+    // Partition rows in row ID order, which is insertion order
+    void forEachPartitionRow(const std::function<void(uint64_t id, const RowView&)>& visitor) const;
+    // UPDATE can work partition by partition: no row changes partition and
+    // no PRIMARY KEY or UNIQUE column changes
+    bool updateKeepsPartitions(const std::vector<std::pair<std::string, std::string>>& updates) const;
+    void updateMatchingRows(std::vector<std::vector<std::string>>& target,
+                            const std::vector<std::pair<std::string, std::string>>& updates,
+                            const ConditionExpression* condition);
+    // Rewrites owner's arena (this table's or partition's) slot by slot, so
+    // only the chunks holding changed rows are copied from a snapshot, and
+    // returns the number of rows changed. With leaving, rows that now belong
+    // to another partition are erased and handed over.
+    size_t rewriteArenaRows(Table& owner, const RowRewrite& rewrite, size_t partition,
+                            std::vector<std::vector<std::string>>* leaving);
+    // Sets newRow to row under updates; false if no cell changes. A changed
+    // row is checked against the constraints.
+    bool updatedRow(const std::vector<std::string>& row,
+                    const std::vector<std::pair<std::string, std::string>>& updates,
+                    std::vector<std::string>& newRow);
+    
+    // Rows of the packed store that satisfy condition
+    void selectPackedRows(const ConditionExpression& condition, std::vector<uint8_t>& matches) const;
+    std::vector<std::vector<std::string>> selectFromColumns(const std::vector<std::string>& displayColumns,
+                                                            bool useAllColumns,
+                                                            const std::string& condition,
+                                                            const std::vector<std::string>& groupByColumns,
+                                                            const std::string& havingCondition);
+    
+    // GROUP BY output over groups numbered 0..groupCount-1, read through
+    // callbacks so row vectors and the column store share it
+    struct GroupedRows {
+        size_t groupCount = 0;
+        std::vector<size_t> sizes;
+        // Cell of column in the first row of group
+        std::function<std::string(size_t group, size_t column)> firstCell;
+        // Cells of column in every row, per group
+        std::function<void(size_t column, std::vector<std::vector<std::string>>& cells)> memberCells;
+        // Optional: function over column for every group at once; false to
+        // fall back to memberCells
+        std::function<bool(const std::string& function, size_t column, std::vector<std::string>& results)> aggregate;
+    };
+    std::vector<size_t> groupColumnIndexes(const std::vector<std::string>& groupByColumns) const;
+    std::vector<std::vector<std::string>> groupResult(const std::vector<std::string>& displayColumns,
+                                                      const std::string& havingCondition,
+                                                      const GroupedRows& groups);
+    
+    // Deferred loading state; deferredSource never changes once set, so the
+    // checkpointer can read it while another thread loads the rows
+    mutable std::atomic<bool> rowsPending{false};
+    mutable std::mutex loadMutex;
+    std::string deferredSource;
+    std::function<void(Table&)> rowLoader;
     std::vector<Constraint> constraints;
-    int nextRowId = 1;
+    std::vector<std::string> bloomColumns;
+    // Next row ID; IDs handed out are never reused
+    mutable uint64_t nextRowId = 1;
+    std::atomic<uint64_t> version{0};
+    std::atomic<uint64_t> rewriteVersion{0};
+    void noteAppend();
+    void noteRewrite();
+    // A copy holding the same rows as source counts as unchanged where
+    // source does
+    void keepVersionsOf(const Table& source);
+    
+    // Zone map over rows, built by the first filtered scan that needs it and
+    // extended as rows are appended; any rewrite discards it
+    mutable std::mutex zoneMutex;
+    mutable std::vector<BlockZone> rowZones;
+    mutable uint64_t zonedRewriteVersion = 0;
+    mutable size_t zonedRows = 0;
+    void refreshRowZones() const;
+    // Visits the rows of every block the condition's zone map does not rule
+    // out; the caller holds the table lock
+    void forEachCandidateRow(const ConditionExpression& condition,
+                             const std::function<void(const RowView&)>& visitor) const;
     
     // Concurrency control
     mutable std::shared_mutex mutex;
@@ -0,0 +1,286 @@
+#include "TableSegment.h"
+#include "PageFormat.h"
+#include "Utils.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+// Reads exactly size bytes at offset
+static void readFully(int fd, char* out, size_t size, uint64_t offset, const std::string& path) {
+    size_t done = 0;
+    while (done < size) {
+        ssize_t got = ::pread(fd, out + done, size - done, static_cast<off_t>(offset + done));
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got <= 0) {
+            throw DatabaseException("Failed to read " + path);
+        }
+        done += static_cast<size_t>(got);
+    }
+}
+TableSegment::TableSegment(const std::string& filePath, std::shared_ptr<BufferPool> bufferPool)
+    : path(filePath), pool(std::move(bufferPool)) {
+    int fileFd = ::open(filePath.c_str(), O_RDONLY);
+    if (fileFd < 0) {
+        throw DatabaseException("Failed to open table file: " + filePath + " (" + std::strerror(errno) + ")");
+    }
+    struct stat info;
+    if (::fstat(fileFd, &info) != 0 || info.st_size < static_cast<off_t>(PageFormat::FILE_HEADER_SIZE)) {
+        ::close(fileFd);
+        throw DatabaseException("Table file too small: " + filePath);
+    }
+    size = static_cast<size_t>(info.st_size);
+    
+    if (!pool) {
+        void* mapping = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fileFd, 0);
+        ::close(fileFd); // The mapping keeps the file alive, even after it is unlinked
+        if (mapping == MAP_FAILED) {
+            throw DatabaseException("Failed to map table file: " + filePath + " (" + std::strerror(errno) + ")");
+        }
+        data = static_cast<const char*>(mapping);
+        ::madvise(mapping, size, MADV_SEQUENTIAL);
+    } else {
+        // The open descriptor keeps the file readable after it is unlinked
+        fd = fileFd;
+        poolFileId = pool->addFile(fd, path);
+    }
+    
+    try {
+        if (data) {
+            readHeader(data, size);
+        } else {
+            // Fixed header first, to learn how many header pages to read
+            headerData.resize(PageFormat::FILE_HEADER_SIZE);
+            readFully(fd, headerData.data(), headerData.size(), 0, path);
+            ByteReader peek(headerData.data() + 12, 8);
+            uint64_t headerBytes = static_cast<uint64_t>(peek.getU32()) * peek.getU32();
+            if (headerBytes < PageFormat::FILE_HEADER_SIZE || headerBytes > size) {
+                throw DatabaseException("Corrupt table file header");
+            }
+            headerData.resize(headerBytes);
+            readFully(fd, headerData.data(), headerData.size(), 0, path);
+            readHeader(headerData.data(), headerData.size());
+        }
+        readZones();
+    } catch (const std::exception& e) {
+        release();
+        throw DatabaseException("Error opening " + filePath + ": " + std::string(e.what()));
+    }
+}
+TableSegment::~TableSegment() {
+    release();
+}
+void TableSegment::release() {
+    if (data) {
+        ::munmap(const_cast<char*>(data), size);
+        data = nullptr;
+    }
+    if (fd >= 0) {
+        try {
+            pool->removeFile(poolFileId);
+        } catch (...) {
+            // Read-only pages are never dirty; nothing can be lost
+        }
+        ::close(fd);
+        fd = -1;
+    }
+}
+void TableSegment::readHeader(const char* header, size_t headerBytes) {
+    if (!PageFormat::hasMagic(header, headerBytes)) {
+        throw DatabaseException("Not a binary table file");
+    }
+    ByteReader fixed(header, PageFormat::FILE_HEADER_SIZE);
+    fixed.getU64(); // magic
+    version = fixed.getU32();
+    pageSize = fixed.getU32();
+    headerPages = fixed.getU32();
+    dataPages = fixed.getU32();
+    rowCount = fixed.getU64();
+    
+    if (version != PageFormat::ROW_VERSION && version != PageFormat::COLUMNAR_VERSION) {
+        throw DatabaseException("Unsupported table file version " + std::to_string(version));
+    }
+    if (pageSize < PageFormat::FILE_HEADER_SIZE + 4 || headerPages == 0 ||
+        (static_cast<uint64_t>(headerPages) + dataPages) * pageSize > size ||
+        static_cast<uint64_t>(headerPages) * pageSize > headerBytes) {
+        throw DatabaseException("Corrupt table file header");
+    }
+    
+    ByteReader schemaSizeReader(header + PageFormat::FILE_HEADER_SIZE,
+                                static_cast<size_t>(headerPages) * pageSize - PageFormat::FILE_HEADER_SIZE);
+    schemaSize = schemaSizeReader.getU32();
+    if (schemaSize > schemaSizeReader.remaining()) {
+        throw DatabaseException("Corrupt table schema block");
+    }
+    schemaData = header + PageFormat::FILE_HEADER_SIZE + 4;
+    
+    if (version == PageFormat::COLUMNAR_VERSION) {
+        ByteReader codecReader(schemaData + schemaSize, schemaSizeReader.remaining() - schemaSize);
+        uint32_t codecBytes = codecReader.getU32();
+        ByteReader codecBlock(codecReader.getBytes(codecBytes), codecBytes);
+        codecs = ColumnCodecs::read(codecBlock);
+    }
+}
+// A missing or damaged trailer only disables block skipping
+void TableSegment::readZones() {
+    uint64_t offset = (static_cast<uint64_t>(headerPages) + dataPages) * pageSize;
+    if (offset >= size) {
+        return;
+    }
+    if (data) {
+        ZoneMaps::readTrailer(data + offset, size - offset, zones);
+        return;
+    }
+    std::vector<char> trailer(size - offset);
+    readFully(fd, trailer.data(), trailer.size(), offset, path);
+    ZoneMaps::readTrailer(trailer.data(), trailer.size(), zones);
+}
+const char* TableSegment::pageRun(uint32_t page, uint32_t spanPages, BufferPool::PageRef& pin) const {
+    uint64_t offset = (static_cast<uint64_t>(headerPages) + page) * pageSize;
+    if (data) {
+        return data + offset;
+    }
+    pin = pool->fetch(poolFileId, offset, static_cast<size_t>(spanPages) * pageSize);
+    return pin.data();
+}
+uint32_t TableSegment::runSpan(uint32_t page) const {
+    auto zone = std::lower_bound(zones.begin(), zones.end(), page,
+                                 [](const BlockZone& z, uint32_t p) { return z.firstPage < p; });
+    if (zone == zones.end() || zone->firstPage != page) {
+        return 0;
+    }
+    uint32_t next = zone + 1 == zones.end() ? dataPages : (zone + 1)->firstPage;
+    return next > page && next <= dataPages ? next - page : 0;
+}
+uint32_t TableSegment::prefetchRuns(uint32_t page, uint32_t endPage) const {
+    unsigned depth = pool->getPrefetchDepth();
+    if (depth == 0) {
+        return endPage;
+    }
+    // Without zones the run boundaries are unknown; single pages still cover
+    // every run start, which is what a cursor fetches first
+    std::vector<std::pair<uint64_t, size_t>> runs;
+    while (page < endPage && runs.size() < depth) {
+        uint32_t span = runSpan(page);
+        uint32_t pages = span > 0 ? span : 1;
+        uint64_t offset = (static_cast<uint64_t>(headerPages) + page) * pageSize;
+        runs.emplace_back(offset, static_cast<size_t>(pages) * pageSize);
+        page += pages;
+    }
+    pool->prefetch(poolFileId, runs);
+    return page;
+}
+void TableSegment::appendRowsTo(std::vector<std::vector<std::string>>& rows) const {
+    rows.reserve(rows.size() + rowCount);
+    Cursor cursor(*this);
+    std::vector<std::string_view> row;
+    while (cursor.next(row)) {
+        rows.emplace_back(row.begin(), row.end());
+    }
+}
+std::vector<uint32_t> TableSegment::getPageStarts() const {
+    std::vector<uint32_t> starts;
+    uint32_t page = 0;
+    char headerBytes[PageFormat::PAGE_HEADER_SIZE];
+    while (page < dataPages) {
+        // Only the page headers are needed, so pooled files are read directly
+        uint64_t offset = (static_cast<uint64_t>(headerPages) + page) * pageSize;
+        if (data) {
+            std::memcpy(headerBytes, data + offset, sizeof(headerBytes));
+        } else {
+            readFully(fd, headerBytes, sizeof(headerBytes), offset, path);
+        }
+        ByteReader pageHeader(headerBytes, sizeof(headerBytes));
+        pageHeader.getU32(); // rows
+        pageHeader.getU32(); // payload bytes
+        uint32_t spanPages = pageHeader.getU32();
+        if (spanPages == 0 || spanPages > dataPages - page) {
+            throw DatabaseException("Corrupt data page header in " + path);
+        }
+        starts.push_back(page);
+        page += spanPages;
+    }
+    return starts;
+}
+// Cursor
+// ------
+TableSegment::Cursor::Cursor(const TableSegment& segment, uint32_t firstPage, uint32_t endPage)
+    : segment(segment), nextPage(firstPage), endPage(std::min(endPage, segment.dataPages)),
+      prefetchedTo(firstPage) {}
+bool TableSegment::Cursor::next(std::vector<std::string_view>& row) {
+    while (rowsLeft == 0) {
+        if (!loadNextPage()) {
+            return false;
+        }
+    }
+    
+    if (segment.version == PageFormat::COLUMNAR_VERSION) {
+        uint32_t index = pageRows - rowsLeft;
+        row.resize(segment.codecs.size());
+        for (size_t c = 0; c < row.size(); ++c) {
+            row[c] = decoder.cell(c, index);
+        }
+        rowsLeft--;
+        return true;
+    }
+    
+    ByteReader reader(payload + payloadPos, payloadBytes - payloadPos);
+    uint32_t cellCount = reader.getU32();
+    row.clear();
+    row.reserve(cellCount);
+    for (uint32_t c = 0; c < cellCount; ++c) {
+        row.push_back(reader.getStringView());
+    }
+    payloadPos += reader.position();
+    rowsLeft--;
+    return true;
+}
+// Pages are verified when first entered, so a scan touches each byte once
+bool TableSegment::Cursor::loadNextPage() {
+    if (nextPage >= endPage) {
+        return false;
+    }
+    
+    size_t pageSize = segment.pageSize;
+    uint32_t fetchedSpan = 1;
+    if (segment.pool) {
+        if (nextPage >= prefetchedTo) {
+            prefetchedTo = segment.prefetchRuns(nextPage, endPage);
+        }
+        // Zones give the run length, so a pooled run is fetched in one go
+        fetchedSpan = std::max<uint32_t>(segment.runSpan(nextPage), 1);
+    }
+    const char* page = segment.pageRun(nextPage, fetchedSpan, pin);
+    ByteReader pageHeader(page, PageFormat::PAGE_HEADER_SIZE);
+    uint32_t rowCount = pageHeader.getU32();
+    uint32_t bytes = pageHeader.getU32();
+    uint32_t spanPages = pageHeader.getU32();
+    uint32_t expectedChecksum = pageHeader.getU32();
+    
+    if (spanPages == 0 || nextPage + spanPages > segment.dataPages ||
+        PageFormat::PAGE_HEADER_SIZE + bytes > static_cast<size_t>(spanPages) * pageSize) {
+        throw DatabaseException("Corrupt data page header in " + segment.path);
+    }
+    if (spanPages != fetchedSpan && segment.pool) {
+        // A pooled run of several pages is fetched as one frame
+        page = segment.pageRun(nextPage, spanPages, pin);
+    }
+    payload = page + PageFormat::PAGE_HEADER_SIZE;
+    if (PageFormat::checksum(payload, bytes) != expectedChecksum) {
+        throw DatabaseException("Checksum mismatch in data page of " + segment.path);
+    }
+    
+    payloadBytes = bytes;
+    payloadPos = 0;
+    if (segment.version == PageFormat::COLUMNAR_VERSION) {
+        decoder.decode(payload, payloadBytes, rowCount, segment.codecs);
+    }
+    pageRows = rowCount;
+    rowsLeft = rowCount;
+    nextPage += spanPages;
+    return true;
+}
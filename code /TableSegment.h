@@ -0,0 +1,109 @@
+#ifndef TABLE_SEGMENT_H
+#define TABLE_SEGMENT_H
+
+#include "BufferPool.h"
+#include "ColumnEncoding.h"
+#include "ZoneMap.h"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+// Read-only binary table file whose rows are decoded in place. Checkpoint
+// files are never modified once written, so scans can decode rows into
+// string_views that point straight at the page bytes. Pages come either from
+// a memory mapping (shared page cache) or, when a buffer pool is given, from
+// that pool so the memory they take is bounded.
+class TableSegment {
+public:
+    // Opens the file and validates its header; throws DatabaseException
+    explicit TableSegment(const std::string& filePath, std::shared_ptr<BufferPool> pool = nullptr);
+    ~TableSegment();
+    
+    TableSegment(const TableSegment&) = delete;
+    TableSegment& operator=(const TableSegment&) = delete;
+    
+    const std::string& getPath() const { return path; }
+    uint64_t getRowCount() const { return rowCount; }
+    bool isPooled() const { return pool != nullptr; }
+    // Per-column encodings of a columnar file (empty for row pages)
+    const std::vector<ColumnCodec>& getColumnCodecs() const { return codecs; }
+    
+    // Min/max summary of every data page run, in file order; empty for files
+    // written without a zone trailer
+    const std::vector<BlockZone>& getZones() const { return zones; }
+    
+    // Schema block of the file header
+    const char* getSchemaData() const { return schemaData; }
+    size_t getSchemaSize() const { return schemaSize; }
+    
+    // Index of the first page of every data page run, in file order. Used to
+    // split a scan into ranges that can be decoded independently.
+    std::vector<uint32_t> getPageStarts() const;
+    
+    // Sequential reader over the rows. The views returned by next() stay
+    // valid until the following call to next() (for a mapped segment, for as
+    // long as the segment is alive).
+    class Cursor {
+    public:
+        // Reads the data pages [firstPage, endPage); firstPage must be the
+        // start of a page run
+        explicit Cursor(const TableSegment& segment, uint32_t firstPage = 0,
+                        uint32_t endPage = UINT32_MAX);
+        bool next(std::vector<std::string_view>& row);
+        
+    private:
+        const TableSegment& segment;
+        uint32_t nextPage;          // first page after the current one
+        uint32_t endPage;
+        BufferPool::PageRef pin;    // current page run of a pooled segment
+        PageDecoder decoder;        // current page of a columnar file
+        uint32_t pageRows = 0;
+        const char* payload = nullptr;
+        size_t payloadBytes = 0;
+        size_t payloadPos = 0;
+        uint32_t rowsLeft = 0;      // rows not yet read from the current page
+        uint32_t prefetchedTo;      // pooled pages before this one were read ahead
+        
+        bool loadNextPage();
+    };
+    
+    // Decodes every row into owned strings
+    void appendRowsTo(std::vector<std::vector<std::string>>& rows) const;
+
+private:
+    std::string path;
+    // Mapped mode
+    const char* data = nullptr;
+    size_t size = 0;
+    // Pooled mode
+    std::shared_ptr<BufferPool> pool;
+    int fd = -1;
+    uint64_t poolFileId = 0;
+    std::vector<char> headerData;
+    
+    uint32_t version = 0;
+    std::vector<ColumnCodec> codecs;
+    uint32_t pageSize = 0;
+    uint32_t headerPages = 0;
+    uint32_t dataPages = 0;
+    uint64_t rowCount = 0;
+    const char* schemaData = nullptr;
+    size_t schemaSize = 0;
+    std::vector<BlockZone> zones;
+    
+    void readHeader(const char* header, size_t headerBytes);
+    void readZones();
+    // Returns spanPages pages starting at data page 'page'; pooled pages stay
+    // pinned through 'pin'
+    const char* pageRun(uint32_t page, uint32_t spanPages, BufferPool::PageRef& pin) const;
+    // Pages in the run starting at page according to the zones; 0 if unknown
+    uint32_t runSpan(uint32_t page) const;
+    // Reads the runs from page on into the pool, up to its prefetch depth of
+    // them; returns the first page not read ahead
+    uint32_t prefetchRuns(uint32_t page, uint32_t endPage) const;
+    void release();
+};
+
+#endif // TABLE_SEGMENT_H
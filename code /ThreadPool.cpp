@@ -0,0 +1,93 @@
+#include "ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+ThreadPool::ThreadPool(size_t threadCount) {
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    // The caller of parallelFor works too, so one thread fewer is enough
+    for (size_t i = 1; i < threadCount; ++i) {
+        workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    taskAvailable.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+void ThreadPool::workerLoop() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            taskAvailable.wait(lock, [this]() { return stopping || !tasks.empty(); });
+            if (stopping && tasks.empty()) {
+                return;
+            }
+            task = std::move(tasks.front());
+            tasks.pop();
+        }
+        task();
+    }
+}
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& body) {
+    if (count == 0) {
+        return;
+    }
+    
+    // Indices are claimed one at a time by whoever is free; helpers that
+    // start after every index is claimed return without touching body
+    struct Job {
+        std::atomic<size_t> next{0};
+        std::atomic<size_t> finished{0};
+        std::mutex mutex;
+        std::condition_variable done;
+        std::exception_ptr error;
+    };
+    auto job = std::make_shared<Job>();
+    const std::function<void(size_t)>* bodyPtr = &body;
+    
+    auto run = [job, count, bodyPtr]() {
+        size_t index;
+        while ((index = job->next++) < count) {
+            try {
+                (*bodyPtr)(index);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(job->mutex);
+                if (!job->error) {
+                    job->error = std::current_exception();
+                }
+            }
+            if (++job->finished == count) {
+                std::lock_guard<std::mutex> lock(job->mutex);
+                job->done.notify_all();
+            }
+        }
+    };
+    
+    size_t helpers = std::min(count - 1, workers.size());
+    if (helpers > 0) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (size_t i = 0; i < helpers; ++i) {
+                tasks.push(run);
+            }
+        }
+        taskAvailable.notify_all();
+    }
+    
+    run();
+    
+    std::unique_lock<std::mutex> lock(job->mutex);
+    job->done.wait(lock, [&]() { return job->finished == count; });
+    if (job->error) {
+        std::rethrow_exception(job->error);
+    }
+}
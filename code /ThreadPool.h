@@ -0,0 +1,38 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+// Fixed set of worker threads for CPU-bound loading work
+class ThreadPool {
+public:
+    // 0 threads means one per hardware thread
+    explicit ThreadPool(size_t threadCount = 0);
+    ~ThreadPool();
+    
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    
+    size_t size() const { return workers.size(); }
+    
+    // Runs body(0) .. body(count - 1) across the pool and waits for all of
+    // them. The calling thread takes part, so nested calls from inside a
+    // body cannot deadlock. The first exception thrown by a body is rethrown.
+    void parallelFor(size_t count, const std::function<void(size_t)>& body);
+
+private:
+    std::vector<std::thread> workers;
+    std::queue<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable taskAvailable;
+    bool stopping = false;
+    
+    void workerLoop();
+};
+
+#endif // THREAD_POOL_H
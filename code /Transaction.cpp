@@ -221,7 +221,7 @@ void Transaction::saveTableState(const std::string& tableName) {
     // Create a new table state
     TableState state;
     state.tableName = tableName;
-    state.originalRows = table->getRows();
+    state.snapshot = table->snapshot();
     state.columns = table->getColumns();
     state.columnTypes = table->getColumnTypes();
     
@@ -256,17 +256,11 @@ void Transaction::restoreTableState(const std::string& tableName) {
             
             // Then restore its rows
             table = database->getTable(tableName, true);
-            table->clearRows();
-            for (const auto& row : state.originalRows) {
-                table->addRow(row);
-            }
+            table->copyRowsFrom(*state.snapshot);
         }
     } else {
-        // The table exists, so just restore its rows
-        table->clearRows();
-        for (const auto& row : state.originalRows) {
-            table->addRow(row);
-        }
+        // The table exists, so just restore its rows; they were valid before
+        table->copyRowsFrom(*state.snapshot);
     }
 }
 // Add to Transaction.cpp if needed
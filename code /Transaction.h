@@ -71,7 +71,8 @@ private:
     // Tables modified during the transaction (for rollback)
     struct TableState {
         std::string tableName;
-        std::vector<std::vector<std::string>> originalRows;
+        // Shares the table's row chunks until either side writes to them
+        std::shared_ptr<const Table> snapshot;
         std::vector<std::string> columns;
         std::vector<std::string> columnTypes;
     };
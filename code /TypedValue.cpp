@@ -0,0 +1,283 @@
+#include "TypedValue.h"
+#include <charconv>
+#include <cctype>
+#include <cstdio>
+static bool isDigit(char ch) {
+    return ch >= '0' && ch <= '9';
+}
+// Value of count digits starting at from; false if any is not a digit
+static bool readDigits(std::string_view text, size_t from, size_t count, int& value) {
+    value = 0;
+    for (size_t i = from; i < from + count; ++i) {
+        if (!isDigit(text[i])) {
+            return false;
+        }
+        value = value * 10 + (text[i] - '0');
+    }
+    return true;
+}
+static void printClock(int64_t micros, std::string& out) {
+    char text[32];
+    int64_t seconds = micros / TypedValues::MICROS_PER_SECOND;
+    std::snprintf(text, sizeof(text), "%02d:%02d:%02d", static_cast<int>(seconds / 3600),
+                  static_cast<int>(seconds / 60 % 60), static_cast<int>(seconds % 60));
+    out += text;
+    int fraction = static_cast<int>(micros % TypedValues::MICROS_PER_SECOND);
+    if (fraction != 0) {
+        std::snprintf(text, sizeof(text), ".%06d", fraction);
+        size_t length = 7;
+        while (text[length - 1] == '0') {
+            length--;
+        }
+        out.append(text, length);
+    }
+}
+// Dates and times
+// ---------------
+int64_t TypedValues::daysFromCivil(int64_t year, unsigned month, unsigned day) {
+    year -= month <= 2;
+    int64_t era = (year >= 0 ? year : year - 399) / 400;
+    unsigned yearOfEra = static_cast<unsigned>(year - era * 400);
+    unsigned dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    unsigned dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + static_cast<int64_t>(dayOfEra) - 719468;
+}
+void TypedValues::civilFromDays(int64_t days, int64_t& year, unsigned& month, unsigned& day) {
+    days += 719468;
+    int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+    unsigned dayOfEra = static_cast<unsigned>(days - era * 146097);
+    unsigned yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    unsigned dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    unsigned mp = (5 * dayOfYear + 2) / 153;
+    day = dayOfYear - (153 * mp + 2) / 5 + 1;
+    month = mp < 10 ? mp + 3 : mp - 9;
+    year = static_cast<int64_t>(yearOfEra) + era * 400 + (month <= 2);
+}
+bool TypedValues::parseDate(std::string_view text, int32_t& days) {
+    int year, month, day;
+    if (text.size() != 10 || text[4] != '-' || text[7] != '-' ||
+        !readDigits(text, 0, 4, year) || !readDigits(text, 5, 2, month) || !readDigits(text, 8, 2, day)) {
+        return false;
+    }
+    static const int monthDays[] = {31, 29, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    if (month < 1 || month > 12 || day < 1 || day > monthDays[month - 1]) {
+        return false;
+    }
+    bool leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+    if (month == 2 && day == 29 && !leap) {
+        return false;
+    }
+    days = static_cast<int32_t>(daysFromCivil(year, month, day));
+    return true;
+}
+bool TypedValues::parseTime(std::string_view text, int64_t& micros) {
+    int hours, minutes, seconds;
+    if (text.size() < 8 || text[2] != ':' || text[5] != ':' ||
+        !readDigits(text, 0, 2, hours) || !readDigits(text, 3, 2, minutes) || !readDigits(text, 6, 2, seconds) ||
+        hours > 23 || minutes > 59 || seconds > 59) {
+        return false;
+    }
+    int fraction = 0;
+    if (text.size() > 8) {
+        // Up to microseconds
+        size_t digits = text.size() - 9;
+        if (text[8] != '.' || digits < 1 || digits > 6 || !readDigits(text, 9, digits, fraction)) {
+            return false;
+        }
+        for (size_t i = digits; i < 6; ++i) {
+            fraction *= 10;
+        }
+    }
+    micros = ((hours * 60 + minutes) * 60 + seconds) * MICROS_PER_SECOND + fraction;
+    return true;
+}
+bool TypedValues::parseTimestamp(std::string_view text, int64_t& micros) {
+    int32_t days;
+    int64_t clock;
+    if (text.size() < 19 || (text[10] != ' ' && text[10] != 'T') ||
+        !parseDate(text.substr(0, 10), days) || !parseTime(text.substr(11), clock)) {
+        return false;
+    }
+    micros = days * MICROS_PER_DAY + clock;
+    return true;
+}
+bool TypedValues::isDateShaped(std::string_view text) {
+    int field;
+    return text.size() == 10 && text[4] == '-' && text[7] == '-' &&
+           readDigits(text, 0, 4, field) && readDigits(text, 5, 2, field) && readDigits(text, 8, 2, field);
+}
+bool TypedValues::isTimeShaped(std::string_view text) {
+    int field;
+    if (text.size() < 8 || text[2] != ':' || text[5] != ':' ||
+        !readDigits(text, 0, 2, field) || !readDigits(text, 3, 2, field) || !readDigits(text, 6, 2, field)) {
+        return false;
+    }
+    size_t digits = text.size() - 9;
+    return text.size() == 8 || (text[8] == '.' && text.size() > 9 && digits <= 6 && readDigits(text, 9, digits, field));
+}
+bool TypedValues::isTimestampShaped(std::string_view text) {
+    return text.size() >= 19 && (text[10] == ' ' || text[10] == 'T') &&
+           isDateShaped(text.substr(0, 10)) && isTimeShaped(text.substr(11));
+}
+std::string TypedValues::formatDate(int32_t days) {
+    int64_t year;
+    unsigned month, day;
+    civilFromDays(days, year, month, day);
+    char text[32];
+    std::snprintf(text, sizeof(text), "%04lld-%02u-%02u", static_cast<long long>(year), month, day);
+    return text;
+}
+std::string TypedValues::formatTime(int64_t micros) {
+    std::string text;
+    printClock(micros, text);
+    return text;
+}
+std::string TypedValues::formatTimestamp(int64_t micros) {
+    int64_t days = micros / MICROS_PER_DAY;
+    int64_t clock = micros % MICROS_PER_DAY;
+    if (clock < 0) {
+        days--;
+        clock += MICROS_PER_DAY;
+    }
+    std::string text = formatDate(static_cast<int32_t>(days));
+    text += ' ';
+    printClock(clock, text);
+    return text;
+}
+bool TypedValues::isTemporal(std::string_view text) {
+    auto digitsAt = [&](std::initializer_list<size_t> positions) {
+        for (size_t i : positions) {
+            if (!isDigit(text[i])) {
+                return false;
+            }
+        }
+        return true;
+    };
+    if (text.size() >= 10 && text[4] == '-' && text[7] == '-') {
+        return digitsAt({0, 1, 2, 3, 5, 6, 8, 9});
+    }
+    return text.size() >= 8 && text[2] == ':' && text[5] == ':' && digitsAt({0, 1, 3, 4, 6, 7});
+}
+// Booleans
+// --------
+bool TypedValues::parseBoolean(std::string_view text, bool& value) {
+    char upper[6];
+    if (text.empty() || text.size() > 5) {
+        return false;
+    }
+    for (size_t i = 0; i < text.size(); ++i) {
+        upper[i] = static_cast<char>(std::toupper(static_cast<unsigned char>(text[i])));
+    }
+    std::string_view word(upper, text.size());
+    if (word == "TRUE" || word == "1" || word == "T" || word == "YES" || word == "Y") {
+        value = true;
+        return true;
+    }
+    if (word == "FALSE" || word == "0" || word == "F" || word == "NO" || word == "N") {
+        value = false;
+        return true;
+    }
+    return false;
+}
+// Numbers
+// -------
+bool TypedValues::parseDecimal(std::string_view text, int scale, int64_t& scaled) {
+    // Magnitudes stay below 10^MAX_DECIMAL_DIGITS
+    static const int64_t LIMIT = 1000000000000000000;
+    size_t pos = 0;
+    bool negative = false;
+    if (pos < text.size() && (text[pos] == '+' || text[pos] == '-')) {
+        negative = text[pos] == '-';
+        pos++;
+    }
+    int64_t magnitude = 0;
+    auto push = [&](int digit) {
+        if (magnitude >= LIMIT / 10) {
+            return false;
+        }
+        magnitude = magnitude * 10 + digit;
+        return true;
+    };
+    bool anyDigit = false;
+    bool point = false;
+    int fractionDigits = 0;
+    bool roundUp = false;
+    bool dropped = false;
+    for (; pos < text.size(); ++pos) {
+        char ch = text[pos];
+        if (ch == '.' && !point) {
+            point = true;
+            continue;
+        }
+        if (!isDigit(ch)) {
+            return false;
+        }
+        anyDigit = true;
+        if (point && fractionDigits == scale) {
+            // The first dropped digit decides the rounding
+            if (!dropped) {
+                roundUp = ch >= '5';
+                dropped = true;
+            }
+            continue;
+        }
+        if (point) {
+            fractionDigits++;
+        }
+        if (!push(ch - '0')) {
+            return false;
+        }
+    }
+    if (!anyDigit) {
+        return false;
+    }
+    for (; fractionDigits < scale; ++fractionDigits) {
+        if (!push(0)) {
+            return false;
+        }
+    }
+    scaled = negative ? -(magnitude + roundUp) : magnitude + roundUp;
+    return true;
+}
+std::string TypedValues::formatDecimal(int64_t scaled, int scale) {
+    uint64_t magnitude = scaled < 0 ? 0 - static_cast<uint64_t>(scaled) : static_cast<uint64_t>(scaled);
+    std::string digits = std::to_string(magnitude);
+    if (digits.size() <= static_cast<size_t>(scale)) {
+        digits.insert(0, scale + 1 - digits.size(), '0');
+    }
+    std::string text = scaled < 0 ? "-" : "";
+    text.append(digits, 0, digits.size() - scale);
+    if (scale > 0) {
+        text += '.';
+        text.append(digits, digits.size() - scale, scale);
+    }
+    return text;
+}
+// Start of the number std::stoi / std::stod would read: past leading
+// whitespace and a '+' sign, which std::from_chars does not accept
+static const char* numberStart(std::string_view text) {
+    const char* start = text.data();
+    const char* end = start + text.size();
+    while (start < end && std::isspace(static_cast<unsigned char>(*start))) {
+        start++;
+    }
+    if (start + 1 < end && *start == '+' && start[1] != '-' && start[1] != '+') {
+        start++;
+    }
+    return start;
+}
+bool TypedValues::parseIntegerPrefix(std::string_view text, int& value) {
+    const char* start = numberStart(text);
+    auto parsed = std::from_chars(start, text.data() + text.size(), value);
+    return parsed.ec == std::errc();
+}
+bool TypedValues::parseRealPrefix(std::string_view text, double& value) {
+    const char* start = numberStart(text);
+    auto parsed = std::from_chars(start, text.data() + text.size(), value);
+    return parsed.ec == std::errc();
+}
+std::string TypedValues::formatReal(double value) {
+    char text[512];
+    auto printed = std::to_chars(text, text + sizeof(text), value, std::chars_format::fixed, 6);
+    return std::string(text, printed.ptr - text);
+}
@@ -0,0 +1,64 @@
+#ifndef TYPED_VALUE_H
+#define TYPED_VALUE_H
+
+#include <string>
+#include <string_view>
+#include <cstdint>
+
+// Hand-written parsers and printers for the fixed-width forms of typed
+// column values:
+//   DATE          days since 1970-01-01 (YYYY-MM-DD)
+//   TIME          microseconds since midnight (HH:MM:SS[.ffffff])
+//   TIMESTAMP     microseconds since 1970-01-01 00:00:00
+//   BOOLEAN       one bit (TRUE / FALSE)
+//   NUMERIC(p,d)  int64 scaled by 10^d
+// Canonical text is what the format functions print: four-digit years,
+// seconds with the fraction's trailing zeros dropped, exactly d decimals.
+// Canonical dates, times and timestamps sort as text in time order.
+namespace TypedValues {
+    const int64_t MICROS_PER_SECOND = 1000000;
+    const int64_t MICROS_PER_DAY = 86400 * MICROS_PER_SECOND;
+    // NUMERIC(p,d) with more digits than this keeps the REAL representation
+    const int MAX_DECIMAL_DIGITS = 18;
+
+    // Days since 1970-01-01 in the proleptic Gregorian calendar
+    int64_t daysFromCivil(int64_t year, unsigned month, unsigned day);
+    void civilFromDays(int64_t days, int64_t& year, unsigned& month, unsigned& day);
+
+    // Each parser checks the calendar and clock ranges and returns false for
+    // anything else; a timestamp also accepts 'T' between date and time
+    bool parseDate(std::string_view text, int32_t& days);
+    bool parseTime(std::string_view text, int64_t& micros);
+    bool parseTimestamp(std::string_view text, int64_t& micros);
+    // Whether text is spelled like a date, time or timestamp, with its fields
+    // in range or not, which tells 2020-02-30 from a malformed value
+    bool isDateShaped(std::string_view text);
+    bool isTimeShaped(std::string_view text);
+    bool isTimestampShaped(std::string_view text);
+    std::string formatDate(int32_t days);
+    std::string formatTime(int64_t micros);
+    std::string formatTimestamp(int64_t micros);
+
+    // TRUE/T/YES/Y/1 and FALSE/F/NO/N/0, in any case
+    bool parseBoolean(std::string_view text, bool& value);
+    inline const char* formatBoolean(bool value) { return value ? "TRUE" : "FALSE"; }
+
+    // Decimal text rounded half away from zero to scale digits; false for
+    // text that is not a plain decimal or needs more than MAX_DECIMAL_DIGITS
+    bool parseDecimal(std::string_view text, int scale, int64_t& scaled);
+    std::string formatDecimal(int64_t scaled, int scale);
+
+    // Leading number of text as std::stoi / std::stod read it (whitespace
+    // and a sign first, anything after the number ignored), without throwing
+    bool parseIntegerPrefix(std::string_view text, int& value);
+    bool parseRealPrefix(std::string_view text, double& value);
+    // std::to_string spelling of a double
+    std::string formatReal(double value);
+
+    // True for text that starts like a canonical date (YYYY-MM-DD) or time
+    // (HH:MM:SS). Comparisons involving such text compare it as text rather
+    // than reading the leading year or hour as a number.
+    bool isTemporal(std::string_view text);
+}
+
+#endif // TYPED_VALUE_H
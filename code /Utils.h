@@ -2,6 +2,7 @@
 #define UTILS_H
 
 #include <string>
+#include <string_view>
 #include <sstream>
 #include <vector>
 #include <algorithm>
@@ -49,6 +50,19 @@ static std::vector<std::string> split(const std::string &s, char delimiter) {
     return tokens;
 }
 
+// NULL is the empty cell. The empty string is stored as EMPTY_TEXT_CELL, a
+// lone unit separator, so that '' and NULL stay apart in every layout.
+// literalCell() refuses that byte as a value of its own.
+inline const std::string EMPTY_TEXT_CELL = "\x1F";
+
+// How a cell is printed: NULL spelled out, the empty string as nothing
+inline std::string_view displayCell(std::string_view cell) {
+    if (cell.empty()) {
+        return "NULL";
+    }
+    return cell == EMPTY_TEXT_CELL ? std::string_view() : cell;
+}
+
 // Match a string against a SQL LIKE pattern
 inline bool matchLikePattern(const std::string& str, const std::string& pattern) {
     std::string regexPattern;
@@ -147,18 +161,33 @@ inline bool isValidDataType(const std::string& type) {
 
 // Extract parameter part from type definition like CHAR(10) or NUMERIC(10,2)
 inline std::pair<int, int> extractTypeParameters(const std::string& type) {
-    std::pair<int, int> result = {0, 0};
-    std::regex paramRegex("\\((\\d+)(,(\\d+))?\\)");
-    std::smatch match;
-    
-    if (std::regex_search(type, match, paramRegex) && match.size() > 1) {
-        result.first = std::stoi(match[1].str());
-        if (match.size() > 3 && match[3].matched) {
-            result.second = std::stoi(match[3].str());
+    // First "(digits)" or "(digits,digits)" in type; scanned by hand since
+    // inserts call this for every CHAR, VARCHAR and NUMERIC cell
+    auto readNumber = [&](size_t& pos, int& value) {
+        size_t start = pos;
+        value = 0;
+        while (pos < type.size() && std::isdigit(static_cast<unsigned char>(type[pos]))) {
+            value = value * 10 + (type[pos++] - '0');
+        }
+        return pos > start;
+    };
+    for (size_t open = type.find('('); open != std::string::npos; open = type.find('(', open + 1)) {
+        std::pair<int, int> result = {0, 0};
+        size_t pos = open + 1;
+        if (!readNumber(pos, result.first)) {
+            continue;
+        }
+        if (pos < type.size() && type[pos] == ',') {
+            pos++;
+            if (!readNumber(pos, result.second)) {
+                continue;
+            }
+        }
+        if (pos < type.size() && type[pos] == ')') {
+            return result;
         }
     }
-    
-    return result;
+    return {0, 0};
 }
 
 // Custom exceptions
@@ -197,6 +226,26 @@ public:
     AuthorizationException(const std::string& message) : DatabaseException(message) {}
 };
 
+// Cell for a SQL literal: 'text' without its quotes, '' as EMPTY_TEXT_CELL,
+// an unquoted NULL as NULL, anything else unchanged. The marker is in-band,
+// so a value that is exactly EMPTY_TEXT_CELL is refused rather than read
+// back as ''.
+inline std::string literalCell(const std::string& literal) {
+    std::string cell = literal;
+    if (literal.size() >= 2 && literal.front() == '\'' && literal.back() == '\'') {
+        if (literal.size() == 2) {
+            return EMPTY_TEXT_CELL;
+        }
+        cell = literal.substr(1, literal.size() - 2);
+    } else if (literal.size() == 4 && toUpperCase(literal) == "NULL") {
+        return "";
+    }
+    if (cell == EMPTY_TEXT_CELL) {
+        throw DataTypeException("A value cannot be the single byte 0x1F, which stores the empty string");
+    }
+    return cell;
+}
+
 // User-defined type management
 struct UserDefinedType {
     std::string name;
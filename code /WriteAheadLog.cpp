@@ -0,0 +1,355 @@
+#include "WriteAheadLog.h"
+#include "PageFormat.h"
+#include "Utils.h"
+#include <algorithm>
+#include <fstream>
+#include <thread>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+// Frame layout: payloadLength(4) checksum(4) payload
+static const size_t FRAME_HEADER_SIZE = 8;
+// Pending bytes that force a write-out even without a commit (large transactions)
+static const size_t MAX_PENDING_BYTES = 4 * 1024 * 1024;
+static void writeAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t written = ::write(fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw DatabaseException("Failed to write to write-ahead log: " + std::string(std::strerror(errno)));
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+}
+WriteAheadLog::~WriteAheadLog() {
+    try {
+        close();
+    } catch (...) {
+        // Destructors must not throw; unflushed records are lost like on a crash
+    }
+}
+void WriteAheadLog::open(const std::string& logPath, uint64_t startLsn) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (fd >= 0) {
+        throw DatabaseException("Write-ahead log is already open: " + path);
+    }
+
+    // Find the last intact record and cut off any torn tail left by a crash
+    size_t validBytes = 0;
+    std::vector<WalRecord> records = readLog(logPath, &validBytes);
+    uint64_t lastLsn = records.empty() ? 0 : records.back().lsn;
+    lastLsn = std::max(lastLsn, startLsn);
+
+    fd = ::open(logPath.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (fd < 0) {
+        throw DatabaseException("Failed to open write-ahead log: " + logPath + " (" + std::strerror(errno) + ")");
+    }
+    if (::ftruncate(fd, static_cast<off_t>(validBytes)) != 0) {
+        ::close(fd);
+        fd = -1;
+        throw DatabaseException("Failed to truncate write-ahead log: " + logPath);
+    }
+
+    path = logPath;
+    nextLsn = lastLsn + 1;
+    bufferedLsn = lastLsn;
+    durableLsn = lastLsn;
+    writtenBytes = validBytes;
+    pending.clear();
+}
+void WriteAheadLog::close() {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (fd < 0) {
+        return;
+    }
+    flushed.wait(lock, [this]() { return !flushInProgress; });
+
+    if (!pending.empty()) {
+        writeFully(pending.data(), pending.size());
+        pending.clear();
+    }
+    if (syncPolicy != WalSyncPolicy::OFF) {
+        syncFile();
+    }
+    durableLsn = bufferedLsn;
+
+    ::close(fd);
+    fd = -1;
+}
+void WriteAheadLog::setSyncPolicy(WalSyncPolicy policy) {
+    std::lock_guard<std::mutex> lock(mutex);
+    syncPolicy = policy;
+}
+void WriteAheadLog::setGroupCommitDelay(std::chrono::microseconds delay) {
+    std::lock_guard<std::mutex> lock(mutex);
+    groupCommitDelay = delay;
+}
+uint64_t WriteAheadLog::append(WalRecord& record) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (fd < 0) {
+        throw DatabaseException("Write-ahead log is not open");
+    }
+
+    record.lsn = nextLsn++;
+    encodeRecord(record, pending);
+    bufferedLsn = record.lsn;
+
+    // Keep long transactions from growing the buffer without bound. Only safe
+    // when no leader is writing an earlier batch, otherwise order would break.
+    if (pending.size() >= MAX_PENDING_BYTES && !flushInProgress) {
+        writeFully(pending.data(), pending.size());
+        pending.clear();
+    }
+
+    return record.lsn;
+}
+void WriteAheadLog::commit(uint64_t lsn) {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (fd < 0) {
+        return;
+    }
+
+    if (syncPolicy != WalSyncPolicy::GROUP) {
+        // Every committer writes and syncs for itself
+        flushed.wait(lock, [this]() { return !flushInProgress; });
+        if (durableLsn >= lsn) {
+            return;
+        }
+        writeFully(pending.data(), pending.size());
+        pending.clear();
+        if (syncPolicy == WalSyncPolicy::COMMIT) {
+            syncFile();
+        }
+        durableLsn = bufferedLsn;
+        return;
+    }
+
+    // Group commit: the first waiter becomes the leader and flushes everything
+    // buffered so far; committers arriving meanwhile wait for the next round
+    while (durableLsn < lsn) {
+        if (flushInProgress) {
+            flushed.wait(lock);
+            continue;
+        }
+
+        flushInProgress = true;
+        if (groupCommitDelay.count() > 0) {
+            lock.unlock();
+            std::this_thread::sleep_for(groupCommitDelay);
+            lock.lock();
+        }
+
+        std::vector<char> batch;
+        batch.swap(pending);
+        uint64_t batchLsn = bufferedLsn;
+        lock.unlock();
+
+        try {
+            writeAll(fd, batch.data(), batch.size());
+            syncFile();
+        } catch (...) {
+            lock.lock();
+            flushInProgress = false;
+            flushed.notify_all();
+            throw;
+        }
+
+        lock.lock();
+        writtenBytes += batch.size();
+        durableLsn = batchLsn;
+        flushInProgress = false;
+        flushed.notify_all();
+    }
+}
+uint64_t WriteAheadLog::flush() {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (fd < 0) {
+        return 0;
+    }
+    flushed.wait(lock, [this]() { return !flushInProgress; });
+    if (!pending.empty()) {
+        writeFully(pending.data(), pending.size());
+        pending.clear();
+    }
+    return writtenBytes;
+}
+uint64_t WriteAheadLog::getLastLsn() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return bufferedLsn;
+}
+uint64_t WriteAheadLog::getSize() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return writtenBytes + pending.size();
+}
+void WriteAheadLog::truncate(uint64_t upToLsn) {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (fd < 0) {
+        return;
+    }
+    flushed.wait(lock, [this]() { return !flushInProgress; });
+    
+    if (!pending.empty()) {
+        writeFully(pending.data(), pending.size());
+        pending.clear();
+    }
+    
+    // Records past the checkpoint must survive the truncation
+    std::vector<char> tail;
+    for (const auto& record : readLog(path)) {
+        if (record.lsn > upToLsn) {
+            encodeRecord(record, tail);
+        }
+    }
+    
+    if (tail.empty()) {
+        if (::ftruncate(fd, 0) != 0) {
+            throw DatabaseException("Failed to truncate write-ahead log: " + path);
+        }
+        syncFile();
+    } else {
+        // Write the surviving tail beside the log and swap it in atomically
+        std::string tempPath = path + ".tmp";
+        int tempFd = ::open(tempPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (tempFd < 0) {
+            throw DatabaseException("Failed to create " + tempPath + " (" + std::strerror(errno) + ")");
+        }
+        try {
+            writeAll(tempFd, tail.data(), tail.size());
+            if (::fdatasync(tempFd) != 0) {
+                throw DatabaseException("Failed to sync " + tempPath);
+            }
+        } catch (...) {
+            ::close(tempFd);
+            throw;
+        }
+        ::close(tempFd);
+        
+        if (::rename(tempPath.c_str(), path.c_str()) != 0) {
+            throw DatabaseException("Failed to replace write-ahead log: " + path);
+        }
+        ::close(fd);
+        fd = ::open(path.c_str(), O_WRONLY | O_APPEND);
+        if (fd < 0) {
+            throw DatabaseException("Failed to reopen write-ahead log: " + path);
+        }
+    }
+    
+    durableLsn = bufferedLsn;
+    writtenBytes = tail.size();
+}
+void WriteAheadLog::writeFully(const char* data, size_t size) {
+    writeAll(fd, data, size);
+    writtenBytes += size;
+}
+void WriteAheadLog::syncFile() {
+    if (::fdatasync(fd) != 0) {
+        throw DatabaseException("Failed to sync write-ahead log: " + std::string(std::strerror(errno)));
+    }
+}
+void WriteAheadLog::encodeRecord(const WalRecord& record, std::vector<char>& out) {
+    std::vector<char> payload;
+    ByteWriter writer(payload);
+    writer.putU64(record.lsn);
+    writer.putU64(record.transactionId);
+    writer.putU8(static_cast<uint8_t>(record.type));
+    writer.putString(record.tableName);
+    writer.putU32(static_cast<uint32_t>(record.arguments.size()));
+    for (const auto& argument : record.arguments) {
+        writer.putString(argument);
+    }
+    writer.putU32(static_cast<uint32_t>(record.rows.size()));
+    for (const auto& row : record.rows) {
+        writer.putU32(static_cast<uint32_t>(row.size()));
+        for (const auto& cell : row) {
+            writer.putString(cell);
+        }
+    }
+
+    ByteWriter frame(out);
+    frame.putU32(static_cast<uint32_t>(payload.size()));
+    frame.putU32(PageFormat::checksum(payload.data(), payload.size()));
+    frame.putBytes(payload.data(), payload.size());
+}
+std::vector<WalRecord> WriteAheadLog::readLog(const std::string& logPath, size_t* validBytes) {
+    std::vector<WalRecord> records;
+    if (validBytes) {
+        *validBytes = 0;
+    }
+
+    std::ifstream logFile(logPath, std::ios::binary);
+    if (!logFile) {
+        return records; // No log yet
+    }
+    std::vector<char> data((std::istreambuf_iterator<char>(logFile)), std::istreambuf_iterator<char>());
+
+    size_t offset = 0;
+    while (data.size() - offset >= FRAME_HEADER_SIZE) {
+        ByteReader frame(data.data() + offset, FRAME_HEADER_SIZE);
+        uint32_t payloadBytes = frame.getU32();
+        uint32_t expectedChecksum = frame.getU32();
+        if (data.size() - offset - FRAME_HEADER_SIZE < payloadBytes) {
+            break; // Torn write at the tail
+        }
+
+        const char* payload = data.data() + offset + FRAME_HEADER_SIZE;
+        if (PageFormat::checksum(payload, payloadBytes) != expectedChecksum) {
+            break;
+        }
+
+        try {
+            ByteReader reader(payload, payloadBytes);
+            WalRecord record;
+            record.lsn = reader.getU64();
+            record.transactionId = reader.getU64();
+            record.type = static_cast<WalRecordType>(reader.getU8());
+            record.tableName = reader.getString();
+            uint32_t argumentCount = reader.getU32();
+            for (uint32_t i = 0; i < argumentCount; ++i) {
+                record.arguments.push_back(reader.getString());
+            }
+            uint32_t rowCount = reader.getU32();
+            for (uint32_t i = 0; i < rowCount; ++i) {
+                uint32_t cellCount = reader.getU32();
+                std::vector<std::string> row;
+                row.reserve(cellCount);
+                for (uint32_t j = 0; j < cellCount; ++j) {
+                    row.push_back(reader.getString());
+                }
+                record.rows.push_back(std::move(row));
+            }
+            records.push_back(std::move(record));
+        } catch (const DatabaseException&) {
+            break;
+        }
+
+        offset += FRAME_HEADER_SIZE + payloadBytes;
+        if (validBytes) {
+            *validBytes = offset;
+        }
+    }
+
+    return records;
+}
+WalSyncPolicy WriteAheadLog::parseSyncPolicy(const std::string& name) {
+    std::string upperName = toUpperCase(trim(name));
+    if (upperName == "OFF" || upperName == "NONE") {
+        return WalSyncPolicy::OFF;
+    } else if (upperName == "COMMIT" || upperName == "FULL") {
+        return WalSyncPolicy::COMMIT;
+    } else if (upperName == "GROUP") {
+        return WalSyncPolicy::GROUP;
+    }
+    throw DatabaseException("Unknown WAL sync policy: " + name + " (expected OFF, COMMIT or GROUP)");
+}
+std::string WriteAheadLog::syncPolicyName(WalSyncPolicy policy) {
+    switch (policy) {
+        case WalSyncPolicy::OFF: return "OFF";
+        case WalSyncPolicy::COMMIT: return "COMMIT";
+        case WalSyncPolicy::GROUP: return "GROUP";
+    }
+    return "UNKNOWN";
+}
@@ -0,0 +1,102 @@
+#ifndef WRITE_AHEAD_LOG_H
+#define WRITE_AHEAD_LOG_H
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <cstdint>
+
+// When a committed record is forced to stable storage
+enum class WalSyncPolicy {
+    OFF,     // Hand records to the OS on commit, never fsync
+    COMMIT,  // fsync once per committing statement
+    GROUP    // Batch fsyncs across concurrent committers
+};
+
+// Logged operations. DML records are logical: replaying them through the
+// Database methods reproduces the original effect.
+enum class WalRecordType : uint8_t {
+    INSERT = 1,
+    UPDATE = 2,
+    DELETE = 3,
+    MERGE = 4,
+    REPLACE = 5,
+    COMMIT = 6,
+    ABORT = 7
+};
+
+struct WalRecord {
+    uint64_t lsn = 0;
+    uint64_t transactionId = 0;  // 0 for auto-committed statements
+    WalRecordType type = WalRecordType::INSERT;
+    std::string tableName;
+    std::vector<std::string> arguments;           // condition, merge command
+    std::vector<std::vector<std::string>> rows;   // values, or column/value pairs for UPDATE
+};
+
+// Append-only redo log shared by all writers of a database
+class WriteAheadLog {
+public:
+    WriteAheadLog() = default;
+    ~WriteAheadLog();
+    
+    // Open (or create) the log file and continue numbering after its last
+    // record, or after startLsn if a checkpoint already covers a later one
+    void open(const std::string& path, uint64_t startLsn = 0);
+    void close();
+    bool isOpen() const { return fd >= 0; }
+    const std::string& getPath() const { return path; }
+    
+    // Sync configuration
+    void setSyncPolicy(WalSyncPolicy policy);
+    WalSyncPolicy getSyncPolicy() const { return syncPolicy; }
+    // How long a group-commit leader waits for followers before flushing
+    void setGroupCommitDelay(std::chrono::microseconds delay);
+    
+    // Buffer a record and assign its LSN
+    uint64_t append(WalRecord& record);
+    
+    // Block until every record up to lsn is durable under the current policy
+    void commit(uint64_t lsn);
+    
+    // Hand every buffered record to the OS without waiting for a sync, and
+    // return the length of the log file, which then ends on a record boundary
+    uint64_t flush();
+    
+    uint64_t getLastLsn() const;
+    // Bytes in the log, including records not yet written out
+    uint64_t getSize() const;
+    
+    // Drop every record up to upToLsn once a checkpoint covers them
+    void truncate(uint64_t upToLsn);
+    
+    // Decode every intact record of a log file (stops at a torn tail)
+    static std::vector<WalRecord> readLog(const std::string& path, size_t* validBytes = nullptr);
+    
+    static WalSyncPolicy parseSyncPolicy(const std::string& name);
+    static std::string syncPolicyName(WalSyncPolicy policy);
+
+private:
+    std::string path;
+    int fd = -1;
+    WalSyncPolicy syncPolicy = WalSyncPolicy::GROUP;
+    std::chrono::microseconds groupCommitDelay{0};
+    
+    mutable std::mutex mutex;
+    std::condition_variable flushed;
+    std::vector<char> pending;     // encoded records not yet written
+    uint64_t nextLsn = 1;
+    uint64_t bufferedLsn = 0;      // last LSN placed in pending
+    uint64_t durableLsn = 0;       // last LSN known to be on disk
+    bool flushInProgress = false;
+    uint64_t writtenBytes = 0;     // current length of the log file
+    
+    void writeFully(const char* data, size_t size);
+    void syncFile();
+    
+    static void encodeRecord(const WalRecord& record, std::vector<char>& out);
+};
+
+#endif // WRITE_AHEAD_LOG_H
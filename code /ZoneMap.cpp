@@ -0,0 +1,208 @@
+#include "ZoneMap.h"
+#include "Utils.h"
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+// Longest text bound kept per column
+static const size_t MAX_BOUND_BYTES = 32;
+static const size_t TRAILER_HEADER_SIZE = 16;
+// Smallest string greater than every string starting with the first
+// MAX_BOUND_BYTES of value; false if there is none (all 0xFF)
+static bool upperBound(std::string_view value, std::string& bound) {
+    if (value.size() <= MAX_BOUND_BYTES) {
+        bound.assign(value);
+        return true;
+    }
+    bound.assign(value.substr(0, MAX_BOUND_BYTES));
+    while (!bound.empty() && static_cast<unsigned char>(bound.back()) == 0xFF) {
+        bound.pop_back();
+    }
+    if (bound.empty()) {
+        return false;
+    }
+    bound.back() = static_cast<char>(static_cast<unsigned char>(bound.back()) + 1);
+    return true;
+}
+static void putDouble(ByteWriter& writer, double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    writer.putU64(bits);
+}
+static double getDouble(ByteReader& reader) {
+    uint64_t bits = reader.getU64();
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+// ColumnZone / BlockZone
+// ----------------------
+void ColumnZone::add(std::string_view cell) {
+    // NULL satisfies no comparison, so it stays out of the bounds and keys
+    if (cell.empty()) {
+        nullCount++;
+        return;
+    }
+    bool first = numericCount + textCount == 0;
+    double number;
+    if (ZoneMaps::parseNumber(cell, number) && !std::isnan(number)) {
+        if (numericCount == 0 || number < numericMin) {
+            numericMin = number;
+        }
+        if (numericCount == 0 || number > numericMax) {
+            numericMax = number;
+        }
+        numericCount++;
+    } else {
+        // NaN never satisfies a numeric comparison, so it only counts as text
+        textCount++;
+    }
+
+    if (first || cell < textMin) {
+        textMin.assign(cell.substr(0, MAX_BOUND_BYTES));
+    }
+    if ((first || (!textMaxUnbounded && cell > textMax)) && !upperBound(cell, textMax)) {
+        textMaxUnbounded = true;
+        textMax.clear();
+    }
+    if (tracksKeys) {
+        BloomFilter::cellKeys(cell, keys);
+    }
+}
+void BlockZone::trackKeys(const std::vector<size_t>& keyColumns) {
+    for (size_t column : keyColumns) {
+        if (column >= columns.size()) {
+            columns.resize(column + 1);
+        }
+        columns[column].tracksKeys = true;
+    }
+}
+void BlockZone::add(const RowView& row) {
+    // Cells missing from short rows read as empty
+    if (row.size() > columns.size()) {
+        size_t known = columns.size();
+        columns.resize(row.size());
+        for (size_t c = known; c < columns.size() && rowCount > 0; ++c) {
+            columns[c].nullCount = static_cast<uint32_t>(rowCount);
+        }
+    }
+    for (size_t c = 0; c < columns.size(); ++c) {
+        columns[c].add(c < row.size() ? row[c] : std::string_view());
+    }
+    rowCount++;
+}
+void BlockZone::finish() {
+    for (auto& column : columns) {
+        if (column.tracksKeys) {
+            column.bloom = BloomFilter(column.keys);
+            column.keys = {};
+        }
+    }
+}
+size_t BlockZone::memoryBytes() const {
+    size_t total = sizeof(*this) + columns.capacity() * sizeof(ColumnZone);
+    for (const auto& column : columns) {
+        total += column.bloom.memoryBytes() + column.keys.capacity() * sizeof(uint64_t);
+        // Bounds longer than the short string buffer live on the heap
+        for (const std::string* bound : {&column.textMin, &column.textMax}) {
+            total += bound->capacity() > 15 ? bound->capacity() + 1 : 0;
+        }
+    }
+    return total;
+}
+// ZoneMaps
+// --------
+bool ZoneMaps::parseNumber(std::string_view text, double& number) {
+    // strtod needs a terminated string; short cells use the stack
+    char buffer[64];
+    std::string longText;
+    const char* start = buffer;
+    if (text.size() < sizeof(buffer)) {
+        std::memcpy(buffer, text.data(), text.size());
+        buffer[text.size()] = '\0';
+    } else {
+        longText.assign(text);
+        start = longText.c_str();
+    }
+
+    int savedErrno = errno;
+    errno = 0;
+    char* end = nullptr;
+    number = std::strtod(start, &end);
+    bool ok = end != start && errno != ERANGE;
+    errno = savedErrno;
+    return ok;
+}
+void ZoneMaps::writeTrailer(ByteWriter& writer, const std::vector<BlockZone>& zones) {
+    std::vector<char> payload;
+    ByteWriter zoneWriter(payload);
+    zoneWriter.putU32(static_cast<uint32_t>(zones.size()));
+    for (const auto& zone : zones) {
+        zoneWriter.putU32(zone.firstPage);
+        zoneWriter.putU64(zone.rowCount);
+        zoneWriter.putU32(static_cast<uint32_t>(zone.columns.size()));
+        for (const auto& column : zone.columns) {
+            zoneWriter.putU32(column.nullCount);
+            zoneWriter.putU32(column.numericCount);
+            putDouble(zoneWriter, column.numericMin);
+            putDouble(zoneWriter, column.numericMax);
+            zoneWriter.putU32(column.textCount);
+            zoneWriter.putU8(column.textMaxUnbounded ? 1 : 0);
+            zoneWriter.putString(column.textMin);
+            zoneWriter.putString(column.textMax);
+            zoneWriter.putU8(column.bloom.empty() ? 0 : 1);
+            if (!column.bloom.empty()) {
+                column.bloom.write(zoneWriter);
+            }
+        }
+    }
+
+    writer.putBytes(PageFormat::ZONE_MAGIC, sizeof(PageFormat::ZONE_MAGIC));
+    writer.putU32(static_cast<uint32_t>(payload.size()));
+    writer.putU32(PageFormat::checksum(payload.data(), payload.size()));
+    writer.putBytes(payload.data(), payload.size());
+}
+bool ZoneMaps::readTrailer(const char* data, size_t size, std::vector<BlockZone>& zones) {
+    if (size < TRAILER_HEADER_SIZE) {
+        return false;
+    }
+    bool hasBlooms = std::memcmp(data, PageFormat::ZONE_MAGIC, sizeof(PageFormat::ZONE_MAGIC)) == 0;
+    if (!hasBlooms && std::memcmp(data, PageFormat::ZONE_MAGIC_V1, sizeof(PageFormat::ZONE_MAGIC_V1)) != 0) {
+        return false;
+    }
+    ByteReader header(data + sizeof(PageFormat::ZONE_MAGIC), 8);
+    uint32_t payloadBytes = header.getU32();
+    uint32_t expectedChecksum = header.getU32();
+    const char* payload = data + TRAILER_HEADER_SIZE;
+    if (payloadBytes > size - TRAILER_HEADER_SIZE ||
+        PageFormat::checksum(payload, payloadBytes) != expectedChecksum) {
+        return false;
+    }
+
+    try {
+        ByteReader reader(payload, payloadBytes);
+        std::vector<BlockZone> parsed(reader.getU32());
+        for (auto& zone : parsed) {
+            zone.firstPage = reader.getU32();
+            zone.rowCount = reader.getU64();
+            zone.columns.resize(reader.getU32());
+            for (auto& column : zone.columns) {
+                column.nullCount = reader.getU32();
+                column.numericCount = reader.getU32();
+                column.numericMin = getDouble(reader);
+                column.numericMax = getDouble(reader);
+                column.textCount = reader.getU32();
+                column.textMaxUnbounded = reader.getU8() != 0;
+                column.textMin = reader.getString();
+                column.textMax = reader.getString();
+                if (hasBlooms && reader.getU8() != 0) {
+                    column.bloom = BloomFilter::read(reader);
+                }
+            }
+        }
+        zones = std::move(parsed);
+        return true;
+    } catch (const DatabaseException&) {
+        return false;
+    }
+}
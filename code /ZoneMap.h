@@ -0,0 +1,65 @@
+#ifndef ZONE_MAP_H
+#define ZONE_MAP_H
+
+#include "PageFormat.h"
+#include "ConditionParser.h"
+#include "BloomFilter.h"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+// Summary of one column over a block of rows, kept the way the condition
+// evaluator compares cells: values that parse as numbers compare numerically,
+// any comparison may also fall back to comparing the raw text.
+struct ColumnZone {
+    uint32_t nullCount = 0;      // empty cells
+    uint32_t numericCount = 0;   // cells that parse as numbers (NaN excluded)
+    double numericMin = 0;
+    double numericMax = 0;
+    uint32_t textCount = 0;      // other non-empty cells
+    // Byte-wise bounds over every non-empty cell. Long bounds are shortened:
+    // the lower one to a prefix, the upper one to a prefix rounded up.
+    std::string textMin;
+    std::string textMax;
+    bool textMaxUnbounded = false;
+    // Equality filter for key columns; empty for other columns
+    BloomFilter bloom;
+    bool tracksKeys = false;
+    std::vector<uint64_t> keys;   // hashes gathered for bloom until finish()
+
+    void add(std::string_view cell);
+};
+
+// Summary of a block of rows: a data page run of a table file, or a fixed
+// number of in-memory rows
+struct BlockZone {
+    uint32_t firstPage = 0;   // first data page of the block (file zones only)
+    uint64_t rowCount = 0;
+    std::vector<ColumnZone> columns;
+
+    // Gathers keys for a Bloom filter on the given columns; call before add()
+    void trackKeys(const std::vector<size_t>& keyColumns);
+    void add(const RowView& row);
+    // Builds the Bloom filters from the gathered keys
+    void finish();
+    // Bytes held by the zone, its bounds and its Bloom filters
+    size_t memoryBytes() const;
+};
+
+namespace ZoneMaps {
+    // Rows summarized by one in-memory zone
+    const size_t ROWS_PER_ZONE = 1024;
+
+    // Same acceptance as std::stod, without throwing
+    bool parseNumber(std::string_view text, double& number);
+
+    // Zone trailer appended after the data pages of a table file:
+    // magic(8) payloadBytes(4) checksum(4) zoneCount(4) zones. Trailers with
+    // ZONE_MAGIC carry a Bloom filter flag per column, ZONE_MAGIC_V1 ones do not.
+    void writeTrailer(ByteWriter& writer, const std::vector<BlockZone>& zones);
+    // Returns false when data does not hold an intact trailer
+    bool readTrailer(const char* data, size_t size, std::vector<BlockZone>& zones);
+}
+
+#endif // ZONE_MAP_H
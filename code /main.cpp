@@ -8,11 +8,28 @@
 #include "Utils.h"
 #include "Transaction.h"
 Database* g_db = nullptr;
-int main() {
+int main(int argc, char* argv[]) {
     try {
         // Create database instance
         Database db;
         Parser parser;
+        
+        // Optional database name: recover <name>.db and <name>.wal, then keep
+        // them up to date. --SETTING=value arguments are applied before the
+        // database is opened, e.g. --lazy_load=off or --mmap_threshold=0
+        std::string dbName;
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            size_t eqPos = arg.find('=');
+            if (arg.rfind("--", 0) == 0 && eqPos != std::string::npos) {
+                db.applySetting(arg.substr(2, eqPos - 2), arg.substr(eqPos + 1));
+            } else {
+                dbName = arg;
+            }
+        }
+        if (!dbName.empty()) {
+            db.open(dbName);
+        }
         std::string commandBuffer;
         std::string line;
         
@@ -49,6 +66,12 @@ int main() {
                 std::cout << "    CREATE TABLE tableName (column1 type1, column2 type2, ...)\n";
                 std::cout << "    ALTER TABLE tableName ADD columnName dataType\n";
                 std::cout << "    ALTER TABLE tableName DROP columnName\n";
+                std::cout << "    CREATE TABLE tableName (...) PARTITION BY RANGE|LIST (column) (PARTITION name VALUES ..., ...)\n";
+                std::cout << "    CREATE TABLE tableName (...) PARTITION BY HASH (column) PARTITIONS n\n";
+                std::cout << "    ALTER TABLE tableName ADD|DROP BLOOM FILTER (column1, column2, ...)\n";
+                std::cout << "    ALTER TABLE tableName ADD PARTITION name VALUES LESS THAN (value)|IN (value, ...)\n";
+                std::cout << "    ALTER TABLE tableName DROP PARTITION name\n";
+                std::cout << "    ALTER TABLE tableName SET COLD AFTER n DAYS|SECONDS|SET COLD OFF\n";
                 std::cout << "    DROP TABLE tableName\n";
                 std::cout << "    CREATE INDEX indexName ON tableName (columnName)\n";
                 std::cout << "    DROP INDEX indexName\n";
@@ -81,7 +104,21 @@ int main() {
                 std::cout << "    SHOW TABLES\n";
                 std::cout << "    SHOW VIEWS\n";
                 std::cout << "    SHOW SCHEMA\n";
+                std::cout << "    SHOW TABLE STATS [tableName]\n";
                 std::cout << "    TRUNCATE TABLE tableName\n";
+                std::cout << "    SET WAL_SYNC = OFF|COMMIT|GROUP\n";
+                std::cout << "    SET WAL_GROUP_COMMIT_DELAY = microseconds\n";
+                std::cout << "    SET CHECKPOINT_INTERVAL = seconds\n";
+                std::cout << "    SET CHECKPOINT_WAL_SIZE = bytes\n";
+                std::cout << "    SET MMAP_THRESHOLD = bytes\n";
+                std::cout << "    SET BUFFER_POOL_SIZE = bytes (0 = memory-map instead)\n";
+                std::cout << "    SET LAZY_LOAD = ON|OFF\n";
+                std::cout << "    SET LOAD_THREADS = count (0 = all cores)\n";
+                std::cout << "    SET VERIFY_ON_LOAD = ON|OFF\n";
+                std::cout << "    SET COMPRESSION = ON|OFF\n";
+                std::cout << "    SET IO_QUEUE_DEPTH = count (0 = blocking I/O)\n";
+                std::cout << "    CHECKPOINT\n";
+                std::cout << "    BACKUP TO 'directory'\n";
                 std::cout << "    EXIT or QUIT\n";
                 
                 std::cout << "\nFor more details on a specific command, type 'HELP command'\n";
@@ -104,7 +141,11 @@ int main() {
                     std::cout << "               REFERENCES otherTable (otherColumn1, ...)],\n";
                     std::cout << "            [CONSTRAINT constraintName UNIQUE (column1, ...)],\n";
                     std::cout << "            [CONSTRAINT constraintName CHECK (condition)]\n";
-                    std::cout << "          )\n\n";
+                    std::cout << "          ) [WITH (storage = row | column | clustered)]\n\n";
+                    std::cout << "  Column storage keeps typed arrays per column, for tables\n";
+                    std::cout << "  that are mostly scanned, filtered and aggregated.\n";
+                    std::cout << "  Clustered storage keeps rows ordered by the PRIMARY KEY, for\n";
+                    std::cout << "  key range scans and ORDER BY on the key.\n\n";
                     std::cout << "  Supported data types: CHAR(n), VARCHAR(n), TEXT, INT, SMALLINT,\n";
                     std::cout << "                       NUMERIC(p,d), REAL, DOUBLE PRECISION,\n";
                     std::cout << "                       FLOAT(n), DATE, TIME, TIMESTAMP,\n";
@@ -314,7 +355,8 @@ int main() {
                     
                     // Execute the command
                     if (qType == "CREATE") {
-                        db.createTable(query.tableName, query.columns, query.constraints);
+                        db.createTable(query.tableName, query.columns, query.constraints, query.storageMode,
+                                       query.partitionKind, query.partitionColumn, query.partitions);
                     } else if (qType == "INSERT") {
                         db.insertRecord(query.tableName, query.values);
                     } else if (qType == "SELECT") {
@@ -354,6 +396,23 @@ int main() {
                             if (!query.constraints.empty()) {
                                 db.alterTableDropConstraint(query.tableName, query.constraints.front().name);
                             }
+                        } else if (query.alterAction == "ADD BLOOM FILTER" ||
+                                   query.alterAction == "DROP BLOOM FILTER") {
+                            std::vector<std::string> columnNames;
+                            for (const auto& column : query.columns) {
+                                columnNames.push_back(column.first);
+                            }
+                            if (query.alterAction == "ADD BLOOM FILTER") {
+                                db.alterTableAddBloomFilter(query.tableName, columnNames);
+                            } else {
+                                db.alterTableDropBloomFilter(query.tableName, columnNames);
+                            }
+                        } else if (query.alterAction == "ADD PARTITION") {
+                            db.alterTableAddPartition(query.tableName, query.partitionKind, query.partitions.front());
+                        } else if (query.alterAction == "DROP PARTITION") {
+                            db.alterTableDropPartition(query.tableName, query.partitions.front().name);
+                        } else if (query.alterAction == "SET COLD") {
+                            db.alterTableSetColdPolicy(query.tableName, query.coldPolicy, query.coldAfter);
                         }
                     } else if (qType == "DESCRIBE") {
                         db.describeTable(query.tableName);
@@ -374,6 +433,8 @@ int main() {
                         } else {
                             db.showTables();
                         }
+                    } else if (qType == "SHOWSTATS") {
+                        db.showTableStats(query.tableName);
                     } else if (qType == "TRUNCATE") {
                         db.truncateTable(query.tableName);
                     } else if (qType == "CREATEINDEX") {
@@ -398,6 +459,12 @@ int main() {
                         db.mergeRecords(query.tableName, query.mergeCommand);
                     } else if (qType == "REPLACE") {
                         db.replaceInto(query.tableName, query.values);
+                    } else if (qType == "SET") {
+                        db.applySetting(query.settingName, query.settingValue);
+                    } else if (qType == "CHECKPOINT") {
+                        db.checkpoint();
+                    } else if (qType == "BACKUP") {
+                        db.backup(query.backupDirectory);
                     } else {
                         std::cout << "Unsupported command: " << qType << std::endl;
                     }